@@ -0,0 +1,111 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DIMSUM_BENCHMARK_UTIL_H_
+#define DIMSUM_BENCHMARK_UTIL_H_
+
+// Loops shared by the element-wise operation benchmarks. Each one applies a
+// function to kNumValues elements of one or more input arrays and stores the
+// results, either one scalar at a time, one GCC vector extension at a time,
+// or one NativeSimd at a time. Comparing the three shows what a Simd
+// operation gains over the scalar code and over the generic lowering.
+
+#include <cstring>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "dimsum.h"
+
+namespace dimsum {
+namespace bench {
+
+// Fits in L1 for all types. Not a power of 2, so that the inputs and the
+// output are not 4K apart, which would make loads wait on unrelated stores.
+constexpr size_t kNumValues = 33 << 5;
+
+// The GCC vector extension type with the size of NativeSimd<T>.
+template <typename T>
+using NativeVec = typename detail::GccVecTraits<T, sizeof(NativeSimd<T>)>::type;
+
+// Returns kNumValues values spread over the whole range of T. Different seeds
+// give different values.
+template <typename T>
+std::vector<T> MakeValues(uint64 seed = 0) {
+  std::vector<T> values(kNumValues);
+  for (size_t i = 0; i < values.size(); i++) {
+    values[i] = static_cast<T>((i + seed) * 0x9e3779b97f4a7c15ull);
+  }
+  return values;
+}
+
+// out[i] = fn(input[i], inputs[i]...) for each scalar i.
+template <typename T, typename Fn, typename... Inputs>
+void ScalarLoop(benchmark::State& state, Fn fn, const std::vector<T>& input,
+                const Inputs&... inputs) {
+  std::vector<T> out(kNumValues);
+  for (auto _ : state) {
+    for (size_t i = 0; i < kNumValues; i++) {
+      out[i] = fn(input[i], inputs[i]...);
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+
+template <typename Vec, typename T>
+Vec LoadVec(const T* data) {
+  Vec vec;
+  memcpy(&vec, data, sizeof(Vec));
+  return vec;
+}
+
+// The same, with fn taking and returning NativeVec<T>.
+template <typename T, typename Fn, typename... Inputs>
+void VectorExtensionLoop(benchmark::State& state, Fn fn,
+                         const std::vector<T>& input,
+                         const Inputs&... inputs) {
+  using Vec = NativeVec<T>;
+  std::vector<T> out(kNumValues);
+  constexpr size_t kStep = NativeSimd<T>::size();
+  for (auto _ : state) {
+    for (size_t i = 0; i < kNumValues; i += kStep) {
+      Vec out_vec = fn(LoadVec<Vec>(&input[i]), LoadVec<Vec>(&inputs[i])...);
+      memcpy(&out[i], &out_vec, sizeof(Vec));
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+
+// The same, with fn taking and returning NativeSimd<T>.
+template <typename T, typename Fn, typename... Inputs>
+void SimdLoop(benchmark::State& state, Fn fn, const std::vector<T>& input,
+              const Inputs&... inputs) {
+  std::vector<T> out(kNumValues);
+  constexpr size_t kStep = NativeSimd<T>::size();
+  for (auto _ : state) {
+    for (size_t i = 0; i < kNumValues; i += kStep) {
+      fn(NativeSimd<T>(&input[i], flags::element_aligned),
+         NativeSimd<T>(&inputs[i], flags::element_aligned)...)
+          .memstore(&out[i], flags::element_aligned);
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumValues);
+}
+
+}  // namespace bench
+}  // namespace dimsum
+
+#endif  // DIMSUM_BENCHMARK_UTIL_H_
@@ -30,16 +30,18 @@
     using ExternalType = EXTERNAL_TYPE;                            \
   };
 
-#define SIMD_NON_NATIVE_SPECIALIZATION(STORAGE, NUM_BYTES)      \
-  SIMD_SPECIALIZATION(int8, STORAGE, NUM_BYTES, InternalType)   \
-  SIMD_SPECIALIZATION(int16, STORAGE, NUM_BYTES, InternalType)  \
-  SIMD_SPECIALIZATION(int32, STORAGE, NUM_BYTES, InternalType)  \
-  SIMD_SPECIALIZATION(int64, STORAGE, NUM_BYTES, InternalType)  \
-  SIMD_SPECIALIZATION(uint8, STORAGE, NUM_BYTES, InternalType)  \
-  SIMD_SPECIALIZATION(uint16, STORAGE, NUM_BYTES, InternalType) \
-  SIMD_SPECIALIZATION(uint32, STORAGE, NUM_BYTES, InternalType) \
-  SIMD_SPECIALIZATION(uint64, STORAGE, NUM_BYTES, InternalType) \
-  SIMD_SPECIALIZATION(float, STORAGE, NUM_BYTES, InternalType)  \
+#define SIMD_NON_NATIVE_SPECIALIZATION(STORAGE, NUM_BYTES)        \
+  SIMD_SPECIALIZATION(int8, STORAGE, NUM_BYTES, InternalType)     \
+  SIMD_SPECIALIZATION(int16, STORAGE, NUM_BYTES, InternalType)    \
+  SIMD_SPECIALIZATION(int32, STORAGE, NUM_BYTES, InternalType)    \
+  SIMD_SPECIALIZATION(int64, STORAGE, NUM_BYTES, InternalType)    \
+  SIMD_SPECIALIZATION(uint8, STORAGE, NUM_BYTES, InternalType)    \
+  SIMD_SPECIALIZATION(uint16, STORAGE, NUM_BYTES, InternalType)   \
+  SIMD_SPECIALIZATION(uint32, STORAGE, NUM_BYTES, InternalType)   \
+  SIMD_SPECIALIZATION(uint64, STORAGE, NUM_BYTES, InternalType)   \
+  SIMD_SPECIALIZATION(float16, STORAGE, NUM_BYTES, InternalType)  \
+  SIMD_SPECIALIZATION(bfloat16, STORAGE, NUM_BYTES, InternalType) \
+  SIMD_SPECIALIZATION(float, STORAGE, NUM_BYTES, InternalType)    \
   SIMD_SPECIALIZATION(double, STORAGE, NUM_BYTES, InternalType)
 
 #define SIMD_NON_NATIVE_SPECIALIZATION_ALL_SMALL_BYTES(STORAGE) \
@@ -49,11 +51,15 @@
   SIMD_SPECIALIZATION(uint8, STORAGE, 4, InternalType)          \
   SIMD_SPECIALIZATION(uint16, STORAGE, 4, InternalType)         \
   SIMD_SPECIALIZATION(uint32, STORAGE, 4, InternalType)         \
+  SIMD_SPECIALIZATION(float16, STORAGE, 4, InternalType)        \
+  SIMD_SPECIALIZATION(bfloat16, STORAGE, 4, InternalType)       \
   SIMD_SPECIALIZATION(float, STORAGE, 4, InternalType)          \
   SIMD_SPECIALIZATION(int8, STORAGE, 2, InternalType)           \
   SIMD_SPECIALIZATION(int16, STORAGE, 2, InternalType)          \
   SIMD_SPECIALIZATION(uint8, STORAGE, 2, InternalType)          \
   SIMD_SPECIALIZATION(uint16, STORAGE, 2, InternalType)         \
+  SIMD_SPECIALIZATION(float16, STORAGE, 2, InternalType)        \
+  SIMD_SPECIALIZATION(bfloat16, STORAGE, 2, InternalType)       \
   SIMD_SPECIALIZATION(int8, STORAGE, 1, InternalType)           \
   SIMD_SPECIALIZATION(uint8, STORAGE, 1, InternalType)
 
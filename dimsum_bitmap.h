@@ -0,0 +1,210 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_DIMSUM_BITMAP_H_
+#define DIMSUM_DIMSUM_BITMAP_H_
+
+#include "dimsum.h"
+
+// Operations on bitmaps stored as arrays of uint64 words.
+//
+// bitmap_and, bitmap_or, bitmap_xor and bitmap_andnot combine two bitmaps
+// word by word. popcount counts the bits of a bitmap, and and_count,
+// or_count, xor_count and andnot_count count the bits of a combination
+// without storing it, e.g. the size of the intersection of two sets.
+//
+// Counting uses a Harley-Seal carry-save adder tree over NativeSimd<uint64>:
+// 16 vectors are reduced with bitwise operations to one vector of 16s plus
+// vectors of 8s, 4s, 2s and 1s that carry over to the next 16, so the
+// comparatively expensive per-lane popcount runs once per 16 vectors.
+
+namespace dimsum {
+namespace detail {
+
+// A carry-save adder: adds the bits of a, b and c at each position, leaving
+// the sum bit in *low and the carry bit in *high.
+template <typename SimdType>
+void CarrySaveAdd(SimdType a, SimdType b, SimdType c, SimdType* high,
+                  SimdType* low) {
+  SimdType u = a ^ b;
+  *high = (a & b) | (u & c);
+  *low = u ^ c;
+}
+
+// Returns the number of one bits in load(0), ..., load(num_vectors - 1),
+// where load(i) returns a NativeSimd<uint64>.
+template <typename Load>
+uint64 HarleySealPopcount(size_t num_vectors, Load load) {
+  using SimdType = NativeSimd<uint64>;
+  SimdType total(0);
+  SimdType ones(0), twos(0), fours(0), eights(0);
+  SimdType twos_a, twos_b, fours_a, fours_b, eights_a, eights_b, sixteens;
+  size_t i = 0;
+  for (; i + 16 <= num_vectors; i += 16) {
+    CarrySaveAdd(ones, load(i), load(i + 1), &twos_a, &ones);
+    CarrySaveAdd(ones, load(i + 2), load(i + 3), &twos_b, &ones);
+    CarrySaveAdd(twos, twos_a, twos_b, &fours_a, &twos);
+    CarrySaveAdd(ones, load(i + 4), load(i + 5), &twos_a, &ones);
+    CarrySaveAdd(ones, load(i + 6), load(i + 7), &twos_b, &ones);
+    CarrySaveAdd(twos, twos_a, twos_b, &fours_b, &twos);
+    CarrySaveAdd(fours, fours_a, fours_b, &eights_a, &fours);
+    CarrySaveAdd(ones, load(i + 8), load(i + 9), &twos_a, &ones);
+    CarrySaveAdd(ones, load(i + 10), load(i + 11), &twos_b, &ones);
+    CarrySaveAdd(twos, twos_a, twos_b, &fours_a, &twos);
+    CarrySaveAdd(ones, load(i + 12), load(i + 13), &twos_a, &ones);
+    CarrySaveAdd(ones, load(i + 14), load(i + 15), &twos_b, &ones);
+    CarrySaveAdd(twos, twos_a, twos_b, &fours_b, &twos);
+    CarrySaveAdd(fours, fours_a, fours_b, &eights_b, &fours);
+    CarrySaveAdd(eights, eights_a, eights_b, &sixteens, &eights);
+    total += popcount(sixteens);
+  }
+  total = shl(total, 4) + shl(popcount(eights), 3) + shl(popcount(fours), 2) +
+          shl(popcount(twos), 1) + popcount(ones);
+  for (; i < num_vectors; i++) {
+    total += popcount(load(i));
+  }
+  return reduce_add(total)[0];
+}
+
+// Returns the number of one bits in op(lhs[i], rhs[i]) for i in
+// [0, size), where op is applied to both NativeSimd<uint64> and uint64.
+template <typename Op>
+uint64 CountBinary(const uint64* lhs, const uint64* rhs, size_t size, Op op) {
+  using SimdType = NativeSimd<uint64>;
+  constexpr size_t kWords = SimdType::size();
+  size_t num_vectors = size / kWords;
+  uint64 count = HarleySealPopcount(num_vectors, [=](size_t i) {
+    return op(SimdType(lhs + i * kWords, flags::element_aligned),
+              SimdType(rhs + i * kWords, flags::element_aligned));
+  });
+  for (size_t i = num_vectors * kWords; i < size; i++) {
+    count += __builtin_popcountll(op(lhs[i], rhs[i]));
+  }
+  return count;
+}
+
+// Stores op(lhs[i], rhs[i]) to out[i] for i in [0, size). out may alias lhs
+// or rhs.
+template <typename Op>
+void TransformBinary(const uint64* lhs, const uint64* rhs, size_t size,
+                     uint64* out, Op op) {
+  using SimdType = NativeSimd<uint64>;
+  constexpr size_t kWords = SimdType::size();
+  size_t i = 0;
+  for (; i + kWords <= size; i += kWords) {
+    op(SimdType(lhs + i, flags::element_aligned),
+       SimdType(rhs + i, flags::element_aligned))
+        .memstore(out + i, flags::element_aligned);
+  }
+  for (; i < size; i++) {
+    out[i] = op(lhs[i], rhs[i]);
+  }
+}
+
+struct AndOp {
+  template <typename T>
+  T operator()(T lhs, T rhs) const {
+    return lhs & rhs;
+  }
+};
+
+struct OrOp {
+  template <typename T>
+  T operator()(T lhs, T rhs) const {
+    return lhs | rhs;
+  }
+};
+
+struct XorOp {
+  template <typename T>
+  T operator()(T lhs, T rhs) const {
+    return lhs ^ rhs;
+  }
+};
+
+struct AndNotOp {
+  template <typename T>
+  T operator()(T lhs, T rhs) const {
+    return lhs & ~rhs;
+  }
+};
+
+}  // namespace detail
+
+// Returns the number of one bits in data[0 .. size-1].
+inline uint64 popcount(const uint64* data, size_t size) {
+  using SimdType = NativeSimd<uint64>;
+  constexpr size_t kWords = SimdType::size();
+  size_t num_vectors = size / kWords;
+  uint64 count = detail::HarleySealPopcount(num_vectors, [=](size_t i) {
+    return SimdType(data + i * kWords, flags::element_aligned);
+  });
+  for (size_t i = num_vectors * kWords; i < size; i++) {
+    count += __builtin_popcountll(data[i]);
+  }
+  return count;
+}
+
+// out[i] = lhs[i] & rhs[i] for i in [0, size). out may alias lhs or rhs, as
+// may the outputs of the functions below.
+inline void bitmap_and(const uint64* lhs, const uint64* rhs, size_t size,
+                       uint64* out) {
+  detail::TransformBinary(lhs, rhs, size, out, detail::AndOp());
+}
+
+// out[i] = lhs[i] | rhs[i] for i in [0, size).
+inline void bitmap_or(const uint64* lhs, const uint64* rhs, size_t size,
+                      uint64* out) {
+  detail::TransformBinary(lhs, rhs, size, out, detail::OrOp());
+}
+
+// out[i] = lhs[i] ^ rhs[i] for i in [0, size).
+inline void bitmap_xor(const uint64* lhs, const uint64* rhs, size_t size,
+                       uint64* out) {
+  detail::TransformBinary(lhs, rhs, size, out, detail::XorOp());
+}
+
+// out[i] = lhs[i] & ~rhs[i] for i in [0, size), i.e. the set difference.
+inline void bitmap_andnot(const uint64* lhs, const uint64* rhs, size_t size,
+                          uint64* out) {
+  detail::TransformBinary(lhs, rhs, size, out, detail::AndNotOp());
+}
+
+// Returns the number of one bits in lhs[i] & rhs[i] for i in [0, size),
+// without storing the intersection.
+inline uint64 and_count(const uint64* lhs, const uint64* rhs, size_t size) {
+  return detail::CountBinary(lhs, rhs, size, detail::AndOp());
+}
+
+// Returns the number of one bits in lhs[i] | rhs[i] for i in [0, size).
+inline uint64 or_count(const uint64* lhs, const uint64* rhs, size_t size) {
+  return detail::CountBinary(lhs, rhs, size, detail::OrOp());
+}
+
+// Returns the number of one bits in lhs[i] ^ rhs[i] for i in [0, size).
+inline uint64 xor_count(const uint64* lhs, const uint64* rhs, size_t size) {
+  return detail::CountBinary(lhs, rhs, size, detail::XorOp());
+}
+
+// Returns the number of one bits in lhs[i] & ~rhs[i] for i in [0, size).
+inline uint64 andnot_count(const uint64* lhs, const uint64* rhs,
+                           size_t size) {
+  return detail::CountBinary(lhs, rhs, size, detail::AndNotOp());
+}
+
+}  // namespace dimsum
+
+#endif  // DIMSUM_DIMSUM_BITMAP_H_
@@ -0,0 +1,94 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "dimsum_bitmap.h"
+
+namespace dimsum {
+namespace {
+
+std::vector<uint64> MakeBitmap(size_t size) {
+  std::mt19937_64 rng(42);
+  std::vector<uint64> words(size);
+  for (uint64& word : words) word = rng();
+  return words;
+}
+
+void BM_PopcountScalar(benchmark::State& state) {
+  auto words = MakeBitmap(state.range(0));
+  for (auto _ : state) {
+    uint64 count = 0;
+    for (uint64 word : words) {
+      count += __builtin_popcountll(word);
+    }
+    benchmark::DoNotOptimize(count);
+  }
+  state.SetBytesProcessed(state.iterations() * words.size() * sizeof(uint64));
+}
+BENCHMARK(BM_PopcountScalar)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 20);
+
+void BM_Popcount(benchmark::State& state) {
+  auto words = MakeBitmap(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(popcount(words.data(), words.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * words.size() * sizeof(uint64));
+}
+BENCHMARK(BM_Popcount)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 20);
+
+void BM_AndCountScalar(benchmark::State& state) {
+  auto lhs = MakeBitmap(state.range(0));
+  auto rhs = MakeBitmap(state.range(0) + 1);
+  for (auto _ : state) {
+    uint64 count = 0;
+    for (size_t i = 0; i < lhs.size(); i++) {
+      count += __builtin_popcountll(lhs[i] & rhs[i]);
+    }
+    benchmark::DoNotOptimize(count);
+  }
+  state.SetBytesProcessed(state.iterations() * 2 * lhs.size() *
+                          sizeof(uint64));
+}
+BENCHMARK(BM_AndCountScalar)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 20);
+
+void BM_AndCount(benchmark::State& state) {
+  auto lhs = MakeBitmap(state.range(0));
+  auto rhs = MakeBitmap(state.range(0) + 1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(and_count(lhs.data(), rhs.data(), lhs.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * 2 * lhs.size() *
+                          sizeof(uint64));
+}
+BENCHMARK(BM_AndCount)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 20);
+
+void BM_BitmapAnd(benchmark::State& state) {
+  auto lhs = MakeBitmap(state.range(0));
+  auto rhs = MakeBitmap(state.range(0) + 1);
+  std::vector<uint64> out(lhs.size());
+  for (auto _ : state) {
+    bitmap_and(lhs.data(), rhs.data(), lhs.size(), out.data());
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * 3 * lhs.size() *
+                          sizeof(uint64));
+}
+BENCHMARK(BM_BitmapAnd)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 20);
+
+}  // namespace
+}  // namespace dimsum
@@ -0,0 +1,107 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dimsum_bitmap.h"
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+uint64 ScalarPopcount(const std::vector<uint64>& words, size_t size) {
+  uint64 count = 0;
+  for (size_t i = 0; i < size; i++) {
+    count += __builtin_popcountll(words[i]);
+  }
+  return count;
+}
+
+TEST(DimsumBitmapTest, Popcount) {
+  std::mt19937_64 rng(42);
+  std::vector<uint64> words(10000);
+  for (uint64& word : words) word = rng();
+  for (size_t size : {0, 1, 3, 4, 7, 8, 9, 100, 125, 126, 1000, 10000}) {
+    EXPECT_EQ(ScalarPopcount(words, size), popcount(words.data(), size))
+        << size;
+  }
+}
+
+TEST(DimsumBitmapTest, PopcountAllOnes) {
+  // Every carry-save adder level carries on every block.
+  std::vector<uint64> words(5000, ~uint64{0});
+  EXPECT_EQ(64 * words.size(), popcount(words.data(), words.size()));
+}
+
+const size_t kSizes[] = {0, 1, 3, 4, 7, 8, 9, 63, 64, 65, 100, 1000, 10000};
+
+TEST(DimsumBitmapTest, SetOperations) {
+  std::mt19937_64 rng(7);
+  std::vector<uint64> lhs(10000), rhs(10000);
+  for (uint64& word : lhs) word = rng();
+  for (uint64& word : rhs) word = rng() & rng();
+  for (size_t size : kSizes) {
+    std::vector<uint64> out_and(size), out_or(size), out_xor(size),
+        out_andnot(size);
+    bitmap_and(lhs.data(), rhs.data(), size, out_and.data());
+    bitmap_or(lhs.data(), rhs.data(), size, out_or.data());
+    bitmap_xor(lhs.data(), rhs.data(), size, out_xor.data());
+    bitmap_andnot(lhs.data(), rhs.data(), size, out_andnot.data());
+    for (size_t i = 0; i < size; i++) {
+      EXPECT_EQ(lhs[i] & rhs[i], out_and[i]) << size << " " << i;
+      EXPECT_EQ(lhs[i] | rhs[i], out_or[i]) << size << " " << i;
+      EXPECT_EQ(lhs[i] ^ rhs[i], out_xor[i]) << size << " " << i;
+      EXPECT_EQ(lhs[i] & ~rhs[i], out_andnot[i]) << size << " " << i;
+    }
+  }
+}
+
+TEST(DimsumBitmapTest, SetOperationsInPlace) {
+  std::vector<uint64> lhs(37), rhs(37);
+  for (size_t i = 0; i < lhs.size(); i++) {
+    lhs[i] = i * 0x9e3779b97f4a7c15ull;
+    rhs[i] = ~lhs[i] ^ i;
+  }
+  std::vector<uint64> expected(lhs.size());
+  for (size_t i = 0; i < lhs.size(); i++) expected[i] = lhs[i] & ~rhs[i];
+  bitmap_andnot(lhs.data(), rhs.data(), lhs.size(), lhs.data());
+  EXPECT_EQ(expected, lhs);
+}
+
+TEST(DimsumBitmapTest, FusedCounts) {
+  std::mt19937_64 rng(11);
+  std::vector<uint64> lhs(10000), rhs(10000);
+  for (uint64& word : lhs) word = rng();
+  for (uint64& word : rhs) word = rng() | rng();
+  for (size_t size : kSizes) {
+    uint64 expected_and = 0, expected_or = 0, expected_xor = 0,
+           expected_andnot = 0;
+    for (size_t i = 0; i < size; i++) {
+      expected_and += __builtin_popcountll(lhs[i] & rhs[i]);
+      expected_or += __builtin_popcountll(lhs[i] | rhs[i]);
+      expected_xor += __builtin_popcountll(lhs[i] ^ rhs[i]);
+      expected_andnot += __builtin_popcountll(lhs[i] & ~rhs[i]);
+    }
+    EXPECT_EQ(expected_and, and_count(lhs.data(), rhs.data(), size)) << size;
+    EXPECT_EQ(expected_or, or_count(lhs.data(), rhs.data(), size)) << size;
+    EXPECT_EQ(expected_xor, xor_count(lhs.data(), rhs.data(), size)) << size;
+    EXPECT_EQ(expected_andnot, andnot_count(lhs.data(), rhs.data(), size))
+        << size;
+  }
+}
+
+}  // namespace
+}  // namespace dimsum
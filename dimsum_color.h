@@ -0,0 +1,512 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_DIMSUM_COLOR_H_
+#define DIMSUM_DIMSUM_COLOR_H_
+
+#include <algorithm>
+#include <array>
+
+#include "dimsum.h"
+#include "dimsum_x86.h"
+
+// Pixel format conversions for 8-bit images.
+//
+// YUV is BT.601 with limited range (Y in [16, 235], U and V in [16, 240]),
+// subsampled 2x2 as in I420 and NV12. The conversions are fixed point and the
+// results are defined exactly by the formulas below, which are also what the
+// scalar remainders of each row compute:
+//
+//   Y = ((33 * R + 64 * G + 13 * B + 64) >> 7) + 16
+//   U = ((-38 * R - 74 * G + 112 * B + 128) >> 8) + 128
+//   V = ((112 * R - 94 * G - 18 * B + 128) >> 8) + 128
+//
+// where U and V are computed from the rounded average (sum + 2) >> 2 of each
+// channel over a 2x2 block. Blocks on an odd right or bottom edge reuse the
+// last column or row. In the other direction, with C = Y - 16, D = U - 128,
+// E = V - 128 and each chroma sample applied to its 2x2 block,
+//
+//   R = clamp((298 * C + 409 * E + 128) >> 8)
+//   G = clamp((298 * C - 100 * D - 208 * E + 128) >> 8)
+//   B = clamp((298 * C + 516 * D + 128) >> 8)
+//
+// and gray is the full range luma (38 * R + 75 * G + 15 * B + 64) >> 7.
+//
+// The weighted sums of 8-bit channels are x86::maddubs of interleaved pairs
+// of channels with pairs of 7-bit coefficients, and the ones that need more
+// than 16 bits are mul_sum of pairs of int16. Results are narrowed with
+// pack_saturated and packu_saturated. Images are addressed by rows and
+// columns of pixels, with strides in bytes.
+
+namespace dimsum {
+
+// The order of the channels of packed 3-byte pixels.
+enum class RgbOrder {
+  kRgb,
+  kBgr,
+};
+
+namespace detail {
+
+using ColorSimd = NativeSimd<uint8>;
+using ColorAbi = ColorSimd::abi_type;
+using ColorInt16 = Simd<int16, ColorAbi>;
+using ColorInt32 = Simd<int32, ColorAbi>;
+
+// The index in memory of channel c (0 for red, 2 for blue) of a pixel.
+template <RgbOrder kOrder>
+constexpr size_t ChannelIndex(size_t c) {
+  return kOrder == RgbOrder::kRgb ? c : 2 - c;
+}
+
+inline uint8 ClampToUint8(int32 value) {
+  return static_cast<uint8>(std::min(std::max(value, 0), 255));
+}
+
+inline uint8 RgbToY(int32 r, int32 g, int32 b) {
+  return static_cast<uint8>(((33 * r + 64 * g + 13 * b + 64) >> 7) + 16);
+}
+
+inline uint8 RgbToU(int32 r, int32 g, int32 b) {
+  return static_cast<uint8>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+}
+
+inline uint8 RgbToV(int32 r, int32 g, int32 b) {
+  return static_cast<uint8>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+
+// Writes the pixel with luma y and chroma u and v to rgb[0 .. 2].
+template <RgbOrder kOrder>
+void YuvToRgb(int32 y, int32 u, int32 v, uint8* rgb) {
+  const int32 c = y - 16, d = u - 128, e = v - 128;
+  rgb[ChannelIndex<kOrder>(0)] = ClampToUint8((298 * c + 409 * e + 128) >> 8);
+  rgb[ChannelIndex<kOrder>(1)] =
+      ClampToUint8((298 * c - 100 * d - 208 * e + 128) >> 8);
+  rgb[ChannelIndex<kOrder>(2)] = ClampToUint8((298 * c + 516 * d + 128) >> 8);
+}
+
+// Returns the int8 pair {lo, hi} in every pair of lanes.
+template <typename Abi>
+Simd<int8, Abi> Int8Pairs(int8 lo, int8 hi) {
+  return bit_cast<int8>(Simd<uint16, Abi>(static_cast<uint16>(
+      static_cast<uint8>(lo) | static_cast<uint8>(hi) << 8)));
+}
+
+// Returns the int16 pair {lo, hi} in every pair of lanes.
+template <typename Abi>
+Simd<int16, Abi> Int16Pairs(int16 lo, int16 hi) {
+  return bit_cast<int16>(Simd<uint32, Abi>(
+      static_cast<uint16>(lo) | static_cast<uint32>(static_cast<uint16>(hi))
+                                    << 16));
+}
+
+// Zero-extends the low and the high half of the lanes to 16 bits. Zipping
+// with zeros is a single unpack on x86, where a widening static_simd_cast is
+// not.
+inline std::array<ColorInt16, 2> Widen(ColorSimd simd) {
+  const ColorSimd zero(0);
+  return {{bit_cast<int16>(zip_lo(simd, zero)),
+           bit_cast<int16>(zip_hi(simd, zero))}};
+}
+
+// Zero-extends the four quarters of the lanes to 32 bits.
+inline std::array<ColorInt32, 4> WidenToInt32(ColorSimd simd) {
+  const ColorInt16 zero(0);
+  auto halves = Widen(simd);
+  return {{bit_cast<int32>(zip_lo(halves[0], zero)),
+           bit_cast<int32>(zip_hi(halves[0], zero)),
+           bit_cast<int32>(zip_lo(halves[1], zero)),
+           bit_cast<int32>(zip_hi(halves[1], zero))}};
+}
+
+// Returns r * cr + g * cg + b * cb + bias of the pixels in the low and the
+// high half of the channels. The pairs of products are summed with int16
+// saturation, which the callers' coefficients never reach.
+inline std::array<ColorInt16, 2> WeightedSum(
+    const std::array<ColorSimd, 3>& rgb, int8 cr, int8 cg, int8 cb,
+    int8 bias) {
+  const auto rg_weights = Int8Pairs<ColorAbi>(cr, cg);
+  const auto b1_weights = Int8Pairs<ColorAbi>(cb, bias);
+  const ColorSimd one(1);
+  return {{x86::maddubs(zip_lo(rgb[0], rgb[1]), rg_weights) +
+               x86::maddubs(zip_lo(rgb[2], one), b1_weights),
+           x86::maddubs(zip_hi(rgb[0], rgb[1]), rg_weights) +
+               x86::maddubs(zip_hi(rgb[2], one), b1_weights)}};
+}
+
+// Loads ColorSimd::size() pixels and returns their red, green and blue
+// channels.
+template <RgbOrder kOrder>
+std::array<ColorSimd, 3> LoadRgb(const uint8* rgb) {
+  auto channels = load_interleaved<3, ColorSimd>(rgb);
+  return {{channels[ChannelIndex<kOrder>(0)], channels[1],
+           channels[ChannelIndex<kOrder>(2)]}};
+}
+
+template <RgbOrder kOrder>
+void StoreRgb(uint8* rgb, ColorSimd r, ColorSimd g, ColorSimd b) {
+  std::array<ColorSimd, 3> channels;
+  channels[ChannelIndex<kOrder>(0)] = r;
+  channels[1] = g;
+  channels[ChannelIndex<kOrder>(2)] = b;
+  store_interleaved(rgb, channels);
+}
+
+inline ColorSimd RgbToYSimd(const std::array<ColorSimd, 3>& rgb) {
+  auto sums = WeightedSum(rgb, 33, 64, 13, 64);
+  return packu_saturated(shr(sums[0], 7), shr(sums[1], 7)) + ColorSimd(16);
+}
+
+// The chroma planes of I420: one byte per 2x2 block in each of u and v.
+template <typename T>
+struct PlanarChroma {
+  T* u;
+  size_t u_stride;
+  T* v;
+  size_t v_stride;
+
+  void Store(size_t row, size_t col, ColorSimd us, ColorSimd vs) const {
+    us.memstore(u + row * u_stride + col, flags::element_aligned);
+    vs.memstore(v + row * v_stride + col, flags::element_aligned);
+  }
+
+  template <typename SimdType>
+  std::array<SimdType, 2> Load(size_t row, size_t col) const {
+    return {{SimdType(u + row * u_stride + col, flags::element_aligned),
+             SimdType(v + row * v_stride + col, flags::element_aligned)}};
+  }
+
+  void StoreScalar(size_t row, size_t col, uint8 us, uint8 vs) const {
+    u[row * u_stride + col] = us;
+    v[row * v_stride + col] = vs;
+  }
+
+  std::array<uint8, 2> LoadScalar(size_t row, size_t col) const {
+    return {{u[row * u_stride + col], v[row * v_stride + col]}};
+  }
+};
+
+// The chroma plane of NV12: interleaved u and v bytes per 2x2 block.
+template <typename T>
+struct InterleavedChroma {
+  T* uv;
+  size_t uv_stride;
+
+  void Store(size_t row, size_t col, ColorSimd us, ColorSimd vs) const {
+    store_interleaved(uv + row * uv_stride + 2 * col,
+                      std::array<ColorSimd, 2>{{us, vs}});
+  }
+
+  template <typename SimdType>
+  std::array<SimdType, 2> Load(size_t row, size_t col) const {
+    return load_interleaved<2, SimdType>(uv + row * uv_stride + 2 * col);
+  }
+
+  void StoreScalar(size_t row, size_t col, uint8 us, uint8 vs) const {
+    uv[row * uv_stride + 2 * col] = us;
+    uv[row * uv_stride + 2 * col + 1] = vs;
+  }
+
+  std::array<uint8, 2> LoadScalar(size_t row, size_t col) const {
+    return {{uv[row * uv_stride + 2 * col], uv[row * uv_stride + 2 * col + 1]}};
+  }
+};
+
+// Converts the pixel rows rgb0 and rgb1, which may be the same row, to the
+// luma rows y0 and y1 and to chroma row `chroma_row`.
+template <RgbOrder kOrder, typename Chroma>
+void RgbToYuvRows(size_t cols, const uint8* rgb0, const uint8* rgb1,
+                  uint8* y0, uint8* y1, const Chroma& chroma,
+                  size_t chroma_row) {
+  constexpr size_t kLanes = ColorSimd::size();
+  const auto ones = Int8Pairs<ColorAbi>(1, 1);
+  const ColorInt16 rounding(128);
+  size_t x = 0;
+  // Each step converts 2 * kLanes pixels of both rows, which have kLanes
+  // chroma samples.
+  for (; x + 2 * kLanes <= cols; x += 2 * kLanes) {
+    std::array<ColorInt16, 2> us, vs;
+    for (size_t half = 0; half < 2; half++) {
+      const size_t col = x + half * kLanes;
+      auto top = LoadRgb<kOrder>(rgb0 + 3 * col);
+      auto bottom = LoadRgb<kOrder>(rgb1 + 3 * col);
+      RgbToYSimd(top).memstore(y0 + col, flags::element_aligned);
+      RgbToYSimd(bottom).memstore(y1 + col, flags::element_aligned);
+      // maddubs by 1 adds horizontal pairs.
+      std::array<ColorInt16, 3> avg;
+      for (size_t c = 0; c < 3; c++) {
+        avg[c] = shr(x86::maddubs(top[c], ones) +
+                         x86::maddubs(bottom[c], ones) + ColorInt16(2),
+                     2);
+      }
+      us[half] = shr(avg[0] * ColorInt16(-38) + avg[1] * ColorInt16(-74) +
+                         avg[2] * ColorInt16(112) + rounding,
+                     8) +
+                 rounding;
+      vs[half] = shr(avg[0] * ColorInt16(112) + avg[1] * ColorInt16(-94) +
+                         avg[2] * ColorInt16(-18) + rounding,
+                     8) +
+                 rounding;
+    }
+    chroma.Store(chroma_row, x / 2, packu_saturated(us[0], us[1]),
+                 packu_saturated(vs[0], vs[1]));
+  }
+  for (; x < cols; x += 2) {
+    const size_t x1 = std::min(x + 1, cols - 1);
+    int32 sums[3];
+    for (size_t c = 0; c < 3; c++) {
+      const size_t i = ChannelIndex<kOrder>(c);
+      sums[c] = rgb0[3 * x + i] + rgb0[3 * x1 + i] + rgb1[3 * x + i] +
+                rgb1[3 * x1 + i] + 2;
+    }
+    for (size_t col : {x, x1}) {
+      y0[col] = RgbToY(rgb0[3 * col + ChannelIndex<kOrder>(0)],
+                       rgb0[3 * col + 1],
+                       rgb0[3 * col + ChannelIndex<kOrder>(2)]);
+      y1[col] = RgbToY(rgb1[3 * col + ChannelIndex<kOrder>(0)],
+                       rgb1[3 * col + 1],
+                       rgb1[3 * col + ChannelIndex<kOrder>(2)]);
+    }
+    chroma.StoreScalar(chroma_row, x / 2,
+                       RgbToU(sums[0] >> 2, sums[1] >> 2, sums[2] >> 2),
+                       RgbToV(sums[0] >> 2, sums[1] >> 2, sums[2] >> 2));
+  }
+}
+
+template <RgbOrder kOrder, typename Chroma>
+void RgbToYuv(size_t rows, size_t cols, const uint8* rgb, size_t rgb_stride,
+              uint8* y, size_t y_stride, const Chroma& chroma) {
+  for (size_t row = 0; row < rows; row += 2) {
+    const size_t row1 = std::min(row + 1, rows - 1);
+    RgbToYuvRows<kOrder>(cols, rgb + row * rgb_stride, rgb + row1 * rgb_stride,
+                         y + row * y_stride, y + row1 * y_stride, chroma,
+                         row / 2);
+  }
+}
+
+// Returns (x * wx + y * wy + bias) >> 8 for int16 lanes x and y, saturated
+// to int16, where `weights` holds {wx, wy} pairs. bias_lo and bias_hi are the
+// biases of the low and the high half of the lanes.
+inline ColorInt16 PairSum(ColorInt16 x, ColorInt16 y, ColorInt16 weights,
+                          ColorInt32 bias_lo, ColorInt32 bias_hi) {
+  return pack_saturated(shr(mul_sum(zip_lo(x, y), weights, bias_lo), 8),
+                        shr(mul_sum(zip_hi(x, y), weights, bias_hi), 8));
+}
+
+// Converts a row of pixels, whose chroma is row `chroma_row` of `chroma`.
+template <RgbOrder kOrder, typename Chroma>
+void YuvToRgbRow(size_t cols, const uint8* y, const Chroma& chroma,
+                 size_t chroma_row, uint8* rgb) {
+  constexpr size_t kLanes = ColorSimd::size();
+  const auto r_weights = Int16Pairs<ColorAbi>(298, 409);
+  const auto g_weights = Int16Pairs<ColorAbi>(298, -100);
+  const auto g_bias_weights = Int16Pairs<ColorAbi>(-208, 128);
+  const auto b_weights = Int16Pairs<ColorAbi>(298, 516);
+  const ColorInt16 one(1);
+  const ColorInt32 rounding(128);
+  size_t x = 0;
+  // Each step converts 2 * kLanes pixels, which have kLanes chroma samples,
+  // in groups of kLanes / 2 pixels.
+  for (; x + 2 * kLanes <= cols; x += 2 * kLanes) {
+    auto uv = chroma.template Load<ColorSimd>(chroma_row, x / 2);
+    auto us = Widen(uv[0]), vs = Widen(uv[1]);
+    for (size_t half = 0; half < 2; half++) {
+      auto luma = Widen(ColorSimd(y + x + half * kLanes,
+                                  flags::element_aligned));
+      const ColorInt16 d = us[half] - ColorInt16(128);
+      const ColorInt16 e = vs[half] - ColorInt16(128);
+      // Every chroma sample covers two pixels.
+      const ColorInt16 ds[] = {zip_lo(d, d), zip_hi(d, d)};
+      const ColorInt16 es[] = {zip_lo(e, e), zip_hi(e, e)};
+      std::array<ColorInt16, 2> r, g, b;
+      for (size_t i = 0; i < 2; i++) {
+        const ColorInt16 c = luma[i] - ColorInt16(16);
+        r[i] = PairSum(c, es[i], r_weights, rounding, rounding);
+        g[i] = PairSum(c, ds[i], g_weights,
+                       mul_sum(zip_lo(es[i], one), g_bias_weights),
+                       mul_sum(zip_hi(es[i], one), g_bias_weights));
+        b[i] = PairSum(c, ds[i], b_weights, rounding, rounding);
+      }
+      StoreRgb<kOrder>(rgb + 3 * (x + half * kLanes),
+                       packu_saturated(r[0], r[1]),
+                       packu_saturated(g[0], g[1]),
+                       packu_saturated(b[0], b[1]));
+    }
+  }
+  for (; x < cols; x++) {
+    auto uv = chroma.LoadScalar(chroma_row, x / 2);
+    YuvToRgb<kOrder>(y[x], uv[0], uv[1], rgb + 3 * x);
+  }
+}
+
+template <RgbOrder kOrder, typename Chroma>
+void YuvToRgb(size_t rows, size_t cols, const uint8* y, size_t y_stride,
+              const Chroma& chroma, uint8* rgb, size_t rgb_stride) {
+  for (size_t row = 0; row < rows; row++) {
+    YuvToRgbRow<kOrder>(cols, y + row * y_stride, chroma, row / 2,
+                        rgb + row * rgb_stride);
+  }
+}
+
+}  // namespace detail
+
+// Converts the `rows` x `cols` packed RGB (or BGR) image `rgb` to I420: the
+// full resolution luma plane y and the chroma planes u and v, which have
+// (rows + 1) / 2 rows of (cols + 1) / 2 samples.
+template <RgbOrder kOrder = RgbOrder::kRgb>
+void rgb_to_yuv420(size_t rows, size_t cols, const uint8* rgb,
+                   size_t rgb_stride, uint8* y, size_t y_stride, uint8* u,
+                   size_t u_stride, uint8* v, size_t v_stride) {
+  detail::RgbToYuv<kOrder>(
+      rows, cols, rgb, rgb_stride, y, y_stride,
+      detail::PlanarChroma<uint8>{u, u_stride, v, v_stride});
+}
+
+// Like rgb_to_yuv420, with the u and v samples of each 2x2 block interleaved
+// in one plane, uv, as in NV12.
+template <RgbOrder kOrder = RgbOrder::kRgb>
+void rgb_to_nv12(size_t rows, size_t cols, const uint8* rgb,
+                 size_t rgb_stride, uint8* y, size_t y_stride, uint8* uv,
+                 size_t uv_stride) {
+  detail::RgbToYuv<kOrder>(rows, cols, rgb, rgb_stride, y, y_stride,
+                           detail::InterleavedChroma<uint8>{uv, uv_stride});
+}
+
+// The inverse of rgb_to_yuv420, up to rounding.
+template <RgbOrder kOrder = RgbOrder::kRgb>
+void yuv420_to_rgb(size_t rows, size_t cols, const uint8* y, size_t y_stride,
+                   const uint8* u, size_t u_stride, const uint8* v,
+                   size_t v_stride, uint8* rgb, size_t rgb_stride) {
+  detail::YuvToRgb<kOrder>(
+      rows, cols, y, y_stride,
+      detail::PlanarChroma<const uint8>{u, u_stride, v, v_stride}, rgb,
+      rgb_stride);
+}
+
+// The inverse of rgb_to_nv12, up to rounding.
+template <RgbOrder kOrder = RgbOrder::kRgb>
+void nv12_to_rgb(size_t rows, size_t cols, const uint8* y, size_t y_stride,
+                 const uint8* uv, size_t uv_stride, uint8* rgb,
+                 size_t rgb_stride) {
+  detail::YuvToRgb<kOrder>(
+      rows, cols, y, y_stride,
+      detail::InterleavedChroma<const uint8>{uv, uv_stride}, rgb, rgb_stride);
+}
+
+// Converts `count` packed RGB (or BGR) pixels to full range gray.
+template <RgbOrder kOrder = RgbOrder::kRgb>
+void rgb_to_gray(const uint8* rgb, uint8* gray, size_t count) {
+  using detail::ColorSimd;
+  size_t i = 0;
+  for (; i + ColorSimd::size() <= count; i += ColorSimd::size()) {
+    auto sums = detail::WeightedSum(detail::LoadRgb<kOrder>(rgb + 3 * i), 38,
+                                    75, 15, 64);
+    packu_saturated(shr(sums[0], 7), shr(sums[1], 7))
+        .memstore(gray + i, flags::element_aligned);
+  }
+  for (; i < count; i++) {
+    const int32 r = rgb[3 * i + detail::ChannelIndex<kOrder>(0)];
+    const int32 g = rgb[3 * i + 1];
+    const int32 b = rgb[3 * i + detail::ChannelIndex<kOrder>(2)];
+    gray[i] = static_cast<uint8>((38 * r + 75 * g + 15 * b + 64) >> 7);
+  }
+}
+
+// Multiplies the color channels of `count` RGBA pixels by their alpha:
+//   c' = round(c * a / 255)
+// `in` and `out` may be the same array.
+inline void rgba_premultiply(const uint8* in, uint8* out, size_t count) {
+  using detail::ColorSimd;
+  size_t i = 0;
+  for (; i + ColorSimd::size() <= count; i += ColorSimd::size()) {
+    auto rgba = load_interleaved<4, ColorSimd>(in + 4 * i);
+    auto a = detail::Widen(rgba[3]);
+    for (size_t c = 0; c < 3; c++) {
+      auto halves = detail::Widen(rgba[c]);
+      for (size_t h = 0; h < 2; h++) {
+        halves[h] = bit_cast<int16>(detail::DivideBy255Rounded(
+            bit_cast<uint16>(halves[h]) * bit_cast<uint16>(a[h])));
+      }
+      rgba[c] = packu_saturated(halves[0], halves[1]);
+    }
+    store_interleaved(out + 4 * i, rgba);
+  }
+  for (; i < count; i++) {
+    const uint32 a = in[4 * i + 3];
+    for (size_t c = 0; c < 3; c++) {
+      out[4 * i + c] = static_cast<uint8>((in[4 * i + c] * a + 127) / 255);
+    }
+    out[4 * i + 3] = static_cast<uint8>(a);
+  }
+}
+
+// The inverse of rgba_premultiply, up to rounding:
+//   c' = min((c * 255 + a / 2) / a, 255), or 0 if a is 0.
+// `in` and `out` may be the same array.
+inline void rgba_unpremultiply(const uint8* in, uint8* out, size_t count) {
+  using detail::ColorSimd;
+  using Int32 = detail::ColorInt32;
+  using Float = Simd<float, detail::ColorAbi>;
+  size_t i = 0;
+  for (; i + ColorSimd::size() <= count; i += ColorSimd::size()) {
+    auto rgba = load_interleaved<4, ColorSimd>(in + 4 * i);
+    auto a = detail::WidenToInt32(rgba[3]);
+    std::array<Int32, 4> half_a;
+    std::array<Float, 4> reciprocal;
+    for (size_t q = 0; q < 4; q++) {
+      half_a[q] = shr(a[q], 1);
+      a[q] = max(a[q], Int32(1));
+      // One Newton-Raphson step brings the estimate close enough for the
+      // truncated quotients to be off by at most 1.
+      const Float af = static_simd_cast<float>(a[q]);
+      const Float estimate = reciprocal_estimate(af);
+      reciprocal[q] = estimate * (Float(2) - af * estimate);
+    }
+    const ColorSimd transparent = cmp_eq(rgba[3], ColorSimd(0));
+    for (size_t c = 0; c < 3; c++) {
+      auto quarters = detail::WidenToInt32(rgba[c]);
+      std::array<Int32, 4> quotient;
+      for (size_t q = 0; q < 4; q++) {
+        const Int32 numerator = quarters[q] * Int32(255) + half_a[q];
+        Int32 estimate = static_simd_cast<int32>(
+            static_simd_cast<float>(numerator) * reciprocal[q]);
+        // The comparisons are -1 where they hold.
+        const Int32 remainder = numerator - estimate * a[q];
+        quotient[q] = estimate - bit_cast<int32>(cmp_ge(remainder, a[q])) +
+                      bit_cast<int32>(cmp_lt(remainder, Int32(0)));
+      }
+      rgba[c] = packu_saturated(pack_saturated(quotient[0], quotient[1]),
+                                pack_saturated(quotient[2], quotient[3])) &
+                ~transparent;
+    }
+    store_interleaved(out + 4 * i, rgba);
+  }
+  for (; i < count; i++) {
+    const uint32 a = in[4 * i + 3];
+    for (size_t c = 0; c < 3; c++) {
+      out[4 * i + c] =
+          a == 0 ? 0
+                 : static_cast<uint8>(
+                       std::min<uint32>((in[4 * i + c] * 255 + a / 2) / a,
+                                        255));
+    }
+    out[4 * i + 3] = static_cast<uint8>(a);
+  }
+}
+
+}  // namespace dimsum
+
+#endif  // DIMSUM_DIMSUM_COLOR_H_
@@ -0,0 +1,255 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "dimsum_color.h"
+
+namespace dimsum {
+namespace {
+
+std::vector<uint8> MakeBytes(size_t size) {
+  std::vector<uint8> bytes(size);
+  for (size_t i = 0; i < size; i++) {
+    bytes[i] = static_cast<uint8>(i * 2654435761u >> 13);
+  }
+  return bytes;
+}
+
+// Arguments of the image benchmarks: columns and rows. Throughput is in
+// pixels per second.
+void ImageSizes(benchmark::internal::Benchmark* b) {
+  b->Args({640, 480})->Args({1920, 1080})->Args({3840, 2160});
+}
+
+void SetPixelsProcessed(benchmark::State& state) {
+  state.SetItemsProcessed(state.iterations() * state.range(0) *
+                          state.range(1));
+}
+
+void BM_RgbToYuv420Scalar(benchmark::State& state) {
+  const size_t cols = state.range(0), rows = state.range(1);
+  const size_t chroma_cols = (cols + 1) / 2;
+  auto rgb = MakeBytes(3 * rows * cols);
+  std::vector<uint8> y(rows * cols), u(rows / 2 * chroma_cols),
+      v(rows / 2 * chroma_cols);
+  for (auto _ : state) {
+    for (size_t row = 0; row < rows; row++) {
+      const uint8* p = &rgb[3 * row * cols];
+      for (size_t col = 0; col < cols; col++) {
+        y[row * cols + col] =
+            detail::RgbToY(p[3 * col], p[3 * col + 1], p[3 * col + 2]);
+      }
+    }
+    for (size_t row = 0; row < rows; row += 2) {
+      const uint8* p0 = &rgb[3 * row * cols];
+      const uint8* p1 = p0 + 3 * cols;
+      for (size_t col = 0; col < cols; col += 2) {
+        int32 avg[3];
+        for (size_t c = 0; c < 3; c++) {
+          avg[c] = (p0[3 * col + c] + p0[3 * col + 3 + c] + p1[3 * col + c] +
+                    p1[3 * col + 3 + c] + 2) >>
+                   2;
+        }
+        u[row / 2 * chroma_cols + col / 2] =
+            detail::RgbToU(avg[0], avg[1], avg[2]);
+        v[row / 2 * chroma_cols + col / 2] =
+            detail::RgbToV(avg[0], avg[1], avg[2]);
+      }
+    }
+    benchmark::DoNotOptimize(y.data());
+    benchmark::DoNotOptimize(u.data());
+    benchmark::DoNotOptimize(v.data());
+  }
+  SetPixelsProcessed(state);
+}
+BENCHMARK(BM_RgbToYuv420Scalar)->Apply(ImageSizes);
+
+void BM_RgbToYuv420(benchmark::State& state) {
+  const size_t cols = state.range(0), rows = state.range(1);
+  const size_t chroma_cols = (cols + 1) / 2;
+  auto rgb = MakeBytes(3 * rows * cols);
+  std::vector<uint8> y(rows * cols), u(rows / 2 * chroma_cols),
+      v(rows / 2 * chroma_cols);
+  for (auto _ : state) {
+    rgb_to_yuv420(rows, cols, rgb.data(), 3 * cols, y.data(), cols, u.data(),
+                  chroma_cols, v.data(), chroma_cols);
+    benchmark::DoNotOptimize(y.data());
+    benchmark::DoNotOptimize(u.data());
+    benchmark::DoNotOptimize(v.data());
+  }
+  SetPixelsProcessed(state);
+}
+BENCHMARK(BM_RgbToYuv420)->Apply(ImageSizes);
+
+void BM_RgbToNv12(benchmark::State& state) {
+  const size_t cols = state.range(0), rows = state.range(1);
+  auto rgb = MakeBytes(3 * rows * cols);
+  std::vector<uint8> y(rows * cols), uv(rows / 2 * cols);
+  for (auto _ : state) {
+    rgb_to_nv12(rows, cols, rgb.data(), 3 * cols, y.data(), cols, uv.data(),
+                cols);
+    benchmark::DoNotOptimize(y.data());
+    benchmark::DoNotOptimize(uv.data());
+  }
+  SetPixelsProcessed(state);
+}
+BENCHMARK(BM_RgbToNv12)->Apply(ImageSizes);
+
+void BM_Yuv420ToRgbScalar(benchmark::State& state) {
+  const size_t cols = state.range(0), rows = state.range(1);
+  const size_t chroma_cols = cols / 2;
+  auto y = MakeBytes(rows * cols);
+  auto u = MakeBytes(rows / 2 * chroma_cols);
+  auto v = MakeBytes(rows / 2 * chroma_cols);
+  std::vector<uint8> rgb(3 * rows * cols);
+  for (auto _ : state) {
+    for (size_t row = 0; row < rows; row++) {
+      for (size_t col = 0; col < cols; col++) {
+        const size_t chroma = row / 2 * chroma_cols + col / 2;
+        detail::YuvToRgb<RgbOrder::kRgb>(y[row * cols + col], u[chroma],
+                                         v[chroma],
+                                         &rgb[3 * (row * cols + col)]);
+      }
+    }
+    benchmark::DoNotOptimize(rgb.data());
+  }
+  SetPixelsProcessed(state);
+}
+BENCHMARK(BM_Yuv420ToRgbScalar)->Apply(ImageSizes);
+
+void BM_Yuv420ToRgb(benchmark::State& state) {
+  const size_t cols = state.range(0), rows = state.range(1);
+  const size_t chroma_cols = cols / 2;
+  auto y = MakeBytes(rows * cols);
+  auto u = MakeBytes(rows / 2 * chroma_cols);
+  auto v = MakeBytes(rows / 2 * chroma_cols);
+  std::vector<uint8> rgb(3 * rows * cols);
+  for (auto _ : state) {
+    yuv420_to_rgb(rows, cols, y.data(), cols, u.data(), chroma_cols, v.data(),
+                  chroma_cols, rgb.data(), 3 * cols);
+    benchmark::DoNotOptimize(rgb.data());
+  }
+  SetPixelsProcessed(state);
+}
+BENCHMARK(BM_Yuv420ToRgb)->Apply(ImageSizes);
+
+void BM_Nv12ToRgb(benchmark::State& state) {
+  const size_t cols = state.range(0), rows = state.range(1);
+  auto y = MakeBytes(rows * cols);
+  auto uv = MakeBytes(rows / 2 * cols);
+  std::vector<uint8> rgb(3 * rows * cols);
+  for (auto _ : state) {
+    nv12_to_rgb(rows, cols, y.data(), cols, uv.data(), cols, rgb.data(),
+                3 * cols);
+    benchmark::DoNotOptimize(rgb.data());
+  }
+  SetPixelsProcessed(state);
+}
+BENCHMARK(BM_Nv12ToRgb)->Apply(ImageSizes);
+
+void BM_RgbToGrayScalar(benchmark::State& state) {
+  const size_t count = state.range(0) * state.range(1);
+  auto rgb = MakeBytes(3 * count);
+  std::vector<uint8> gray(count);
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; i++) {
+      gray[i] = static_cast<uint8>((38 * rgb[3 * i] + 75 * rgb[3 * i + 1] +
+                                    15 * rgb[3 * i + 2] + 64) >>
+                                   7);
+    }
+    benchmark::DoNotOptimize(gray.data());
+  }
+  SetPixelsProcessed(state);
+}
+BENCHMARK(BM_RgbToGrayScalar)->Apply(ImageSizes);
+
+void BM_RgbToGray(benchmark::State& state) {
+  const size_t count = state.range(0) * state.range(1);
+  auto rgb = MakeBytes(3 * count);
+  std::vector<uint8> gray(count);
+  for (auto _ : state) {
+    rgb_to_gray(rgb.data(), gray.data(), count);
+    benchmark::DoNotOptimize(gray.data());
+  }
+  SetPixelsProcessed(state);
+}
+BENCHMARK(BM_RgbToGray)->Apply(ImageSizes);
+
+void BM_PremultiplyScalar(benchmark::State& state) {
+  const size_t count = state.range(0) * state.range(1);
+  auto rgba = MakeBytes(4 * count);
+  std::vector<uint8> out(4 * count);
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; i++) {
+      const uint32 a = rgba[4 * i + 3];
+      for (size_t c = 0; c < 3; c++) {
+        out[4 * i + c] = static_cast<uint8>((rgba[4 * i + c] * a + 127) / 255);
+      }
+      out[4 * i + 3] = static_cast<uint8>(a);
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  SetPixelsProcessed(state);
+}
+BENCHMARK(BM_PremultiplyScalar)->Apply(ImageSizes);
+
+void BM_Premultiply(benchmark::State& state) {
+  const size_t count = state.range(0) * state.range(1);
+  auto rgba = MakeBytes(4 * count);
+  std::vector<uint8> out(4 * count);
+  for (auto _ : state) {
+    rgba_premultiply(rgba.data(), out.data(), count);
+    benchmark::DoNotOptimize(out.data());
+  }
+  SetPixelsProcessed(state);
+}
+BENCHMARK(BM_Premultiply)->Apply(ImageSizes);
+
+void BM_UnpremultiplyScalar(benchmark::State& state) {
+  const size_t count = state.range(0) * state.range(1);
+  auto rgba = MakeBytes(4 * count);
+  std::vector<uint8> out(4 * count);
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; i++) {
+      const uint32 a = rgba[4 * i + 3];
+      for (size_t c = 0; c < 3; c++) {
+        out[4 * i + c] =
+            a == 0 ? 0
+                   : static_cast<uint8>(std::min<uint32>(
+                         (rgba[4 * i + c] * 255 + a / 2) / a, 255));
+      }
+      out[4 * i + 3] = static_cast<uint8>(a);
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  SetPixelsProcessed(state);
+}
+BENCHMARK(BM_UnpremultiplyScalar)->Apply(ImageSizes);
+
+void BM_Unpremultiply(benchmark::State& state) {
+  const size_t count = state.range(0) * state.range(1);
+  auto rgba = MakeBytes(4 * count);
+  std::vector<uint8> out(4 * count);
+  for (auto _ : state) {
+    rgba_unpremultiply(rgba.data(), out.data(), count);
+    benchmark::DoNotOptimize(out.data());
+  }
+  SetPixelsProcessed(state);
+}
+BENCHMARK(BM_Unpremultiply)->Apply(ImageSizes);
+
+}  // namespace
+}  // namespace dimsum
@@ -0,0 +1,245 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dimsum_color.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+std::vector<uint8> MakeBytes(size_t size, size_t seed) {
+  std::vector<uint8> bytes(size);
+  for (size_t i = 0; i < size; i++) {
+    bytes[i] = static_cast<uint8>((i + seed) * 2654435761u >> 13);
+  }
+  return bytes;
+}
+
+int Clamp(int value) { return std::min(std::max(value, 0), 255); }
+
+// The formulas of dimsum_color.h, one pixel at a time. Channels are given
+// in RGB order.
+struct Yuv {
+  int y, u, v;
+};
+
+int ReferenceY(int r, int g, int b) {
+  return ((33 * r + 64 * g + 13 * b + 64) >> 7) + 16;
+}
+
+int ReferenceU(int r, int g, int b) {
+  return ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+}
+
+int ReferenceV(int r, int g, int b) {
+  return ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+}
+
+void ReferenceRgb(int y, int u, int v, int* rgb) {
+  const int c = y - 16, d = u - 128, e = v - 128;
+  rgb[0] = Clamp((298 * c + 409 * e + 128) >> 8);
+  rgb[1] = Clamp((298 * c - 100 * d - 208 * e + 128) >> 8);
+  rgb[2] = Clamp((298 * c + 516 * d + 128) >> 8);
+}
+
+// Checks rgb_to_yuv420, rgb_to_nv12, yuv420_to_rgb and nv12_to_rgb on a
+// rows x cols image with padded strides.
+template <RgbOrder kOrder>
+void TestYuv(size_t rows, size_t cols) {
+  const size_t red = kOrder == RgbOrder::kRgb ? 0 : 2;
+  const size_t rgb_stride = 3 * cols + 5, y_stride = cols + 3;
+  const size_t chroma_rows = (rows + 1) / 2, chroma_cols = (cols + 1) / 2;
+  const size_t u_stride = chroma_cols + 1, v_stride = chroma_cols + 7;
+  const size_t uv_stride = 2 * chroma_cols + 2;
+  const auto rgb = MakeBytes(rows * rgb_stride, rows * cols);
+  auto pixel = [&](size_t row, size_t col, size_t c) -> int {
+    row = std::min(row, rows - 1);
+    col = std::min(col, cols - 1);
+    return rgb[row * rgb_stride + 3 * col + (c == 1 ? 1 : c ^ red)];
+  };
+
+  std::vector<uint8> y(rows * y_stride), y_nv12(rows * y_stride);
+  std::vector<uint8> u(chroma_rows * u_stride), v(chroma_rows * v_stride);
+  std::vector<uint8> uv(chroma_rows * uv_stride);
+  rgb_to_yuv420<kOrder>(rows, cols, rgb.data(), rgb_stride, y.data(),
+                        y_stride, u.data(), u_stride, v.data(), v_stride);
+  rgb_to_nv12<kOrder>(rows, cols, rgb.data(), rgb_stride, y_nv12.data(),
+                      y_stride, uv.data(), uv_stride);
+  for (size_t row = 0; row < rows; row++) {
+    for (size_t col = 0; col < cols; col++) {
+      const int expected = ReferenceY(pixel(row, col, 0), pixel(row, col, 1),
+                                      pixel(row, col, 2));
+      ASSERT_EQ(expected, y[row * y_stride + col])
+          << rows << "x" << cols << " at " << row << ", " << col;
+      ASSERT_EQ(expected, y_nv12[row * y_stride + col])
+          << rows << "x" << cols << " at " << row << ", " << col;
+    }
+  }
+  for (size_t row = 0; row < chroma_rows; row++) {
+    for (size_t col = 0; col < chroma_cols; col++) {
+      int avg[3];
+      for (size_t c = 0; c < 3; c++) {
+        avg[c] = (pixel(2 * row, 2 * col, c) + pixel(2 * row, 2 * col + 1, c) +
+                  pixel(2 * row + 1, 2 * col, c) +
+                  pixel(2 * row + 1, 2 * col + 1, c) + 2) >>
+                 2;
+      }
+      const int expected_u = ReferenceU(avg[0], avg[1], avg[2]);
+      const int expected_v = ReferenceV(avg[0], avg[1], avg[2]);
+      ASSERT_EQ(expected_u, u[row * u_stride + col])
+          << rows << "x" << cols << " at " << row << ", " << col;
+      ASSERT_EQ(expected_v, v[row * v_stride + col])
+          << rows << "x" << cols << " at " << row << ", " << col;
+      ASSERT_EQ(expected_u, uv[row * uv_stride + 2 * col]);
+      ASSERT_EQ(expected_v, uv[row * uv_stride + 2 * col + 1]);
+    }
+  }
+
+  // Converting back uses the whole range of y, u and v, not only the values
+  // produced above.
+  y = MakeBytes(rows * y_stride, cols);
+  u = MakeBytes(chroma_rows * u_stride, 1);
+  v = MakeBytes(chroma_rows * v_stride, 2);
+  for (size_t row = 0; row < chroma_rows; row++) {
+    for (size_t col = 0; col < chroma_cols; col++) {
+      uv[row * uv_stride + 2 * col] = u[row * u_stride + col];
+      uv[row * uv_stride + 2 * col + 1] = v[row * v_stride + col];
+    }
+  }
+  std::vector<uint8> out(rows * rgb_stride), out_nv12(rows * rgb_stride);
+  yuv420_to_rgb<kOrder>(rows, cols, y.data(), y_stride, u.data(), u_stride,
+                        v.data(), v_stride, out.data(), rgb_stride);
+  nv12_to_rgb<kOrder>(rows, cols, y.data(), y_stride, uv.data(), uv_stride,
+                      out_nv12.data(), rgb_stride);
+  for (size_t row = 0; row < rows; row++) {
+    for (size_t col = 0; col < cols; col++) {
+      int expected[3];
+      ReferenceRgb(y[row * y_stride + col],
+                   u[row / 2 * u_stride + col / 2],
+                   v[row / 2 * v_stride + col / 2], expected);
+      for (size_t c = 0; c < 3; c++) {
+        const size_t i = row * rgb_stride + 3 * col + (c == 1 ? 1 : c ^ red);
+        ASSERT_EQ(expected[c], out[i])
+            << rows << "x" << cols << " at " << row << ", " << col;
+        ASSERT_EQ(expected[c], out_nv12[i])
+            << rows << "x" << cols << " at " << row << ", " << col;
+      }
+    }
+  }
+}
+
+TEST(ColorTest, Yuv) {
+  const size_t sizes[] = {1, 2, 3, 16, 31, 64, 65, 100, 130};
+  for (size_t rows : {1, 2, 5, 8}) {
+    for (size_t cols : sizes) {
+      TestYuv<RgbOrder::kRgb>(rows, cols);
+      TestYuv<RgbOrder::kBgr>(rows, cols);
+    }
+  }
+}
+
+TEST(ColorTest, YuvExtremes) {
+  EXPECT_EQ(16, ReferenceY(0, 0, 0));
+  EXPECT_EQ(235, ReferenceY(255, 255, 255));
+  const uint8 white[] = {255, 255, 255, 255, 255, 255};
+  uint8 y[2], u, v;
+  rgb_to_yuv420(1, 2, white, 6, y, 2, &u, 1, &v, 1);
+  EXPECT_EQ(235, y[0]);
+  EXPECT_EQ(128, u);
+  EXPECT_EQ(128, v);
+}
+
+template <RgbOrder kOrder>
+void TestGray() {
+  const size_t red = kOrder == RgbOrder::kRgb ? 0 : 2;
+  for (size_t count : {0, 1, 15, 16, 33, 64, 1000}) {
+    auto rgb = MakeBytes(3 * count, count);
+    std::vector<uint8> gray(count + 1, 77);
+    rgb_to_gray<kOrder>(rgb.data(), gray.data(), count);
+    for (size_t i = 0; i < count; i++) {
+      const int r = rgb[3 * i + red], g = rgb[3 * i + 1];
+      const int b = rgb[3 * i + (2 ^ red)];
+      ASSERT_EQ((38 * r + 75 * g + 15 * b + 64) >> 7, gray[i]) << i;
+    }
+    EXPECT_EQ(77, gray[count]);
+  }
+}
+
+TEST(ColorTest, Gray) {
+  TestGray<RgbOrder::kRgb>();
+  TestGray<RgbOrder::kBgr>();
+}
+
+// Every pair of a color channel and an alpha value.
+std::vector<uint8> AllChannelAlphaPairs() {
+  std::vector<uint8> rgba(4 * 65536);
+  for (size_t i = 0; i < 65536; i++) {
+    rgba[4 * i] = static_cast<uint8>(i);
+    rgba[4 * i + 1] = static_cast<uint8>(255 - i);
+    rgba[4 * i + 2] = static_cast<uint8>(i * 7);
+    rgba[4 * i + 3] = static_cast<uint8>(i >> 8);
+  }
+  return rgba;
+}
+
+TEST(ColorTest, Premultiply) {
+  const auto rgba = AllChannelAlphaPairs();
+  std::vector<uint8> out(rgba.size());
+  rgba_premultiply(rgba.data(), out.data(), 65536);
+  for (size_t i = 0; i < rgba.size(); i++) {
+    const int a = rgba[i | 3];
+    const int expected = i % 4 == 3 ? a : (rgba[i] * a + 127) / 255;
+    ASSERT_EQ(expected, out[i]) << i;
+  }
+
+  // In place, with a count that leaves a remainder.
+  out = rgba;
+  rgba_premultiply(out.data(), out.data(), 1001);
+  for (size_t i = 0; i < 4 * 1001; i++) {
+    const int a = rgba[i | 3];
+    const int expected = i % 4 == 3 ? a : (rgba[i] * a + 127) / 255;
+    ASSERT_EQ(expected, out[i]) << i;
+  }
+}
+
+TEST(ColorTest, Unpremultiply) {
+  const auto rgba = AllChannelAlphaPairs();
+  std::vector<uint8> out(rgba.size());
+  rgba_unpremultiply(rgba.data(), out.data(), 65536);
+  for (size_t i = 0; i < rgba.size(); i++) {
+    const int a = rgba[i | 3];
+    int expected = a;
+    if (i % 4 != 3) {
+      expected = a == 0 ? 0 : std::min((rgba[i] * 255 + a / 2) / a, 255);
+    }
+    ASSERT_EQ(expected, out[i]) << i;
+  }
+
+  // Premultiplying and unpremultiplying opaque pixels is lossless.
+  std::vector<uint8> opaque = MakeBytes(4 * 100, 3);
+  for (size_t i = 3; i < opaque.size(); i += 4) {
+    opaque[i] = 255;
+  }
+  out = opaque;
+  rgba_premultiply(out.data(), out.data(), 100);
+  rgba_unpremultiply(out.data(), out.data(), 100);
+  EXPECT_EQ(opaque, out);
+}
+
+}  // namespace
+}  // namespace dimsum
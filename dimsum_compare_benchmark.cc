@@ -0,0 +1,77 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "benchmark/benchmark.h"
+#include "benchmark_util.h"
+#include "dimsum.h"
+
+namespace dimsum {
+namespace {
+
+// The range [kLow, kHigh) straddles the sign bit, so that a signed
+// comparison would give wrong answers.
+template <typename T>
+constexpr T kLow = static_cast<T>(T{1} << (8 * sizeof(T) - 2));
+
+template <typename T>
+constexpr T kHigh = static_cast<T>(T{3} << (8 * sizeof(T) - 2));
+
+// Computes an all-ones mask for the values in [kLow, kHigh), the inner loop
+// of a range filter over an unsigned column.
+template <typename T>
+void BM_RangeFilterScalar(benchmark::State& state) {
+  bench::ScalarLoop(state,
+                    [](T value) {
+                      return value >= kLow<T> && value < kHigh<T> ? ~T{0}
+                                                                  : T{0};
+                    },
+                    bench::MakeValues<T>());
+}
+
+template <typename T>
+void BM_RangeFilterVectorExtension(benchmark::State& state) {
+  using Vec = bench::NativeVec<T>;
+  const Vec low = Vec{} + kLow<T>, high = Vec{} + kHigh<T>;
+  bench::VectorExtensionLoop(state,
+                             [low, high](Vec value) {
+                               return reinterpret_cast<Vec>(value >= low) &
+                                      reinterpret_cast<Vec>(value < high);
+                             },
+                             bench::MakeValues<T>());
+}
+
+template <typename T>
+void BM_RangeFilterNativeSimd(benchmark::State& state) {
+  const NativeSimd<T> low = kLow<T>, high = kHigh<T>;
+  bench::SimdLoop(state,
+                  [low, high](NativeSimd<T> value) {
+                    return cmp_ge(value, low) & cmp_lt(value, high);
+                  },
+                  bench::MakeValues<T>());
+}
+
+#define DIMSUM_COMPARE_BENCHMARKS(type)                    \
+  BENCHMARK_TEMPLATE(BM_RangeFilterScalar, type);          \
+  BENCHMARK_TEMPLATE(BM_RangeFilterVectorExtension, type); \
+  BENCHMARK_TEMPLATE(BM_RangeFilterNativeSimd, type)
+
+DIMSUM_COMPARE_BENCHMARKS(uint8);
+DIMSUM_COMPARE_BENCHMARKS(uint16);
+DIMSUM_COMPARE_BENCHMARKS(uint32);
+DIMSUM_COMPARE_BENCHMARKS(uint64);
+
+#undef DIMSUM_COMPARE_BENCHMARKS
+
+}  // namespace
+}  // namespace dimsum
@@ -0,0 +1,512 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_DIMSUM_CONTAINERS_H_
+#define DIMSUM_DIMSUM_CONTAINERS_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <utility>
+
+#include "dimsum.h"
+#include "dimsum_hash.h"
+#include "dimsum_x86.h"
+
+// Open-addressing hash containers in the style of Swiss tables.
+//
+// Every slot has a control byte, which is either kEmpty, kDeleted, or the low
+// 7 bits of the hash of the element stored in it. Slots are split into groups
+// of NativeSimd<uint8>::size() slots (16 on SSE/NEON/VSX, 32 on AVX2). A
+// lookup compares the control bytes of a whole group against the 7-bit hash
+// with a single cmp_eq, and x86::movemask turns the result into a bitmask of
+// candidate slots; only those are compared with the key.
+//
+// Probing is done over whole groups, in triangular order, so group loads
+// never straddle the end of the control array. Erasing from a group that has
+// never been full marks the slot kEmpty; otherwise it leaves a kDeleted
+// tombstone so that probe sequences passing through the group stay intact.
+//
+// Pointers and iterators are invalidated by any insertion that grows or
+// rehashes the table, and by erase of the pointed-to element.
+
+namespace dimsum {
+namespace containers {
+
+// The default hasher. Integer keys hash to themselves under most std::hash
+// implementations, so the result is mixed with hash_u64 to spread both the
+// 7 bits stored in the control byte and the bits used to pick a group.
+template <typename Key>
+struct Hash {
+  size_t operator()(const Key& key) const {
+    uint64 hash = static_cast<uint64>(std::hash<Key>()(key));
+    return static_cast<size_t>(hash_u64(hash));
+  }
+};
+
+namespace detail {
+
+using Group = NativeSimd<uint8>;
+
+static_assert(Group::size() <= 32, "Group masks must fit in 32 bits");
+
+constexpr size_t kGroupWidth = Group::size();
+
+constexpr uint8 kEmpty = 0x80;
+constexpr uint8 kDeleted = 0xfe;
+
+inline bool IsFull(uint8 ctrl) { return (ctrl & 0x80) == 0; }
+
+// Returns a bitmask whose ith bit is set iff ctrl[i] == value.
+inline uint32 MatchByte(Group ctrl, uint8 value) {
+  return static_cast<uint32>(x86::movemask(cmp_eq(ctrl, Group(value))));
+}
+
+inline uint32 MatchEmpty(Group ctrl) { return MatchByte(ctrl, kEmpty); }
+
+// kEmpty and kDeleted are the only control bytes with the top bit set.
+inline uint32 MatchEmptyOrDeleted(Group ctrl) {
+  return static_cast<uint32>(x86::movemask(ctrl));
+}
+
+inline int LowestBit(uint32 mask) { return __builtin_ctz(mask); }
+
+template <typename K>
+struct SetPolicy {
+  using key_type = K;
+  using value_type = K;
+
+  static const key_type& Key(const value_type& value) { return value; }
+};
+
+template <typename K, typename V>
+struct MapPolicy {
+  using key_type = K;
+  using value_type = std::pair<const K, V>;
+
+  static const key_type& Key(const value_type& value) { return value.first; }
+};
+
+// The table shared by flat_hash_set and flat_hash_map.
+template <typename Policy, typename Hasher, typename KeyEqual>
+class RawHashSet {
+ public:
+  using key_type = typename Policy::key_type;
+  using value_type = typename Policy::value_type;
+  using size_type = size_t;
+  using hasher = Hasher;
+  using key_equal = KeyEqual;
+
+  template <typename ValueType, typename SetType>
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename RawHashSet::value_type;
+    using difference_type = ptrdiff_t;
+    using pointer = ValueType*;
+    using reference = ValueType&;
+
+    Iterator() = default;
+
+    // Allows conversion from iterator to const_iterator.
+    template <typename V, typename S>
+    Iterator(const Iterator<V, S>& other)  // NOLINT
+        : set_(other.set_), index_(other.index_) {}
+
+    reference operator*() const { return set_->slots_[index_]; }
+    pointer operator->() const { return &set_->slots_[index_]; }
+
+    Iterator& operator++() {
+      index_ = set_->NextFull(index_ + 1);
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    friend bool operator==(const Iterator& lhs, const Iterator& rhs) {
+      return lhs.index_ == rhs.index_;
+    }
+
+    friend bool operator!=(const Iterator& lhs, const Iterator& rhs) {
+      return !(lhs == rhs);
+    }
+
+   private:
+    friend class RawHashSet;
+    template <typename V, typename S>
+    friend class Iterator;
+
+    Iterator(SetType* set, size_t index) : set_(set), index_(index) {}
+
+    SetType* set_ = nullptr;
+    size_t index_ = 0;
+  };
+
+  using iterator = Iterator<value_type, RawHashSet>;
+  using const_iterator = Iterator<const value_type, const RawHashSet>;
+
+  RawHashSet() = default;
+
+  explicit RawHashSet(size_t bucket_count, const hasher& hash = hasher(),
+                      const key_equal& eq = key_equal())
+      : hash_(hash), eq_(eq) {
+    reserve(bucket_count);
+  }
+
+  RawHashSet(const RawHashSet& other) : hash_(other.hash_), eq_(other.eq_) {
+    reserve(other.size());
+    for (const value_type& value : other) {
+      InsertUnique(value);
+    }
+  }
+
+  RawHashSet(RawHashSet&& other) noexcept
+      : hash_(std::move(other.hash_)), eq_(std::move(other.eq_)) {
+    StealFrom(&other);
+  }
+
+  RawHashSet& operator=(const RawHashSet& other) {
+    if (this != &other) {
+      RawHashSet copy(other);
+      *this = std::move(copy);
+    }
+    return *this;
+  }
+
+  RawHashSet& operator=(RawHashSet&& other) noexcept {
+    if (this != &other) {
+      Destroy();
+      hash_ = std::move(other.hash_);
+      eq_ = std::move(other.eq_);
+      StealFrom(&other);
+    }
+    return *this;
+  }
+
+  ~RawHashSet() { Destroy(); }
+
+  iterator begin() { return iterator(this, NextFull(0)); }
+  iterator end() { return iterator(this, capacity_); }
+  const_iterator begin() const { return const_iterator(this, NextFull(0)); }
+  const_iterator end() const { return const_iterator(this, capacity_); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+  // Returns the number of slots, which is 0 or a power of two that is at least
+  // the group width.
+  size_t capacity() const { return capacity_; }
+
+  void clear() {
+    for (size_t i = 0; i < capacity_; i++) {
+      if (IsFull(ctrl_[i])) {
+        slots_[i].~value_type();
+      }
+      ctrl_[i] = kEmpty;
+    }
+    size_ = 0;
+    growth_left_ = MaxLoad(capacity_);
+  }
+
+  // Makes room for `count` elements without further rehashing.
+  void reserve(size_t count) {
+    if (count > size_ + growth_left_) {
+      Resize(CapacityFor(count));
+    }
+  }
+
+  iterator find(const key_type& key) {
+    return iterator(this, Find(key, hash_(key)));
+  }
+
+  const_iterator find(const key_type& key) const {
+    return const_iterator(this, Find(key, hash_(key)));
+  }
+
+  bool contains(const key_type& key) const { return find(key) != end(); }
+
+  size_t count(const key_type& key) const { return contains(key) ? 1 : 0; }
+
+  size_t erase(const key_type& key) {
+    size_t index = Find(key, hash_(key));
+    if (index == capacity_) return 0;
+    EraseAt(index);
+    return 1;
+  }
+
+  void erase(const_iterator it) { EraseAt(it.index_); }
+
+  hasher hash_function() const { return hash_; }
+  key_equal key_eq() const { return eq_; }
+
+ protected:
+  // Inserts a value_type constructed from `args` unless an element with `key`
+  // already exists. Returns the position of the element with `key`, and
+  // whether it was inserted.
+  template <typename... Args>
+  std::pair<iterator, bool> EmplaceWithKey(const key_type& key,
+                                           Args&&... args) {
+    size_t hash = hash_(key);
+    size_t index = Find(key, hash);
+    if (index != capacity_) return {iterator(this, index), false};
+
+    if (capacity_ == 0) Grow();
+    index = FindInsertPosition(hash);
+    if (growth_left_ == 0 && ctrl_[index] == kEmpty) {
+      Grow();
+      index = FindInsertPosition(hash);
+    }
+    new (&slots_[index]) value_type(std::forward<Args>(args)...);
+    SetCtrl(index, hash);
+    return {iterator(this, index), true};
+  }
+
+ private:
+  static size_t MaxLoad(size_t capacity) { return capacity - capacity / 8; }
+
+  static size_t CapacityFor(size_t count) {
+    size_t capacity = kGroupWidth;
+    while (MaxLoad(capacity) < count) capacity *= 2;
+    return capacity;
+  }
+
+  static uint8 H2(size_t hash) { return hash & 0x7f; }
+  static size_t H1(size_t hash) { return hash >> 7; }
+
+  size_t NumGroups() const { return capacity_ / kGroupWidth; }
+
+  Group LoadGroup(size_t group) const {
+    return Group(ctrl_.get() + group * kGroupWidth, flags::element_aligned);
+  }
+
+  // Returns the index of the element with `key`, or capacity_ if none.
+  size_t Find(const key_type& key, size_t hash) const {
+    if (capacity_ == 0) return capacity_;
+    const size_t mask = NumGroups() - 1;
+    size_t group = H1(hash) & mask;
+    for (size_t step = 1;; step++) {
+      Group ctrl = LoadGroup(group);
+      for (uint32 match = MatchByte(ctrl, H2(hash)); match;
+           match &= match - 1) {
+        size_t index = group * kGroupWidth + LowestBit(match);
+        if (eq_(Policy::Key(slots_[index]), key)) return index;
+      }
+      if (MatchEmpty(ctrl)) return capacity_;
+      group = (group + step) & mask;
+    }
+  }
+
+  // Returns the first empty or deleted slot on the probe sequence of `hash`.
+  // The table always has at least one empty slot, so this terminates.
+  size_t FindInsertPosition(size_t hash) const {
+    const size_t mask = NumGroups() - 1;
+    size_t group = H1(hash) & mask;
+    for (size_t step = 1;; step++) {
+      uint32 match = MatchEmptyOrDeleted(LoadGroup(group));
+      if (match) return group * kGroupWidth + LowestBit(match);
+      group = (group + step) & mask;
+    }
+  }
+
+  void SetCtrl(size_t index, size_t hash) {
+    if (ctrl_[index] == kEmpty) growth_left_--;
+    ctrl_[index] = H2(hash);
+    size_++;
+  }
+
+  void EraseAt(size_t index) {
+    slots_[index].~value_type();
+    size_--;
+    // A group that still has an empty slot never stopped a probe sequence
+    // from terminating in it, so no key lives past it on its account.
+    if (MatchEmpty(LoadGroup(index / kGroupWidth))) {
+      ctrl_[index] = kEmpty;
+      growth_left_++;
+    } else {
+      ctrl_[index] = kDeleted;
+    }
+  }
+
+  size_t NextFull(size_t index) const {
+    while (index < capacity_ && !IsFull(ctrl_[index])) index++;
+    return index;
+  }
+
+  // Called when an insertion would consume the last empty slot. Rehashes in
+  // place of tombstones if they make up a large part of the table, and grows
+  // otherwise.
+  void Grow() {
+    if (capacity_ != 0 && size_ <= MaxLoad(capacity_) / 2) {
+      Resize(capacity_);
+    } else {
+      Resize(capacity_ == 0 ? kGroupWidth : capacity_ * 2);
+    }
+  }
+
+  void Resize(size_t new_capacity) {
+    std::unique_ptr<uint8[]> old_ctrl = std::move(ctrl_);
+    value_type* old_slots = slots_;
+    size_t old_capacity = capacity_;
+
+    ctrl_.reset(new uint8[new_capacity]);
+    std::fill(ctrl_.get(), ctrl_.get() + new_capacity, kEmpty);
+    slots_ = std::allocator<value_type>().allocate(new_capacity);
+    capacity_ = new_capacity;
+    size_ = 0;
+    growth_left_ = MaxLoad(new_capacity);
+
+    for (size_t i = 0; i < old_capacity; i++) {
+      if (IsFull(old_ctrl[i])) {
+        size_t hash = hash_(Policy::Key(old_slots[i]));
+        size_t index = FindInsertPosition(hash);
+        new (&slots_[index]) value_type(std::move(old_slots[i]));
+        SetCtrl(index, hash);
+        old_slots[i].~value_type();
+      }
+    }
+    if (old_slots != nullptr) {
+      std::allocator<value_type>().deallocate(old_slots, old_capacity);
+    }
+  }
+
+  // Inserts a copy of a value known to be absent.
+  void InsertUnique(const value_type& value) {
+    size_t hash = hash_(Policy::Key(value));
+    size_t index = FindInsertPosition(hash);
+    new (&slots_[index]) value_type(value);
+    SetCtrl(index, hash);
+  }
+
+  void StealFrom(RawHashSet* other) {
+    ctrl_ = std::move(other->ctrl_);
+    slots_ = other->slots_;
+    capacity_ = other->capacity_;
+    size_ = other->size_;
+    growth_left_ = other->growth_left_;
+    other->slots_ = nullptr;
+    other->capacity_ = 0;
+    other->size_ = 0;
+    other->growth_left_ = 0;
+  }
+
+  void Destroy() {
+    if (slots_ == nullptr) return;
+    for (size_t i = 0; i < capacity_; i++) {
+      if (IsFull(ctrl_[i])) slots_[i].~value_type();
+    }
+    std::allocator<value_type>().deallocate(slots_, capacity_);
+    slots_ = nullptr;
+    ctrl_.reset();
+    capacity_ = 0;
+    size_ = 0;
+    growth_left_ = 0;
+  }
+
+  std::unique_ptr<uint8[]> ctrl_;
+  value_type* slots_ = nullptr;
+  size_t capacity_ = 0;
+  size_t size_ = 0;
+  // The number of kEmpty slots that may still be filled before the load
+  // factor exceeds 7/8.
+  size_t growth_left_ = 0;
+  hasher hash_;
+  key_equal eq_;
+};
+
+}  // namespace detail
+
+// A hash set of unique keys. The interface is a subset of std::unordered_set.
+template <typename K, typename Hasher = Hash<K>,
+          typename KeyEqual = std::equal_to<K>>
+class flat_hash_set
+    : public detail::RawHashSet<detail::SetPolicy<K>, Hasher, KeyEqual> {
+  using Base = detail::RawHashSet<detail::SetPolicy<K>, Hasher, KeyEqual>;
+
+ public:
+  using typename Base::iterator;
+  using typename Base::value_type;
+
+  using Base::Base;
+
+  flat_hash_set() = default;
+
+  flat_hash_set(std::initializer_list<value_type> values) {
+    this->reserve(values.size());
+    for (const value_type& value : values) insert(value);
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return this->EmplaceWithKey(value, value);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return this->EmplaceWithKey(value, std::move(value));
+  }
+};
+
+// A hash map with unique keys. The interface is a subset of
+// std::unordered_map.
+template <typename K, typename V, typename Hasher = Hash<K>,
+          typename KeyEqual = std::equal_to<K>>
+class flat_hash_map
+    : public detail::RawHashSet<detail::MapPolicy<K, V>, Hasher, KeyEqual> {
+  using Base = detail::RawHashSet<detail::MapPolicy<K, V>, Hasher, KeyEqual>;
+
+ public:
+  using typename Base::iterator;
+  using typename Base::key_type;
+  using typename Base::value_type;
+  using mapped_type = V;
+
+  using Base::Base;
+
+  flat_hash_map() = default;
+
+  flat_hash_map(std::initializer_list<value_type> values) {
+    this->reserve(values.size());
+    for (const value_type& value : values) insert(value);
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return this->EmplaceWithKey(value.first, value);
+  }
+
+  // Inserts {key, V(args...)} if `key` is absent; does nothing otherwise.
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args) {
+    return this->EmplaceWithKey(
+        key, std::piecewise_construct, std::forward_as_tuple(key),
+        std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+
+  mapped_type& operator[](const key_type& key) {
+    return try_emplace(key).first->second;
+  }
+};
+
+}  // namespace containers
+}  // namespace dimsum
+
+#endif  // DIMSUM_DIMSUM_CONTAINERS_H_
@@ -0,0 +1,92 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "dimsum_containers.h"
+
+namespace dimsum {
+namespace {
+
+using FlatMap = containers::flat_hash_map<uint64, uint64>;
+using StdMap = std::unordered_map<uint64, uint64>;
+
+// Benchmarks lookups in a map with state.range(0) entries, where
+// state.range(1) percent of the lookups hit.
+template <typename Map>
+void BM_Lookup(benchmark::State& state) {
+  const size_t num_entries = state.range(0);
+  const int hit_percent = state.range(1);
+  std::mt19937_64 rng(42);
+  Map map;
+  std::vector<uint64> present;
+  while (map.size() < num_entries) {
+    uint64 key = rng();
+    if (map.insert({key, key}).second) present.push_back(key);
+  }
+
+  std::vector<uint64> queries(1 << 12);
+  for (uint64& query : queries) {
+    if (static_cast<int>(rng() % 100) < hit_percent) {
+      query = present[rng() % present.size()];
+    } else {
+      // Odds of hitting a present key by chance are negligible.
+      query = rng();
+    }
+  }
+
+  for (auto _ : state) {
+    uint64 sum = 0;
+    for (uint64 query : queries) {
+      auto it = map.find(query);
+      if (it != map.end()) sum += it->second;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+void LookupArgs(benchmark::internal::Benchmark* b) {
+  for (int num_entries : {1 << 10, 1 << 16, 1 << 20}) {
+    for (int hit_percent : {0, 50, 100}) {
+      b->Args({num_entries, hit_percent});
+    }
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_Lookup, FlatMap)->Apply(LookupArgs);
+BENCHMARK_TEMPLATE(BM_Lookup, StdMap)->Apply(LookupArgs);
+
+template <typename Map>
+void BM_Insert(benchmark::State& state) {
+  const size_t num_entries = state.range(0);
+  std::mt19937_64 rng(42);
+  std::vector<uint64> keys(num_entries);
+  for (uint64& key : keys) key = rng();
+
+  for (auto _ : state) {
+    Map map;
+    for (uint64 key : keys) map[key] = key;
+    benchmark::DoNotOptimize(map.size());
+  }
+  state.SetItemsProcessed(state.iterations() * num_entries);
+}
+BENCHMARK_TEMPLATE(BM_Insert, FlatMap)->Arg(1 << 10)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_Insert, StdMap)->Arg(1 << 10)->Arg(1 << 16);
+
+}  // namespace
+}  // namespace dimsum
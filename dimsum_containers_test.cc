@@ -0,0 +1,161 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dimsum_containers.h"
+
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace containers {
+namespace {
+
+TEST(DimsumContainersTest, MatchByte) {
+  uint8 ctrl[detail::kGroupWidth];
+  for (size_t i = 0; i < detail::kGroupWidth; i++) {
+    ctrl[i] = i % 3 == 0 ? detail::kEmpty : i % 3 == 1 ? 5 : detail::kDeleted;
+  }
+  detail::Group group(ctrl, flags::element_aligned);
+  uint32 expected_empty = 0, expected_5 = 0, expected_not_full = 0;
+  for (size_t i = 0; i < detail::kGroupWidth; i++) {
+    if (ctrl[i] == detail::kEmpty) expected_empty |= 1u << i;
+    if (ctrl[i] == 5) expected_5 |= 1u << i;
+    if (!detail::IsFull(ctrl[i])) expected_not_full |= 1u << i;
+  }
+  EXPECT_EQ(expected_empty, detail::MatchEmpty(group));
+  EXPECT_EQ(expected_5, detail::MatchByte(group, 5));
+  EXPECT_EQ(expected_not_full, detail::MatchEmptyOrDeleted(group));
+}
+
+TEST(DimsumContainersTest, SetBasic) {
+  flat_hash_set<int> set;
+  EXPECT_TRUE(set.empty());
+  EXPECT_EQ(set.end(), set.find(1));
+  EXPECT_TRUE(set.insert(1).second);
+  EXPECT_FALSE(set.insert(1).second);
+  EXPECT_TRUE(set.insert(2).second);
+  EXPECT_EQ(2, set.size());
+  EXPECT_TRUE(set.contains(1));
+  EXPECT_EQ(2, *set.find(2));
+  EXPECT_EQ(0, set.count(3));
+  EXPECT_EQ(1, set.erase(1));
+  EXPECT_EQ(0, set.erase(1));
+  EXPECT_FALSE(set.contains(1));
+  EXPECT_EQ(1, set.size());
+  set.clear();
+  EXPECT_TRUE(set.empty());
+  EXPECT_EQ(set.begin(), set.end());
+}
+
+TEST(DimsumContainersTest, MapBasic) {
+  flat_hash_map<std::string, int> map = {{"a", 1}, {"b", 2}};
+  EXPECT_EQ(2, map.size());
+  EXPECT_EQ(1, map["a"]);
+  map["c"] += 3;
+  EXPECT_EQ(3, map.find("c")->second);
+  EXPECT_FALSE(map.insert({"a", 10}).second);
+  EXPECT_EQ(1, map["a"]);
+  EXPECT_TRUE(map.try_emplace("d", 4).second);
+  EXPECT_EQ(4, map.size());
+
+  int sum = 0;
+  for (const auto& entry : map) sum += entry.second;
+  EXPECT_EQ(10, sum);
+}
+
+// Compares against std::unordered_map under random inserts and erases, which
+// exercises growth, tombstones and in-place rehashing.
+template <typename Hasher>
+void TestRandomOperations() {
+  std::mt19937 rng(42);
+  flat_hash_map<uint64, uint64, Hasher> map;
+  std::unordered_map<uint64, uint64> expected;
+  for (int i = 0; i < 20000; i++) {
+    uint64 key = rng() % 2000;
+    switch (rng() % 3) {
+      case 0:
+      case 1:
+        map[key] = i;
+        expected[key] = i;
+        break;
+      case 2:
+        EXPECT_EQ(expected.erase(key), map.erase(key));
+        break;
+    }
+    ASSERT_EQ(expected.size(), map.size());
+  }
+  for (uint64 key = 0; key < 2000; key++) {
+    auto it = map.find(key);
+    if (expected.count(key)) {
+      ASSERT_NE(map.end(), it) << key;
+      EXPECT_EQ(expected[key], it->second);
+    } else {
+      EXPECT_EQ(map.end(), it) << key;
+    }
+  }
+  size_t count = 0;
+  for (const auto& entry : map) {
+    EXPECT_EQ(expected[entry.first], entry.second);
+    count++;
+  }
+  EXPECT_EQ(expected.size(), count);
+}
+
+// All keys share a group and a control byte, so every lookup walks the whole
+// probe sequence.
+struct CollidingHash {
+  size_t operator()(uint64) const { return 0; }
+};
+
+TEST(DimsumContainersTest, RandomOperations) {
+  TestRandomOperations<Hash<uint64>>();
+  TestRandomOperations<CollidingHash>();
+}
+
+TEST(DimsumContainersTest, CopyAndMove) {
+  flat_hash_set<int> set;
+  for (int i = 0; i < 100; i++) set.insert(i);
+
+  flat_hash_set<int> copy = set;
+  EXPECT_EQ(100, copy.size());
+  copy.erase(0);
+  EXPECT_TRUE(set.contains(0));
+  EXPECT_FALSE(copy.contains(0));
+
+  flat_hash_set<int> moved = std::move(copy);
+  EXPECT_EQ(99, moved.size());
+  EXPECT_TRUE(moved.contains(99));
+
+  copy = moved;
+  EXPECT_EQ(99, copy.size());
+  moved = std::move(set);
+  EXPECT_EQ(100, moved.size());
+}
+
+TEST(DimsumContainersTest, Reserve) {
+  flat_hash_set<int> set;
+  set.reserve(1000);
+  size_t capacity = set.capacity();
+  EXPECT_GE(capacity, 1000);
+  for (int i = 0; i < 1000; i++) set.insert(i);
+  EXPECT_EQ(capacity, set.capacity());
+}
+
+}  // namespace
+}  // namespace containers
+}  // namespace dimsum
@@ -0,0 +1,321 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_DIMSUM_CONVOLVE_H_
+#define DIMSUM_DIMSUM_CONVOLVE_H_
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "dimsum.h"
+
+// FIR filters and 2D image convolutions.
+//
+// All functions compute the "valid" part of the convolution: an output
+// element is produced only where the kernel fits entirely inside the input,
+// so n inputs filtered with k taps give n - k + 1 outputs. The kernel is
+// flipped, as in a true convolution; symmetric kernels are unaffected.
+//
+// Supported element types are float and double, accumulated with fma, and
+// int16 and int32, accumulated in int32. int16 taps are applied two at a time
+// with mul_sum, so each int32 lane of an accumulator sums the products of a
+// pair of adjacent inputs. Integer results wrap around modulo 2**32.
+//
+// The inner loop keeps a block of outputs in registers and, for each tap,
+// multiplies the broadcast tap by the inputs loaded at the tap's offset (the
+// sliding window), so no input is shuffled. Images are processed in column
+// strips narrow enough for the input rows that a kernel spans to stay in L1
+// from one output row to the next. convolve_2d_separable filters tiles of the
+// rows into an L1-sized buffer and then filters the buffer's columns.
+
+namespace dimsum {
+namespace detail {
+
+// Defines the accumulator type and the multiply-accumulate step for an
+// element type. Sum is the type of scalar sums, unsigned for integers so that
+// they wrap around like the vector ones.
+template <typename T, typename Abi>
+struct ConvolveTraits;
+
+template <typename Abi>
+struct ConvolveTraits<float, Abi> {
+  using Acc = float;
+  using Sum = float;
+  static Simd<float, Abi> MulAdd(Simd<float, Abi> acc, Simd<float, Abi> a,
+                                 Simd<float, Abi> b) {
+    return fma(a, b, acc);
+  }
+};
+
+template <typename Abi>
+struct ConvolveTraits<double, Abi> {
+  using Acc = double;
+  using Sum = double;
+  static Simd<double, Abi> MulAdd(Simd<double, Abi> acc, Simd<double, Abi> a,
+                                  Simd<double, Abi> b) {
+    return fma(a, b, acc);
+  }
+};
+
+template <typename Abi>
+struct ConvolveTraits<int16, Abi> {
+  using Acc = int32;
+  using Sum = uint32;
+  static Simd<int32, Abi> MulAdd(Simd<int32, Abi> acc, Simd<int16, Abi> a,
+                                 Simd<int16, Abi> b) {
+    return mul_sum(a, b, acc);
+  }
+};
+
+template <typename Abi>
+struct ConvolveTraits<int32, Abi> {
+  using Acc = int32;
+  using Sum = uint32;
+  static Simd<int32, Abi> MulAdd(Simd<int32, Abi> acc, Simd<int32, Abi> a,
+                                 Simd<int32, Abi> b) {
+    return acc + a * b;
+  }
+};
+
+// Correlates rows of T with a kernel and writes rows of Acc.
+//
+// Taps are applied in groups of kGroup adjacent ones, the number of products
+// that one accumulator lane sums per step (2 for mul_sum, 1 for fma). A
+// block of outputs is held in kUnits units of kGroup accumulators each: lane
+// j of accumulator p of a unit starting at output i holds output
+// i + kGroup * j + p, so the inputs of every accumulator are one contiguous
+// load per group of taps, and the accumulators of a unit are interleaved
+// when they are stored.
+template <typename T, typename Abi>
+struct ConvolveKernel {
+  using Traits = ConvolveTraits<T, Abi>;
+  using Acc = typename Traits::Acc;
+  using AccSimd = Simd<Acc, Abi>;
+  using InSimd = Simd<T, Abi>;
+
+  static constexpr size_t kGroup = sizeof(Acc) / sizeof(T);
+  static constexpr size_t kLanes = AccSimd::size();
+  static constexpr size_t kUnits = 8 / kGroup;
+  static constexpr size_t kUnitSize = kGroup * kLanes;
+
+  // A correlation kernel of `rows` x `cols` taps. Each row is padded with
+  // zeros to `groups` * kGroup taps, and every group is also packed into one
+  // Acc-sized word, ready to be broadcast.
+  struct Taps {
+    size_t rows;
+    size_t cols;
+    size_t groups;
+    std::vector<T> values;
+    std::vector<Acc> words;
+  };
+
+  // Returns the correlation kernel equivalent to convolving with the
+  // row-major `rows` x `cols` kernel, i.e. the kernel rotated by 180 degrees.
+  static Taps Flip(const T* kernel, size_t rows, size_t cols) {
+    Taps taps;
+    taps.rows = rows;
+    taps.cols = cols;
+    taps.groups = (cols + kGroup - 1) / kGroup;
+    taps.values.assign(rows * taps.groups * kGroup, T{0});
+    for (size_t r = 0; r < rows; r++) {
+      for (size_t c = 0; c < cols; c++) {
+        taps.values[r * taps.groups * kGroup + c] =
+            kernel[(rows - 1 - r) * cols + cols - 1 - c];
+      }
+    }
+    taps.words.resize(rows * taps.groups);
+    memcpy(taps.words.data(), taps.values.data(),
+           taps.words.size() * sizeof(Acc));
+    return taps;
+  }
+
+  // out[i] = sum(taps[r][c] * in[r * stride + i + c]) for i in [0, count).
+  // Each of the taps.rows rows of `in` holds count + taps.cols - 1 elements.
+  static void Correlate(const T* in, size_t stride, const Taps& taps,
+                        size_t count, Acc* out) {
+    // The loads of the padding taps must not pass the end of the rows.
+    const size_t limit = count + taps.cols - taps.groups * kGroup;
+    size_t i = 0;
+    for (; i + kUnits * kUnitSize <= limit; i += kUnits * kUnitSize) {
+      Block(in + i, stride, taps, out + i, make_index_sequence<kUnits>(),
+            make_index_sequence<kUnits * kGroup>());
+    }
+    for (; i + kUnitSize <= limit; i += kUnitSize) {
+      Block(in + i, stride, taps, out + i, make_index_sequence<1>(),
+            make_index_sequence<kGroup>());
+    }
+    for (; i < count; i++) {
+      typename Traits::Sum sum = 0;
+      for (size_t r = 0; r < taps.rows; r++) {
+        const T* row = taps.values.data() + r * taps.groups * kGroup;
+        for (size_t c = 0; c < taps.cols; c++) {
+          sum += static_cast<typename Traits::Sum>(row[c]) *
+                 static_cast<typename Traits::Sum>(in[r * stride + i + c]);
+        }
+      }
+      out[i] = static_cast<Acc>(sum);
+    }
+  }
+
+  // Accumulator kAcc belongs to unit kAcc / kGroup and holds the outputs
+  // congruent to kAcc % kGroup modulo kGroup. The packs are expanded so that
+  // every index is a constant and the accumulators can live in registers.
+  template <size_t... kUnit, size_t... kAcc>
+  static void Block(const T* in, size_t stride, const Taps& taps, Acc* out,
+                    index_sequence<kUnit...>, index_sequence<kAcc...>) {
+    AccSimd acc[] = {(static_cast<void>(kAcc), AccSimd(0))...};
+    const Acc* word = taps.words.data();
+    for (size_t r = 0; r < taps.rows; r++, in += stride) {
+      for (size_t g = 0; g < taps.groups; g++) {
+        InSimd tap = bit_cast<T>(AccSimd(*word++));
+        const T* window = in + g * kGroup;
+        int expand[] = {
+            (acc[kAcc] = Traits::MulAdd(
+                 acc[kAcc],
+                 InSimd(window + kAcc / kGroup * kUnitSize + kAcc % kGroup,
+                        flags::element_aligned),
+                 tap),
+             0)...};
+        static_cast<void>(expand);
+      }
+    }
+    int store[] = {(StoreUnit(acc + kUnit * kGroup, out + kUnit * kUnitSize,
+                              std::integral_constant<size_t, kGroup>()),
+                    0)...};
+    static_cast<void>(store);
+  }
+
+  static void StoreUnit(const AccSimd* acc, Acc* out,
+                        std::integral_constant<size_t, 1>) {
+    acc[0].memstore(out, flags::element_aligned);
+  }
+
+  static void StoreUnit(const AccSimd* acc, Acc* out,
+                        std::integral_constant<size_t, 2>) {
+    zip_lo(acc[0], acc[1]).memstore(out, flags::element_aligned);
+    zip_hi(acc[0], acc[1]).memstore(out + kLanes, flags::element_aligned);
+  }
+};
+
+template <typename T, typename Abi>
+constexpr size_t ConvolveKernel<T, Abi>::kGroup;
+template <typename T, typename Abi>
+constexpr size_t ConvolveKernel<T, Abi>::kLanes;
+template <typename T, typename Abi>
+constexpr size_t ConvolveKernel<T, Abi>::kUnits;
+template <typename T, typename Abi>
+constexpr size_t ConvolveKernel<T, Abi>::kUnitSize;
+
+// The number of outputs per row in a column strip of convolve_2d, and in a
+// tile of convolve_2d_separable, which also has kConvolveTileRows rows. With
+// 4-byte elements and 5x5 kernels, a strip of input rows takes 20KB, and the
+// row-filtered tile 20KB.
+constexpr size_t kConvolveTileCols = 256;
+constexpr size_t kConvolveTileRows = 16;
+
+}  // namespace detail
+
+// Filters the `size` samples of `input` with the FIR filter `taps`:
+//   output[i] = sum(taps[k] * input[i + num_taps - 1 - k])
+// for i in [0, size - num_taps + 1). Requires 0 < num_taps <= size.
+//
+// Abi selects the vector width; Acc is float for float, double for double
+// and int32 for int16 and int32.
+template <typename Abi = NativeSimd<int32>::abi_type, typename T,
+          typename Acc>
+void convolve_1d(const T* input, size_t size, const T* taps, size_t num_taps,
+                 Acc* output) {
+  using Kernel = detail::ConvolveKernel<T, Abi>;
+  static_assert(std::is_same<Acc, typename Kernel::Acc>::value,
+                "The output must have the accumulator type of the input");
+  Kernel::Correlate(input, 0, Kernel::Flip(taps, 1, num_taps),
+                    size - num_taps + 1, output);
+}
+
+// Convolves the `rows` x `cols` image `input` with the `kernel_rows` x
+// `kernel_cols` kernel, both row-major, and writes the
+// (rows - kernel_rows + 1) x (cols - kernel_cols + 1) result to `output`:
+//   output[y][x] = sum(kernel[r][c] *
+//                      input[y + kernel_rows - 1 - r][x + kernel_cols - 1 - c])
+// The images have input_stride and output_stride elements between rows.
+// Requires 0 < kernel_rows <= rows and 0 < kernel_cols <= cols.
+template <typename Abi = NativeSimd<int32>::abi_type, typename T,
+          typename Acc>
+void convolve_2d(size_t rows, size_t cols, const T* input,
+                 size_t input_stride, const T* kernel, size_t kernel_rows,
+                 size_t kernel_cols, Acc* output, size_t output_stride) {
+  using Kernel = detail::ConvolveKernel<T, Abi>;
+  static_assert(std::is_same<Acc, typename Kernel::Acc>::value,
+                "The output must have the accumulator type of the input");
+  const auto taps = Kernel::Flip(kernel, kernel_rows, kernel_cols);
+  const size_t out_rows = rows - kernel_rows + 1;
+  const size_t out_cols = cols - kernel_cols + 1;
+  for (size_t x = 0; x < out_cols; x += detail::kConvolveTileCols) {
+    const size_t width = std::min(detail::kConvolveTileCols, out_cols - x);
+    for (size_t y = 0; y < out_rows; y++) {
+      Kernel::Correlate(input + y * input_stride + x, input_stride, taps,
+                        width, output + y * output_stride + x);
+    }
+  }
+}
+
+// Like convolve_2d with the kernel col_taps * row_taps^T: filters the rows
+// of `input` with the `num_row_taps` taps of row_taps, then the columns of
+// the result with the `num_col_taps` taps of col_taps. This takes
+// num_row_taps + num_col_taps multiply-adds per output instead of their
+// product. int16 images are row-filtered into int32 and column-filtered
+// in int32.
+template <typename Abi = NativeSimd<int32>::abi_type, typename T,
+          typename Acc>
+void convolve_2d_separable(size_t rows, size_t cols, const T* input,
+                           size_t input_stride, const T* row_taps,
+                           size_t num_row_taps, const T* col_taps,
+                           size_t num_col_taps, Acc* output,
+                           size_t output_stride) {
+  using RowKernel = detail::ConvolveKernel<T, Abi>;
+  using ColKernel = detail::ConvolveKernel<Acc, Abi>;
+  static_assert(std::is_same<Acc, typename RowKernel::Acc>::value,
+                "The output must have the accumulator type of the input");
+  const auto row_kernel = RowKernel::Flip(row_taps, 1, num_row_taps);
+  std::vector<Acc> wide_col_taps(col_taps, col_taps + num_col_taps);
+  const auto col_kernel =
+      ColKernel::Flip(wide_col_taps.data(), num_col_taps, 1);
+  const size_t out_rows = rows - num_col_taps + 1;
+  const size_t out_cols = cols - num_row_taps + 1;
+  const size_t tile_stride = detail::kConvolveTileCols;
+  std::vector<Acc> tile((detail::kConvolveTileRows + num_col_taps - 1) *
+                        tile_stride);
+  for (size_t x = 0; x < out_cols; x += detail::kConvolveTileCols) {
+    const size_t width = std::min(detail::kConvolveTileCols, out_cols - x);
+    for (size_t y = 0; y < out_rows; y += detail::kConvolveTileRows) {
+      const size_t height = std::min(detail::kConvolveTileRows, out_rows - y);
+      for (size_t r = 0; r < height + num_col_taps - 1; r++) {
+        RowKernel::Correlate(input + (y + r) * input_stride + x, 0,
+                             row_kernel, width, &tile[r * tile_stride]);
+      }
+      for (size_t r = 0; r < height; r++) {
+        ColKernel::Correlate(&tile[r * tile_stride], tile_stride, col_kernel,
+                             width, output + (y + r) * output_stride + x);
+      }
+    }
+  }
+}
+
+}  // namespace dimsum
+
+#endif  // DIMSUM_DIMSUM_CONVOLVE_H_
@@ -0,0 +1,147 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "dimsum_convolve.h"
+
+namespace dimsum {
+namespace {
+
+template <typename T>
+using AccOf = typename detail::ConvolveTraits<T, Simd128<int32>::abi_type>::Acc;
+
+template <typename T>
+std::vector<T> MakeValues(size_t size) {
+  std::vector<T> values(size);
+  for (size_t i = 0; i < size; i++) {
+    values[i] = static_cast<T>(i * 7 % 13);
+  }
+  return values;
+}
+
+// Arguments of the image benchmarks: columns, rows and the kernel size.
+void ImageSizes(benchmark::internal::Benchmark* b) {
+  for (int kernel : {3, 5}) {
+    b->Args({1920, 1080, kernel});
+    b->Args({3840, 2160, kernel});
+  }
+}
+
+template <typename T>
+void BM_Convolve2dScalar(benchmark::State& state) {
+  const size_t cols = state.range(0), rows = state.range(1);
+  const size_t k = state.range(2);
+  auto input = MakeValues<T>(rows * cols);
+  auto kernel = MakeValues<T>(k * k);
+  const size_t out_rows = rows - k + 1, out_cols = cols - k + 1;
+  std::vector<AccOf<T>> output(out_rows * out_cols);
+  for (auto _ : state) {
+    for (size_t y = 0; y < out_rows; y++) {
+      for (size_t x = 0; x < out_cols; x++) {
+        AccOf<T> sum = 0;
+        for (size_t r = 0; r < k; r++) {
+          for (size_t c = 0; c < k; c++) {
+            sum += kernel[r * k + c] *
+                   input[(y + k - 1 - r) * cols + x + k - 1 - c];
+          }
+        }
+        output[y * out_cols + x] = sum;
+      }
+    }
+    benchmark::DoNotOptimize(output.data());
+  }
+  state.SetItemsProcessed(state.iterations() * out_rows * out_cols);
+}
+
+template <typename T>
+void BM_Convolve2d(benchmark::State& state) {
+  const size_t cols = state.range(0), rows = state.range(1);
+  const size_t k = state.range(2);
+  auto input = MakeValues<T>(rows * cols);
+  auto kernel = MakeValues<T>(k * k);
+  const size_t out_rows = rows - k + 1, out_cols = cols - k + 1;
+  std::vector<AccOf<T>> output(out_rows * out_cols);
+  for (auto _ : state) {
+    convolve_2d(rows, cols, input.data(), cols, kernel.data(), k, k,
+                output.data(), out_cols);
+    benchmark::DoNotOptimize(output.data());
+  }
+  state.SetItemsProcessed(state.iterations() * out_rows * out_cols);
+}
+
+template <typename T>
+void BM_Convolve2dSeparable(benchmark::State& state) {
+  const size_t cols = state.range(0), rows = state.range(1);
+  const size_t k = state.range(2);
+  auto input = MakeValues<T>(rows * cols);
+  auto taps = MakeValues<T>(k);
+  const size_t out_rows = rows - k + 1, out_cols = cols - k + 1;
+  std::vector<AccOf<T>> output(out_rows * out_cols);
+  for (auto _ : state) {
+    convolve_2d_separable(rows, cols, input.data(), cols, taps.data(), k,
+                          taps.data(), k, output.data(), out_cols);
+    benchmark::DoNotOptimize(output.data());
+  }
+  state.SetItemsProcessed(state.iterations() * out_rows * out_cols);
+}
+
+BENCHMARK_TEMPLATE(BM_Convolve2dScalar, float)->Apply(ImageSizes);
+BENCHMARK_TEMPLATE(BM_Convolve2d, float)->Apply(ImageSizes);
+BENCHMARK_TEMPLATE(BM_Convolve2dSeparable, float)->Apply(ImageSizes);
+BENCHMARK_TEMPLATE(BM_Convolve2dScalar, int16)->Apply(ImageSizes);
+BENCHMARK_TEMPLATE(BM_Convolve2d, int16)->Apply(ImageSizes);
+BENCHMARK_TEMPLATE(BM_Convolve2dSeparable, int16)->Apply(ImageSizes);
+
+// The argument is the number of taps of a filter applied to 64K samples.
+template <typename T>
+void BM_Convolve1dScalar(benchmark::State& state) {
+  const size_t size = 1 << 16, num_taps = state.range(0);
+  auto input = MakeValues<T>(size);
+  auto taps = MakeValues<T>(num_taps);
+  std::vector<AccOf<T>> output(size - num_taps + 1);
+  for (auto _ : state) {
+    for (size_t i = 0; i < output.size(); i++) {
+      AccOf<T> sum = 0;
+      for (size_t k = 0; k < num_taps; k++) {
+        sum += taps[k] * input[i + num_taps - 1 - k];
+      }
+      output[i] = sum;
+    }
+    benchmark::DoNotOptimize(output.data());
+  }
+  state.SetItemsProcessed(state.iterations() * output.size());
+}
+
+template <typename T>
+void BM_Convolve1d(benchmark::State& state) {
+  const size_t size = 1 << 16, num_taps = state.range(0);
+  auto input = MakeValues<T>(size);
+  auto taps = MakeValues<T>(num_taps);
+  std::vector<AccOf<T>> output(size - num_taps + 1);
+  for (auto _ : state) {
+    convolve_1d(input.data(), size, taps.data(), num_taps, output.data());
+    benchmark::DoNotOptimize(output.data());
+  }
+  state.SetItemsProcessed(state.iterations() * output.size());
+}
+
+BENCHMARK_TEMPLATE(BM_Convolve1dScalar, float)->Arg(8)->Arg(32)->Arg(128);
+BENCHMARK_TEMPLATE(BM_Convolve1d, float)->Arg(8)->Arg(32)->Arg(128);
+BENCHMARK_TEMPLATE(BM_Convolve1dScalar, int16)->Arg(8)->Arg(32)->Arg(128);
+BENCHMARK_TEMPLATE(BM_Convolve1d, int16)->Arg(8)->Arg(32)->Arg(128);
+
+}  // namespace
+}  // namespace dimsum
@@ -0,0 +1,181 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dimsum_convolve.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+template <typename T>
+using AccOf = typename detail::ConvolveTraits<T, Simd128<int32>::abi_type>::Acc;
+
+// Small values, so that float sums are exact whatever the order of the
+// additions. For int16, `full_range` spreads the values over all of int16 to
+// exercise the wraparound of the sums.
+template <typename T>
+std::vector<T> MakeValues(size_t size, size_t seed, bool full_range = false) {
+  std::vector<T> values(size);
+  for (size_t i = 0; i < size; i++) {
+    size_t hash = (i + seed) * 2654435761u;
+    values[i] = full_range ? static_cast<T>(hash >> 8)
+                           : static_cast<T>(static_cast<int>(hash >> 16 & 15) -
+                                            7);
+  }
+  return values;
+}
+
+// output[y][x] = sum(kernel[r][c] * input[y + kr - 1 - r][x + kc - 1 - c]),
+// with integer sums computed modulo 2**32.
+template <typename T>
+std::vector<AccOf<T>> Reference(size_t rows, size_t cols, const T* input,
+                                size_t stride, const T* kernel, size_t kr,
+                                size_t kc) {
+  using Sum = typename detail::ConvolveTraits<T, Simd128<int32>::abi_type>::Sum;
+  const size_t out_rows = rows - kr + 1, out_cols = cols - kc + 1;
+  std::vector<AccOf<T>> output(out_rows * out_cols);
+  for (size_t y = 0; y < out_rows; y++) {
+    for (size_t x = 0; x < out_cols; x++) {
+      Sum sum = 0;
+      for (size_t r = 0; r < kr; r++) {
+        for (size_t c = 0; c < kc; c++) {
+          sum += static_cast<Sum>(kernel[r * kc + c]) *
+                 static_cast<Sum>(
+                     input[(y + kr - 1 - r) * stride + x + kc - 1 - c]);
+        }
+      }
+      output[y * out_cols + x] = static_cast<AccOf<T>>(sum);
+    }
+  }
+  return output;
+}
+
+template <typename T>
+void TestConvolve1d(bool full_range) {
+  using Acc = AccOf<T>;
+  const Acc kSentinel = 12345;
+  for (size_t num_taps = 1; num_taps <= 9; num_taps++) {
+    for (size_t size = num_taps; size < 300; size += 1 + size / 8) {
+      auto input = MakeValues<T>(size, size, full_range);
+      auto taps = MakeValues<T>(num_taps, 7 * num_taps, full_range);
+      const size_t out_size = size - num_taps + 1;
+      std::vector<Acc> output(out_size + 1, kSentinel);
+      convolve_1d(input.data(), size, taps.data(), num_taps, output.data());
+      auto expected =
+          Reference(1, size, input.data(), size, taps.data(), 1, num_taps);
+      for (size_t i = 0; i < out_size; i++) {
+        ASSERT_EQ(expected[i], output[i])
+            << size << " samples, " << num_taps << " taps, at " << i;
+      }
+      EXPECT_EQ(kSentinel, output[out_size]);
+    }
+  }
+}
+
+TEST(ConvolveTest, Convolve1dInt16) {
+  TestConvolve1d<int16>(false);
+  TestConvolve1d<int16>(true);
+}
+
+TEST(ConvolveTest, Convolve1dInt32) { TestConvolve1d<int32>(false); }
+
+TEST(ConvolveTest, Convolve1dFloat) { TestConvolve1d<float>(false); }
+
+TEST(ConvolveTest, Convolve1dDouble) { TestConvolve1d<double>(false); }
+
+TEST(ConvolveTest, Convolve1dFlipsTaps) {
+  const float input[] = {1, 2, 3, 4};
+  const float taps[] = {1, 10};
+  float output[3];
+  convolve_1d(input, 4, taps, 2, output);
+  EXPECT_EQ(12, output[0]);
+  EXPECT_EQ(23, output[1]);
+  EXPECT_EQ(34, output[2]);
+}
+
+// The output is padded to output_stride = out_cols + 2, and filled with a
+// sentinel to catch writes outside the result.
+template <typename T>
+void TestConvolve2d(size_t rows, size_t cols, size_t kr, size_t kc) {
+  using Acc = AccOf<T>;
+  const Acc kSentinel = 12345;
+  const size_t stride = cols + 3;
+  auto input = MakeValues<T>(rows * stride, rows + cols);
+  auto kernel = MakeValues<T>(kr * kc, kr * 16 + kc);
+  const size_t out_rows = rows - kr + 1, out_cols = cols - kc + 1;
+  const size_t out_stride = out_cols + 2;
+  auto expected = Reference(rows, cols, input.data(), stride, kernel.data(),
+                            kr, kc);
+
+  std::vector<Acc> output(out_rows * out_stride, kSentinel);
+  convolve_2d(rows, cols, input.data(), stride, kernel.data(), kr, kc,
+              output.data(), out_stride);
+  for (size_t y = 0; y < out_rows; y++) {
+    for (size_t x = 0; x < out_stride; x++) {
+      Acc want = x < out_cols ? expected[y * out_cols + x] : kSentinel;
+      ASSERT_EQ(want, output[y * out_stride + x])
+          << rows << "x" << cols << " by " << kr << "x" << kc << " at " << y
+          << ", " << x;
+    }
+  }
+
+  // The same kernel, as the product of a column and a row.
+  auto row_taps = MakeValues<T>(kc, kc);
+  auto col_taps = MakeValues<T>(kr, kr + 5);
+  for (size_t r = 0; r < kr; r++) {
+    for (size_t c = 0; c < kc; c++) {
+      kernel[r * kc + c] = col_taps[r] * row_taps[c];
+    }
+  }
+  expected = Reference(rows, cols, input.data(), stride, kernel.data(), kr,
+                       kc);
+  std::fill(output.begin(), output.end(), kSentinel);
+  convolve_2d_separable(rows, cols, input.data(), stride, row_taps.data(), kc,
+                        col_taps.data(), kr, output.data(), out_stride);
+  for (size_t y = 0; y < out_rows; y++) {
+    for (size_t x = 0; x < out_stride; x++) {
+      Acc want = x < out_cols ? expected[y * out_cols + x] : kSentinel;
+      ASSERT_EQ(want, output[y * out_stride + x])
+          << "separable " << rows << "x" << cols << " by " << kr << "x" << kc
+          << " at " << y << ", " << x;
+    }
+  }
+}
+
+template <typename T>
+void TestConvolve2dShapes() {
+  const size_t kernels[][2] = {{1, 1}, {3, 3}, {5, 5}, {2, 7}, {7, 2}};
+  const size_t sizes[] = {7, 17, 40, 300};
+  for (const auto& kernel : kernels) {
+    for (size_t rows : sizes) {
+      for (size_t cols : sizes) {
+        TestConvolve2d<T>(rows, cols, kernel[0], kernel[1]);
+      }
+    }
+  }
+}
+
+TEST(ConvolveTest, Convolve2dInt16) { TestConvolve2dShapes<int16>(); }
+
+TEST(ConvolveTest, Convolve2dInt32) { TestConvolve2dShapes<int32>(); }
+
+TEST(ConvolveTest, Convolve2dFloat) { TestConvolve2dShapes<float>(); }
+
+TEST(ConvolveTest, Convolve2dDouble) { TestConvolve2dShapes<double>(); }
+
+}  // namespace
+}  // namespace dimsum
@@ -0,0 +1,625 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_DIMSUM_FFT_H_
+#define DIMSUM_DIMSUM_FFT_H_
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "dimsum.h"
+
+// Fast Fourier transforms of power-of-two sizes, and their building blocks.
+//
+// Complex numbers are stored as (real, imaginary) pairs of float or double,
+// the layout of std::complex<T> arrays, and are multiplied with complex_mul
+// from simd.h. The butterflies are decimation in time: the twiddle factors
+// are applied to the inputs, before the sums and differences.
+//
+// FftPlan and RealFftPlan precompute the twiddles of one size. fft(),
+// real_fft() and inverse_real_fft() look the plans up in a process-wide
+// cache, so that only the first transform of each size pays for the setup.
+
+namespace dimsum {
+
+enum class FftDirection {
+  kForward,  // Twiddles are powers of exp(-2 pi i / n).
+  kInverse,  // Twiddles are powers of exp(2 pi i / n). No 1 / n scaling.
+};
+
+// Replaces a and b with a + twiddle * b and a - twiddle * b.
+template <typename T, typename Abi>
+void radix2_butterfly(Simd<T, Abi>* a, Simd<T, Abi>* b,
+                      Simd<T, Abi> twiddle) {
+  Simd<T, Abi> product = complex_mul(*b, twiddle);
+  *b = *a - product;
+  *a = *a + product;
+}
+
+namespace detail {
+
+// Replaces x0 with the 4-point DFT of x0, y1, y2, y3, and y1 .. y3 with the
+// other three outputs.
+template <typename T, typename Abi>
+void Radix4Sums(Simd<T, Abi>* x0, Simd<T, Abi>* y1, Simd<T, Abi>* y2,
+                Simd<T, Abi>* y3, FftDirection direction) {
+  Simd<T, Abi> s0 = *x0 + *y2, s1 = *x0 - *y2;
+  Simd<T, Abi> s2 = *y1 + *y3, s3 = *y1 - *y3;
+  // s1 -/+ i * s3 is s1 plus or minus the swapped s3 with alternating signs,
+  // which is one fmsubadd or fmaddsub by 1.
+  Simd<T, Abi> one(1);
+  Simd<T, Abi> swapped = PairShuffle<PairShuffleKind::kSwap>(s3);
+  Simd<T, Abi> minus_i = FmSubAdd(one, s1, swapped);
+  Simd<T, Abi> plus_i = FmAddSub(one, s1, swapped);
+  *x0 = s0 + s2;
+  *y2 = s0 - s2;
+  if (direction == FftDirection::kForward) {
+    *y1 = minus_i;
+    *y3 = plus_i;
+  } else {
+    *y1 = plus_i;
+    *y3 = minus_i;
+  }
+}
+
+}  // namespace detail
+
+// Replaces x0 .. x3 with the 4-point DFT of x0, w1 * x1, w2 * x2, w3 * x3.
+template <typename T, typename Abi>
+void radix4_butterfly(Simd<T, Abi>* x0, Simd<T, Abi>* x1, Simd<T, Abi>* x2,
+                      Simd<T, Abi>* x3, Simd<T, Abi> w1, Simd<T, Abi> w2,
+                      Simd<T, Abi> w3, FftDirection direction) {
+  *x1 = complex_mul(*x1, w1);
+  *x2 = complex_mul(*x2, w2);
+  *x3 = complex_mul(*x3, w3);
+  detail::Radix4Sums(x0, x1, x2, x3, direction);
+}
+
+namespace detail {
+
+template <typename SimdType, typename T>
+void FftRadix2Step(T* a, T* b, const T* twiddles) {
+  SimdType va(a, flags::element_aligned), vb(b, flags::element_aligned);
+  radix2_butterfly(&va, &vb, SimdType(twiddles, flags::element_aligned));
+  va.memstore(a, flags::element_aligned);
+  vb.memstore(b, flags::element_aligned);
+}
+
+template <typename SimdType, typename T>
+void FftRadix4Step(const std::array<T*, 4>& x,
+                   const std::array<const T*, 3>& w, size_t offset,
+                   FftDirection direction) {
+  SimdType x0(x[0] + offset, flags::element_aligned);
+  SimdType x1(x[1] + offset, flags::element_aligned);
+  SimdType x2(x[2] + offset, flags::element_aligned);
+  SimdType x3(x[3] + offset, flags::element_aligned);
+  radix4_butterfly(&x0, &x1, &x2, &x3,
+                   SimdType(w[0] + offset, flags::element_aligned),
+                   SimdType(w[1] + offset, flags::element_aligned),
+                   SimdType(w[2] + offset, flags::element_aligned), direction);
+  x0.memstore(x[0] + offset, flags::element_aligned);
+  x1.memstore(x[1] + offset, flags::element_aligned);
+  x2.memstore(x[2] + offset, flags::element_aligned);
+  x3.memstore(x[3] + offset, flags::element_aligned);
+}
+
+}  // namespace detail
+
+// For k in [0, count), replaces the complex numbers a[k] and b[k] with
+// a[k] + twiddles[k] * b[k] and a[k] - twiddles[k] * b[k]. Each array holds
+// 2 * count interleaved elements.
+template <typename T>
+void fft_radix2(T* a, T* b, const T* twiddles, size_t count) {
+  constexpr size_t kLanes = NativeSimd<T>::size();
+  const size_t size = 2 * count;
+  size_t i = 0;
+  for (; i + kLanes <= size; i += kLanes) {
+    detail::FftRadix2Step<NativeSimd<T>>(a + i, b + i, twiddles + i);
+  }
+  // The remaining complex numbers, one at a time.
+  for (; i < size; i += 2) {
+    detail::FftRadix2Step<ResizeTo<NativeSimd<T>, 2>>(a + i, b + i,
+                                                      twiddles + i);
+  }
+}
+
+// For k in [0, count), replaces the complex numbers x[0][k] .. x[3][k] with
+// the 4-point DFT of x[0][k], w[0][k] * x[1][k], w[1][k] * x[2][k] and
+// w[2][k] * x[3][k]. Each array holds 2 * count interleaved elements.
+template <typename T>
+void fft_radix4(std::array<T*, 4> x, std::array<const T*, 3> w, size_t count,
+                FftDirection direction) {
+  constexpr size_t kLanes = NativeSimd<T>::size();
+  const size_t size = 2 * count;
+  size_t i = 0;
+  for (; i + kLanes <= size; i += kLanes) {
+    detail::FftRadix4Step<NativeSimd<T>>(x, w, i, direction);
+  }
+  for (; i < size; i += 2) {
+    detail::FftRadix4Step<ResizeTo<NativeSimd<T>, 2>>(x, w, i, direction);
+  }
+}
+
+namespace detail {
+
+constexpr double kFftPi = 3.14159265358979323846;
+
+// Returns exp(-2 pi i k / n), the forward twiddle factor.
+inline std::complex<double> FftRoot(size_t k, size_t n) {
+  double angle = 2 * kFftPi * static_cast<double>(k % n) / n;
+  return std::complex<double>(std::cos(angle), -std::sin(angle));
+}
+
+template <size_t kGroup, size_t kOdd>
+constexpr size_t UnzipComplexIndex(size_t i) {
+  return 2 * (i / 2 / kGroup * 2 * kGroup + kOdd * kGroup + i / 2 % kGroup) +
+         i % 2;
+}
+
+template <size_t kGroup, size_t kOdd, size_t... indices, typename T,
+          typename Abi>
+Simd<T, Abi> UnzipComplexImpl(Simd<T, Abi> lhs, Simd<T, Abi> rhs,
+                              dimsum::index_sequence<indices...>) {
+  return dimsum::shuffle<UnzipComplexIndex<kGroup, kOdd>(indices)...>(lhs,
+                                                                      rhs);
+}
+
+// Views the concatenation of lhs and rhs as groups of kGroup complex numbers,
+// and returns the even (kOdd = 0) or the odd (kOdd = 1) groups.
+template <size_t kGroup, size_t kOdd, typename T, typename Abi>
+Simd<T, Abi> UnzipComplex(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
+  return UnzipComplexImpl<kGroup, kOdd>(
+      lhs, rhs, dimsum::make_index_sequence<Simd<T, Abi>::size()>{});
+}
+
+template <size_t... indices, typename T, typename Abi>
+Simd<T, Abi> ReverseComplexImpl(Simd<T, Abi> simd,
+                                dimsum::index_sequence<indices...>) {
+  constexpr size_t kSize = Simd<T, Abi>::size();
+  return dimsum::shuffle<(kSize - 2 + indices % 2 * 2 - indices)...>(simd);
+}
+
+// Returns the conjugates of the complex numbers in simd, in reverse order.
+template <typename T, typename Abi>
+Simd<T, Abi> ReverseConj(Simd<T, Abi> simd) {
+  simd = ReverseComplexImpl(
+      simd, dimsum::make_index_sequence<Simd<T, Abi>::size()>{});
+  return PairShuffle<PairShuffleKind::kBlendOdd>(simd, -simd);
+}
+
+template <bool kInverse, typename T, typename Abi>
+Simd<T, Abi> TwiddleMul(Simd<T, Abi> simd, Simd<T, Abi> twiddle) {
+  return kInverse ? complex_conj_mul(simd, twiddle)
+                  : complex_mul(simd, twiddle);
+}
+
+template <bool kInverse, typename SimdType>
+void StockhamButterfly(SimdType* x0, SimdType* x1, SimdType* x2, SimdType* x3,
+                       const typename SimdType::value_type* twiddles) {
+  constexpr size_t kLanes = SimdType::size();
+  *x1 = TwiddleMul<kInverse>(*x1, SimdType(twiddles, flags::element_aligned));
+  *x2 = TwiddleMul<kInverse>(
+      *x2, SimdType(twiddles + kLanes, flags::element_aligned));
+  *x3 = TwiddleMul<kInverse>(
+      *x3, SimdType(twiddles + 2 * kLanes, flags::element_aligned));
+  Radix4Sums(x0, x1, x2, x3,
+             kInverse ? FftDirection::kInverse : FftDirection::kForward);
+}
+
+// The Stockham passes below read the n interleaved complex numbers in x and
+// write them to y. A radix-4 pass takes the 4-point DFTs of the complex
+// numbers x[j * 4r + m * r + k], m = 0 .. 3, and writes them to
+// y[j * r + m * n / 4 + k], with twiddles that only depend on j. r shrinks by
+// a factor of 4 in each pass, so the output is in order without a
+// bit-reversal permutation. Offsets are counted in elements of T, two per
+// complex number, so n / 4 complex numbers are n / 2 elements.
+
+// The first pass when log2(n) is odd: a radix-2 pass with r = n / 2, whose
+// twiddles are all 1.
+template <typename SimdType, typename T>
+void StockhamRadix2(const T* x, T* y, size_t n) {
+  constexpr size_t kLanes = SimdType::size();
+  const size_t half = n;
+  for (size_t i = 0; i < half; i += kLanes) {
+    SimdType a(x + i, flags::element_aligned);
+    SimdType b(x + half + i, flags::element_aligned);
+    (a + b).memstore(y + i, flags::element_aligned);
+    (a - b).memstore(y + half + i, flags::element_aligned);
+  }
+}
+
+// r spans whole vectors, which share the twiddles of their j.
+template <typename SimdType, bool kInverse, typename T>
+void StockhamRadix4Wide(const T* x, T* y, const T* twiddles, size_t n,
+                        size_t r) {
+  constexpr size_t kLanes = SimdType::size();
+  const size_t quarter = n / 2;
+  for (size_t j = 0; j < n / (4 * r); j++) {
+    const T* src = x + j * 8 * r;
+    T* dst = y + j * 2 * r;
+    const T* w = twiddles + j * 3 * kLanes;
+    for (size_t k = 0; k < 2 * r; k += kLanes) {
+      SimdType x0(src + k, flags::element_aligned);
+      SimdType x1(src + 2 * r + k, flags::element_aligned);
+      SimdType x2(src + 4 * r + k, flags::element_aligned);
+      SimdType x3(src + 6 * r + k, flags::element_aligned);
+      StockhamButterfly<kInverse>(&x0, &x1, &x2, &x3, w);
+      x0.memstore(dst + k, flags::element_aligned);
+      x1.memstore(dst + quarter + k, flags::element_aligned);
+      x2.memstore(dst + 2 * quarter + k, flags::element_aligned);
+      x3.memstore(dst + 3 * quarter + k, flags::element_aligned);
+    }
+  }
+}
+
+// r = kGroup is less than a vector, so each vector covers several j. Four
+// consecutive input vectors hold the m = 0 .. 3 groups of kLanes / 2 / kGroup
+// values of j, which two levels of unzips sort out.
+template <size_t kGroup, typename SimdType, bool kInverse, typename T>
+void StockhamRadix4Narrow(const T* x, T* y, const T* twiddles, size_t n) {
+  constexpr size_t kLanes = SimdType::size();
+  const size_t quarter = n / 2;
+  for (size_t i = 0; i < quarter; i += kLanes) {
+    const T* src = x + 4 * i;
+    SimdType v0(src, flags::element_aligned);
+    SimdType v1(src + kLanes, flags::element_aligned);
+    SimdType v2(src + 2 * kLanes, flags::element_aligned);
+    SimdType v3(src + 3 * kLanes, flags::element_aligned);
+    SimdType even01 = UnzipComplex<kGroup, 0>(v0, v1);
+    SimdType odd01 = UnzipComplex<kGroup, 1>(v0, v1);
+    SimdType even23 = UnzipComplex<kGroup, 0>(v2, v3);
+    SimdType odd23 = UnzipComplex<kGroup, 1>(v2, v3);
+    SimdType x0 = UnzipComplex<kGroup, 0>(even01, even23);
+    SimdType x1 = UnzipComplex<kGroup, 0>(odd01, odd23);
+    SimdType x2 = UnzipComplex<kGroup, 1>(even01, even23);
+    SimdType x3 = UnzipComplex<kGroup, 1>(odd01, odd23);
+    StockhamButterfly<kInverse>(&x0, &x1, &x2, &x3, twiddles + 3 * i);
+    x0.memstore(y + i, flags::element_aligned);
+    x1.memstore(y + quarter + i, flags::element_aligned);
+    x2.memstore(y + 2 * quarter + i, flags::element_aligned);
+    x3.memstore(y + 3 * quarter + i, flags::element_aligned);
+  }
+}
+
+// Dispatches a narrow pass to the StockhamRadix4Narrow<r>.
+template <typename SimdType, bool kInverse,
+          size_t kGroup = SimdType::size() / 4>
+struct StockhamNarrowDispatch {
+  template <typename T>
+  static void Run(size_t r, const T* x, T* y, const T* twiddles, size_t n) {
+    if (r == kGroup) {
+      StockhamRadix4Narrow<kGroup, SimdType, kInverse>(x, y, twiddles, n);
+    } else {
+      StockhamNarrowDispatch<SimdType, kInverse, kGroup / 2>::Run(r, x, y,
+                                                                  twiddles, n);
+    }
+  }
+};
+
+template <typename SimdType, bool kInverse>
+struct StockhamNarrowDispatch<SimdType, kInverse, 0> {
+  template <typename T>
+  static void Run(size_t, const T*, T*, const T*, size_t) {}
+};
+
+// Returns a buffer of at least `size` elements that is private to the
+// calling thread. index selects one of two independent buffers.
+template <typename T>
+T* FftScratch(int index, size_t size) {
+  static thread_local std::vector<T> buffers[2];
+  if (buffers[index].size() < size) buffers[index].resize(size);
+  return buffers[index].data();
+}
+
+}  // namespace detail
+
+// A precomputed complex FFT of a fixed power-of-two size n. Plans are
+// immutable, so one plan can run on several threads at once; each thread
+// uses its own scratch buffer.
+//
+// The transform is a Stockham autosort FFT made of radix-4 passes, preceded
+// by one radix-2 pass when log2(n) is odd. The twiddles of every pass are laid
+// out in the order the pass reads them, already broadcast or gathered into
+// whole vectors.
+template <typename T>
+class FftPlan {
+ public:
+  static_assert(std::is_floating_point<T>::value,
+                "Only floating point types are supported");
+
+  // n must be a power of two, 1 included. Other sizes give wrong results, so
+  // debug builds assert on them.
+  explicit FftPlan(size_t n);
+
+  size_t size() const { return n_; }
+
+  // Writes the DFT of the n interleaved complex numbers in `in` to `out`:
+  //   out[k] = sum(in[j] * exp(-+2 pi i j k / n) for j in [0, n))
+  // with the minus sign for kForward. Neither direction scales by 1 / n.
+  // in and out either don't overlap or are the same.
+  void transform(const T* in, T* out, FftDirection direction) const;
+
+ private:
+  struct Pass {
+    size_t r;
+    size_t twiddle_offset;
+  };
+
+  template <typename SimdType>
+  void Init();
+
+  template <typename SimdType, bool kInverse>
+  void Run(const T* in, T* out, T* scratch) const;
+
+  size_t n_;
+  // Whether each quarter of the input fills at least one NativeSimd<T>, so
+  // that the passes can use them. Otherwise they use vectors of a single
+  // complex number.
+  bool native_;
+  bool radix2_ = false;
+  std::vector<Pass> passes_;
+  std::vector<T> twiddles_;
+};
+
+template <typename T>
+FftPlan<T>::FftPlan(size_t n)
+    : n_(n), native_(n / 4 >= NativeSimd<T>::size() / 2) {
+  assert(n != 0 && (n & (n - 1)) == 0);
+  if (native_) {
+    Init<NativeSimd<T>>();
+  } else {
+    Init<ResizeTo<NativeSimd<T>, 2>>();
+  }
+}
+
+template <typename T>
+template <typename SimdType>
+void FftPlan<T>::Init() {
+  constexpr size_t kComplexPerSimd = SimdType::size() / 2;
+  size_t log2 = 0;
+  while ((size_t{1} << log2) < n_) log2++;
+  radix2_ = log2 % 2 == 1;
+  // The number of points of the DFTs that the passes so far have computed.
+  size_t done = radix2_ ? 2 : 1;
+  while (done < n_) {
+    const size_t r = n_ / (4 * done);
+    passes_.push_back({r, twiddles_.size()});
+    const size_t blocks =
+        r >= kComplexPerSimd ? done : n_ / 4 / kComplexPerSimd;
+    for (size_t block = 0; block < blocks; block++) {
+      for (size_t m = 1; m < 4; m++) {
+        for (size_t t = 0; t < kComplexPerSimd; t++) {
+          size_t j = r >= kComplexPerSimd ? block
+                                          : (block * kComplexPerSimd + t) / r;
+          std::complex<double> w = detail::FftRoot(m * j, 4 * done);
+          twiddles_.push_back(static_cast<T>(w.real()));
+          twiddles_.push_back(static_cast<T>(w.imag()));
+        }
+      }
+    }
+    done *= 4;
+  }
+}
+
+template <typename T>
+template <typename SimdType, bool kInverse>
+void FftPlan<T>::Run(const T* in, T* out, T* scratch) const {
+  const size_t num_passes = passes_.size() + radix2_;
+  if (num_passes == 0) {
+    if (in != out) memcpy(out, in, 2 * n_ * sizeof(T));
+    return;
+  }
+  // The passes alternate between out and scratch, ending in out.
+  if (in == out && num_passes % 2 == 1) {
+    memcpy(scratch, in, 2 * n_ * sizeof(T));
+    in = scratch;
+  }
+  T* dst = num_passes % 2 == 1 ? out : scratch;
+  T* next = num_passes % 2 == 1 ? scratch : out;
+  const T* src = in;
+  if (radix2_) {
+    detail::StockhamRadix2<SimdType>(src, dst, n_);
+    src = dst;
+    std::swap(dst, next);
+  }
+  for (const Pass& pass : passes_) {
+    const T* twiddles = twiddles_.data() + pass.twiddle_offset;
+    if (2 * pass.r >= SimdType::size()) {
+      detail::StockhamRadix4Wide<SimdType, kInverse>(src, dst, twiddles, n_,
+                                                     pass.r);
+    } else {
+      detail::StockhamNarrowDispatch<SimdType, kInverse>::Run(
+          pass.r, src, dst, twiddles, n_);
+    }
+    src = dst;
+    std::swap(dst, next);
+  }
+}
+
+template <typename T>
+void FftPlan<T>::transform(const T* in, T* out,
+                           FftDirection direction) const {
+  T* scratch = detail::FftScratch<T>(0, 2 * n_);
+  using TailSimd = ResizeTo<NativeSimd<T>, 2>;
+  if (direction == FftDirection::kForward) {
+    native_ ? Run<NativeSimd<T>, false>(in, out, scratch)
+            : Run<TailSimd, false>(in, out, scratch);
+  } else {
+    native_ ? Run<NativeSimd<T>, true>(in, out, scratch)
+            : Run<TailSimd, true>(in, out, scratch);
+  }
+}
+
+namespace detail {
+
+// Splits the FFT z of the n / 2 complex numbers (x[2j], x[2j + 1]) into the
+// bins k .. k + SimdType::size() / 2 - 1 of the FFT of the n real numbers x.
+// z holds n / 2 + 1 complex numbers, the last one a copy of the first.
+// twiddles[k] = -i * exp(-2 pi i k / n) / 2.
+template <typename SimdType, typename T>
+void RealFftSplitStep(const T* z, T* out, const T* twiddles, size_t half,
+                      size_t k) {
+  constexpr size_t kComplexPerSimd = SimdType::size() / 2;
+  SimdType zk(z + 2 * k, flags::element_aligned);
+  SimdType zc = ReverseConj(SimdType(
+      z + 2 * (half + 1 - k - kComplexPerSimd), flags::element_aligned));
+  SimdType twiddle(twiddles + 2 * k, flags::element_aligned);
+  fma(zk + zc, SimdType(0.5), complex_mul(zk - zc, twiddle))
+      .memstore(out + 2 * k, flags::element_aligned);
+}
+
+// The inverse of RealFftSplitStep, scaled by 2.
+template <typename SimdType, typename T>
+void RealFftMergeStep(const T* x, T* z, const T* twiddles, size_t half,
+                      size_t k) {
+  constexpr size_t kComplexPerSimd = SimdType::size() / 2;
+  SimdType xk(x + 2 * k, flags::element_aligned);
+  SimdType xc = ReverseConj(SimdType(
+      x + 2 * (half + 1 - k - kComplexPerSimd), flags::element_aligned));
+  SimdType twiddle(twiddles + 2 * k, flags::element_aligned);
+  fma(complex_conj_mul(xk - xc, twiddle), SimdType(2), xk + xc)
+      .memstore(z + 2 * k, flags::element_aligned);
+}
+
+}  // namespace detail
+
+// A precomputed FFT of n real numbers, n a power of two of at least 2. It
+// runs a complex FFT of size n / 2 on the even and odd elements as the real
+// and imaginary parts, and then splits the result into the bins of the real
+// transform.
+template <typename T>
+class RealFftPlan {
+ public:
+  // Debug builds assert that n is a power of two of at least 2.
+  explicit RealFftPlan(size_t n);
+
+  size_t size() const { return n_; }
+
+  // Writes bins 0 .. n / 2 of the forward DFT of the n real numbers in `in`
+  // to `out`, as n / 2 + 1 interleaved complex numbers. The other bins are
+  // their conjugates. in and out must not overlap.
+  void forward(const T* in, T* out) const;
+
+  // The inverse of forward, scaled by n: reads n / 2 + 1 complex bins and
+  // writes n real numbers. The imaginary parts of bins 0 and n / 2 are
+  // ignored. in and out must not overlap.
+  void inverse(const T* in, T* out) const;
+
+ private:
+  size_t n_;
+  FftPlan<T> half_;
+  // -i * exp(-2 pi i k / n) / 2 for k in [0, n / 2].
+  std::vector<T> twiddles_;
+};
+
+template <typename T>
+RealFftPlan<T>::RealFftPlan(size_t n) : n_(n), half_(n / 2) {
+  assert(n >= 2 && (n & (n - 1)) == 0);
+  for (size_t k = 0; k <= n / 2; k++) {
+    std::complex<double> w = detail::FftRoot(k, n) *
+                             std::complex<double>(0, -0.5);
+    twiddles_.push_back(static_cast<T>(w.real()));
+    twiddles_.push_back(static_cast<T>(w.imag()));
+  }
+}
+
+template <typename T>
+void RealFftPlan<T>::forward(const T* in, T* out) const {
+  constexpr size_t kComplexPerSimd = NativeSimd<T>::size() / 2;
+  const size_t half = n_ / 2;
+  T* z = detail::FftScratch<T>(1, 2 * half + 2);
+  half_.transform(in, z, FftDirection::kForward);
+  z[2 * half] = z[0];
+  z[2 * half + 1] = z[1];
+  size_t k = 0;
+  for (; k + kComplexPerSimd <= half + 1; k += kComplexPerSimd) {
+    detail::RealFftSplitStep<NativeSimd<T>>(z, out, twiddles_.data(), half, k);
+  }
+  for (; k <= half; k++) {
+    detail::RealFftSplitStep<ResizeTo<NativeSimd<T>, 2>>(
+        z, out, twiddles_.data(), half, k);
+  }
+}
+
+template <typename T>
+void RealFftPlan<T>::inverse(const T* in, T* out) const {
+  constexpr size_t kComplexPerSimd = NativeSimd<T>::size() / 2;
+  const size_t half = n_ / 2;
+  T* z = detail::FftScratch<T>(1, 2 * half);
+  size_t k = 0;
+  for (; k + kComplexPerSimd <= half; k += kComplexPerSimd) {
+    detail::RealFftMergeStep<NativeSimd<T>>(in, z, twiddles_.data(), half, k);
+  }
+  for (; k < half; k++) {
+    detail::RealFftMergeStep<ResizeTo<NativeSimd<T>, 2>>(
+        in, z, twiddles_.data(), half, k);
+  }
+  half_.transform(z, out, FftDirection::kInverse);
+}
+
+namespace detail {
+
+// Plans are created on first use and live until the program exits.
+template <typename Plan>
+const Plan& CachedFftPlan(size_t n) {
+  static std::mutex* mutex = new std::mutex;
+  static auto* plans = new std::map<size_t, std::unique_ptr<Plan>>;
+  std::lock_guard<std::mutex> lock(*mutex);
+  std::unique_ptr<Plan>& plan = (*plans)[n];
+  if (plan == nullptr) plan.reset(new Plan(n));
+  return *plan;
+}
+
+}  // namespace detail
+
+// Returns the cached plans of size n, creating them on first use. Callers that
+// transform many times may hold on to the plan to skip the cache lookup.
+template <typename T>
+const FftPlan<T>& fft_plan(size_t n) {
+  return detail::CachedFftPlan<FftPlan<T>>(n);
+}
+
+template <typename T>
+const RealFftPlan<T>& real_fft_plan(size_t n) {
+  return detail::CachedFftPlan<RealFftPlan<T>>(n);
+}
+
+// Shorthands for transforms with the cached plans.
+template <typename T>
+void fft(const T* in, T* out, size_t n, FftDirection direction) {
+  fft_plan<T>(n).transform(in, out, direction);
+}
+
+template <typename T>
+void real_fft(const T* in, T* out, size_t n) {
+  real_fft_plan<T>(n).forward(in, out);
+}
+
+template <typename T>
+void inverse_real_fft(const T* in, T* out, size_t n) {
+  real_fft_plan<T>(n).inverse(in, out);
+}
+
+}  // namespace dimsum
+
+#endif  // DIMSUM_DIMSUM_FFT_H_
@@ -0,0 +1,181 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "dimsum_fft.h"
+
+namespace dimsum {
+namespace {
+
+template <typename T>
+std::vector<std::complex<T>> MakeTwiddles(size_t count) {
+  std::vector<std::complex<T>> twiddles(count);
+  for (size_t k = 0; k < count; k++) {
+    twiddles[k] = std::polar(T(1), T(-2 * M_PI * k / (2 * count)));
+  }
+  return twiddles;
+}
+
+template <typename T>
+T* Interleaved(std::vector<std::complex<T>>* v) {
+  return reinterpret_cast<T*>(v->data());
+}
+
+template <typename T>
+void BM_Radix2Scalar(benchmark::State& state) {
+  const size_t count = state.range(0);
+  std::vector<std::complex<T>> a(count, 1), b(count, 2);
+  auto w = MakeTwiddles<T>(count);
+  for (auto _ : state) {
+    for (size_t k = 0; k < count; k++) {
+      std::complex<T> product = w[k] * b[k];
+      b[k] = a[k] - product;
+      a[k] = a[k] + product;
+    }
+    benchmark::DoNotOptimize(a.data());
+    benchmark::DoNotOptimize(b.data());
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+template <typename T>
+void BM_Radix2(benchmark::State& state) {
+  const size_t count = state.range(0);
+  std::vector<std::complex<T>> a(count, 1), b(count, 2);
+  auto w = MakeTwiddles<T>(count);
+  for (auto _ : state) {
+    fft_radix2(Interleaved(&a), Interleaved(&b), Interleaved(&w), count);
+    benchmark::DoNotOptimize(a.data());
+    benchmark::DoNotOptimize(b.data());
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+template <typename T>
+void BM_Radix4Scalar(benchmark::State& state) {
+  const size_t count = state.range(0);
+  std::vector<std::complex<T>> x0(count, 1), x1(count, 2), x2(count, 3),
+      x3(count, 4);
+  auto w1 = MakeTwiddles<T>(count), w2 = w1, w3 = w1;
+  const std::complex<T> minus_i(0, -1);
+  for (auto _ : state) {
+    for (size_t k = 0; k < count; k++) {
+      std::complex<T> y1 = w1[k] * x1[k], y2 = w2[k] * x2[k],
+                      y3 = w3[k] * x3[k];
+      std::complex<T> s0 = x0[k] + y2, s1 = x0[k] - y2;
+      std::complex<T> s2 = y1 + y3, s3 = minus_i * (y1 - y3);
+      x0[k] = s0 + s2;
+      x1[k] = s1 + s3;
+      x2[k] = s0 - s2;
+      x3[k] = s1 - s3;
+    }
+    benchmark::DoNotOptimize(x0.data());
+    benchmark::DoNotOptimize(x1.data());
+    benchmark::DoNotOptimize(x2.data());
+    benchmark::DoNotOptimize(x3.data());
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+template <typename T>
+void BM_Radix4(benchmark::State& state) {
+  const size_t count = state.range(0);
+  std::vector<std::complex<T>> x0(count, 1), x1(count, 2), x2(count, 3),
+      x3(count, 4);
+  auto w1 = MakeTwiddles<T>(count), w2 = w1, w3 = w1;
+  for (auto _ : state) {
+    fft_radix4<T>({{Interleaved(&x0), Interleaved(&x1), Interleaved(&x2),
+                    Interleaved(&x3)}},
+                  {{Interleaved(&w1), Interleaved(&w2), Interleaved(&w3)}},
+                  count, FftDirection::kForward);
+    benchmark::DoNotOptimize(x0.data());
+    benchmark::DoNotOptimize(x1.data());
+    benchmark::DoNotOptimize(x2.data());
+    benchmark::DoNotOptimize(x3.data());
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+// The argument is the number of butterflies per pass.
+void ButterflyCounts(benchmark::internal::Benchmark* b) {
+  b->Arg(64)->Arg(1024)->Arg(16384);
+}
+
+BENCHMARK_TEMPLATE(BM_Radix2Scalar, float)->Apply(ButterflyCounts);
+BENCHMARK_TEMPLATE(BM_Radix2, float)->Apply(ButterflyCounts);
+BENCHMARK_TEMPLATE(BM_Radix2Scalar, double)->Apply(ButterflyCounts);
+BENCHMARK_TEMPLATE(BM_Radix2, double)->Apply(ButterflyCounts);
+BENCHMARK_TEMPLATE(BM_Radix4Scalar, float)->Apply(ButterflyCounts);
+BENCHMARK_TEMPLATE(BM_Radix4, float)->Apply(ButterflyCounts);
+BENCHMARK_TEMPLATE(BM_Radix4Scalar, double)->Apply(ButterflyCounts);
+BENCHMARK_TEMPLATE(BM_Radix4, double)->Apply(ButterflyCounts);
+
+// The reference for the transforms below: an O(n^2) DFT with a precomputed
+// table of roots of unity.
+template <typename T>
+void BM_NaiveDft(benchmark::State& state) {
+  const size_t n = state.range(0);
+  std::vector<std::complex<T>> in(n, 1), out(n), roots(n);
+  for (size_t k = 0; k < n; k++) {
+    roots[k] = std::polar(T(1), T(-2 * M_PI * k / n));
+  }
+  for (auto _ : state) {
+    for (size_t k = 0; k < n; k++) {
+      std::complex<T> sum = 0;
+      for (size_t j = 0; j < n; j++) {
+        sum += in[j] * roots[j * k % n];
+      }
+      out[k] = sum;
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+
+// The plan is looked up in the cache on every iteration, as callers of fft()
+// do.
+template <typename T>
+void BM_Fft(benchmark::State& state) {
+  const size_t n = state.range(0);
+  std::vector<std::complex<T>> in(n, 1), out(n);
+  for (auto _ : state) {
+    fft(Interleaved(&in), Interleaved(&out), n, FftDirection::kForward);
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+
+template <typename T>
+void BM_RealFft(benchmark::State& state) {
+  const size_t n = state.range(0);
+  std::vector<T> in(n, 1), out(n + 2);
+  for (auto _ : state) {
+    real_fft(in.data(), out.data(), n);
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+
+// The argument is the number of points. The times are per transform.
+BENCHMARK_TEMPLATE(BM_NaiveDft, float)->RangeMultiplier(4)->Range(16, 4096);
+BENCHMARK_TEMPLATE(BM_Fft, float)->RangeMultiplier(4)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_Fft, float)->Arg(32)->Arg(512)->Arg(8192);
+BENCHMARK_TEMPLATE(BM_RealFft, float)->RangeMultiplier(4)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_NaiveDft, double)->RangeMultiplier(4)->Range(16, 4096);
+BENCHMARK_TEMPLATE(BM_Fft, double)->RangeMultiplier(4)->Range(16, 1 << 20);
+BENCHMARK_TEMPLATE(BM_RealFft, double)->RangeMultiplier(4)->Range(16, 1 << 20);
+
+}  // namespace
+}  // namespace dimsum
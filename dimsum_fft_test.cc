@@ -0,0 +1,249 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dimsum_fft.h"
+
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+// Small integral parts keep every product and sum exact, so the results can be
+// compared with std::complex exactly, with and without fma.
+template <typename T>
+std::vector<std::complex<T>> MakeComplex(size_t count, int seed) {
+  std::vector<std::complex<T>> ret(count);
+  for (size_t i = 0; i < count; i++) {
+    ret[i] = std::complex<T>(static_cast<T>((i * 7 + seed) % 11) - 5,
+                             static_cast<T>((i * 3 + seed * 5) % 13) - 6);
+  }
+  return ret;
+}
+
+template <typename T>
+T* Interleaved(std::vector<std::complex<T>>* v) {
+  return reinterpret_cast<T*>(v->data());
+}
+
+template <typename T>
+void TestRadix2(size_t count) {
+  auto a = MakeComplex<T>(count, 1), b = MakeComplex<T>(count, 2);
+  auto w = MakeComplex<T>(count, 3);
+  auto expected_a = a, expected_b = b;
+  for (size_t k = 0; k < count; k++) {
+    expected_a[k] = a[k] + w[k] * b[k];
+    expected_b[k] = a[k] - w[k] * b[k];
+  }
+  fft_radix2(Interleaved(&a), Interleaved(&b), Interleaved(&w), count);
+  EXPECT_EQ(expected_a, a) << count;
+  EXPECT_EQ(expected_b, b) << count;
+}
+
+template <typename T>
+void TestRadix4(size_t count, FftDirection direction) {
+  std::vector<std::complex<T>> x[4], w[3];
+  for (int j = 0; j < 4; j++) x[j] = MakeComplex<T>(count, j);
+  for (int j = 0; j < 3; j++) w[j] = MakeComplex<T>(count, j + 4);
+  const std::complex<T> root(0, direction == FftDirection::kForward ? -1 : 1);
+  std::vector<std::complex<T>> expected[4];
+  for (int j = 0; j < 4; j++) expected[j].resize(count);
+  for (size_t k = 0; k < count; k++) {
+    std::complex<T> y[4] = {x[0][k], w[0][k] * x[1][k], w[1][k] * x[2][k],
+                            w[2][k] * x[3][k]};
+    for (int j = 0; j < 4; j++) {
+      std::complex<T> power(1), sum(0);
+      for (int m = 0; m < 4; m++) {
+        sum += power * y[m];
+        for (int p = 0; p < j; p++) power *= root;
+      }
+      expected[j][k] = sum;
+    }
+  }
+  fft_radix4<T>({{Interleaved(&x[0]), Interleaved(&x[1]), Interleaved(&x[2]),
+                  Interleaved(&x[3])}},
+                {{Interleaved(&w[0]), Interleaved(&w[1]), Interleaved(&w[2])}},
+                count, direction);
+  for (int j = 0; j < 4; j++) {
+    EXPECT_EQ(expected[j], x[j]) << count << " output " << j;
+  }
+}
+
+template <typename T>
+void TestButterflies() {
+  for (size_t count : {1, 2, 3, 4, 7, 8, 16, 17, 64, 99}) {
+    TestRadix2<T>(count);
+    TestRadix4<T>(count, FftDirection::kForward);
+    TestRadix4<T>(count, FftDirection::kInverse);
+  }
+}
+
+TEST(FftTest, FloatButterflies) { TestButterflies<float>(); }
+
+TEST(FftTest, DoubleButterflies) { TestButterflies<double>(); }
+
+// Returns the DFT of `in`, computed in long double.
+std::vector<std::complex<long double>> NaiveDft(
+    const std::vector<std::complex<long double>>& in, FftDirection direction) {
+  const size_t n = in.size();
+  const long double sign = direction == FftDirection::kForward ? -1 : 1;
+  std::vector<std::complex<long double>> roots(n), out(n);
+  for (size_t k = 0; k < n; k++) {
+    roots[k] = std::polar(1.0L, sign * 2 * M_PI * k / n);
+  }
+  for (size_t k = 0; k < n; k++) {
+    for (size_t j = 0; j < n; j++) {
+      out[k] += in[j] * roots[j * k % n];
+    }
+  }
+  return out;
+}
+
+template <typename T>
+std::vector<T> MakeSignal(size_t size, int seed) {
+  std::vector<T> ret(size);
+  for (size_t i = 0; i < size; i++) {
+    ret[i] = static_cast<T>(std::sin(0.37 * i * seed + seed) +
+                            0.25 * std::cos(1.9 * i));
+  }
+  return ret;
+}
+
+// The error of an FFT grows with log2(n) times the machine epsilon, relative
+// to the norm of the input.
+template <typename T>
+void ExpectNear(const std::vector<std::complex<long double>>& expected,
+                const T* actual, size_t n, long double norm) {
+  const long double tolerance =
+      8 * std::log2(n + 1.0L) * std::numeric_limits<T>::epsilon() * norm;
+  for (size_t k = 0; k < n; k++) {
+    ASSERT_NEAR(expected[k].real(), actual[2 * k], tolerance) << n << " " << k;
+    ASSERT_NEAR(expected[k].imag(), actual[2 * k + 1], tolerance)
+        << n << " " << k;
+  }
+}
+
+template <typename T>
+void TestComplexFft(size_t n, FftDirection direction) {
+  std::vector<T> in = MakeSignal<T>(2 * n, 3);
+  std::vector<std::complex<long double>> wide(n);
+  long double norm = 0;
+  for (size_t j = 0; j < n; j++) {
+    wide[j] = std::complex<long double>(in[2 * j], in[2 * j + 1]);
+    norm += std::norm(wide[j]);
+  }
+  norm = std::sqrt(norm);
+  auto expected = NaiveDft(wide, direction);
+
+  std::vector<T> out(2 * n);
+  fft(in.data(), out.data(), n, direction);
+  ExpectNear(expected, out.data(), n, norm);
+
+  fft(in.data(), in.data(), n, direction);
+  ExpectNear(expected, in.data(), n, norm);
+}
+
+template <typename T>
+void TestRealFft(size_t n) {
+  std::vector<T> in = MakeSignal<T>(n, 5);
+  std::vector<std::complex<long double>> wide(n);
+  long double norm = 0;
+  for (size_t j = 0; j < n; j++) {
+    wide[j] = in[j];
+    norm += in[j] * in[j];
+  }
+  norm = std::sqrt(norm);
+  auto expected = NaiveDft(wide, FftDirection::kForward);
+
+  std::vector<T> bins(n + 2);
+  real_fft(in.data(), bins.data(), n);
+  ExpectNear(expected, bins.data(), n / 2 + 1, norm);
+
+  std::vector<T> round_trip(n);
+  inverse_real_fft(bins.data(), round_trip.data(), n);
+  const long double tolerance =
+      8 * std::log2(n + 1.0L) * std::numeric_limits<T>::epsilon() * norm;
+  for (size_t j = 0; j < n; j++) {
+    ASSERT_NEAR(in[j] * static_cast<long double>(n), round_trip[j],
+                tolerance * n)
+        << n << " " << j;
+  }
+}
+
+template <typename T>
+void TestFftSizes() {
+  for (size_t n = 1; n <= 4096; n *= 2) {
+    TestComplexFft<T>(n, FftDirection::kForward);
+    TestComplexFft<T>(n, FftDirection::kInverse);
+    if (n >= 2) TestRealFft<T>(n);
+  }
+}
+
+TEST(FftTest, Float) { TestFftSizes<float>(); }
+
+TEST(FftTest, Double) { TestFftSizes<double>(); }
+
+// Sizes too large for NaiveDft: checks that the inverse transform of the
+// forward one gives back n times the input.
+template <typename T>
+void TestRoundTrip(size_t n) {
+  std::vector<T> in = MakeSignal<T>(2 * n, 7);
+  long double norm = 0;
+  for (T x : in) norm += x * x;
+  const long double rms = std::sqrt(norm / (2 * n));
+  const long double tolerance =
+      8 * std::log2(n + 1.0L) * std::numeric_limits<T>::epsilon() * rms * n;
+
+  std::vector<T> out(2 * n);
+  fft(in.data(), out.data(), n, FftDirection::kForward);
+  fft(out.data(), out.data(), n, FftDirection::kInverse);
+  for (size_t j = 0; j < 2 * n; j++) {
+    ASSERT_NEAR(in[j] * static_cast<long double>(n), out[j], tolerance)
+        << n << " " << j;
+  }
+
+  std::vector<T> bins(n + 2);
+  real_fft(in.data(), bins.data(), n);
+  inverse_real_fft(bins.data(), out.data(), n);
+  for (size_t j = 0; j < n; j++) {
+    ASSERT_NEAR(in[j] * static_cast<long double>(n), out[j], tolerance)
+        << n << " " << j;
+  }
+}
+
+TEST(FftTest, FloatLargeRoundTrip) {
+  TestRoundTrip<float>(size_t{1} << 16);
+  TestRoundTrip<float>(size_t{1} << 20);
+}
+
+TEST(FftTest, DoubleLargeRoundTrip) {
+  TestRoundTrip<double>(size_t{1} << 16);
+  TestRoundTrip<double>(size_t{1} << 20);
+}
+
+TEST(FftTest, PlanCache) {
+  const FftPlan<float>& plan = fft_plan<float>(256);
+  EXPECT_EQ(256, plan.size());
+  EXPECT_EQ(&plan, &fft_plan<float>(256));
+  EXPECT_NE(static_cast<const void*>(&plan),
+            static_cast<const void*>(&fft_plan<double>(256)));
+  EXPECT_EQ(&real_fft_plan<float>(64), &real_fft_plan<float>(64));
+}
+
+}  // namespace
+}  // namespace dimsum
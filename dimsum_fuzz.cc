@@ -126,6 +126,62 @@ void TestStaticSimdCast(const uint8_t* data) {
                  dimsum::static_simd_cast<To>(simd));
 }
 
+template <typename To, typename From>
+void TestSaturatedSimdCast(const uint8_t* data) {
+  NativeSimd<From> simd;
+  LoadFromRaw(data, &simd);
+  TrapIfNotEqual(dimsum::simulated::saturated_simd_cast<To>(simd),
+                 dimsum::saturated_simd_cast<To>(simd));
+}
+
+template <typename T>
+void TestZipHalvesAndUnzip(const uint8_t* data) {
+  NativeSimd<T> lhs, rhs;
+  LoadFromRaw(data, &lhs);
+  LoadFromRaw(data + sizeof(lhs), &rhs);
+  TrapIfNotEqual(dimsum::simulated::zip_lo(lhs, rhs), zip_lo(lhs, rhs));
+  TrapIfNotEqual(dimsum::simulated::zip_hi(lhs, rhs), zip_hi(lhs, rhs));
+  TrapIfNotEqual(dimsum::simulated::unzip_even(lhs, rhs), unzip_even(lhs, rhs));
+  TrapIfNotEqual(dimsum::simulated::unzip_odd(lhs, rhs), unzip_odd(lhs, rhs));
+}
+
+template <size_t kN, typename T>
+void TestInterleaved(const uint8_t* data) {
+  using SimdType = NativeSimd<T>;
+  constexpr size_t kSize = kN * SimdType::size();
+  T buffer[kSize];
+  memcpy(buffer, data, sizeof(buffer));
+  auto channels = dimsum::load_interleaved<kN, SimdType>(buffer);
+  auto expected = dimsum::simulated::load_interleaved<kN, SimdType>(buffer);
+  for (size_t c = 0; c < kN; c++) {
+    TrapIfNotEqual(expected[c], channels[c]);
+  }
+  T stored[kSize];
+  dimsum::store_interleaved<kN>(stored, channels);
+  if (memcmp(stored, buffer, sizeof(buffer)) != 0) {
+    __builtin_trap();
+  }
+}
+
+// Compares bit patterns, since the lanes may be NaNs.
+template <typename Half>
+void TestHalfPrecisionCast(const uint8_t* data) {
+  using FloatSimd = NativeSimd<float>;
+  using HalfSimd = dimsum::ChangeElemTo<FloatSimd, Half>;
+  FloatSimd floats;
+  HalfSimd halves;
+  LoadFromRaw(data, &floats);
+  LoadFromRaw(data, &halves);
+  auto narrowed = dimsum::static_simd_cast<Half>(floats);
+  auto widened = dimsum::static_simd_cast<float>(halves);
+  TrapIfNotEqual(dimsum::bit_cast<uint16>(
+                     dimsum::simulated::static_simd_cast<Half>(floats)),
+                 dimsum::bit_cast<uint16>(narrowed));
+  TrapIfNotEqual(dimsum::bit_cast<uint32>(
+                     dimsum::simulated::static_simd_cast<float>(halves)),
+                 dimsum::bit_cast<uint32>(widened));
+}
+
 template <typename SimdType, size_t kArity>
 void TestReduceAdd(const uint8_t* data) {
   SimdType input;
@@ -177,6 +233,20 @@ void TestMaddubs(const uint8_t* data) {
                  dimsum::x86::maddubs(lhs, rhs));
 }
 
+void TestDotProduct(const uint8_t* data) {
+  NativeSimd<uint8> lhs;
+  NativeSimd<int8> rhs;
+  NativeSimd<int32> acc;
+  LoadFromRaw(data, &lhs);
+  LoadFromRaw(data + sizeof(lhs), &rhs);
+  LoadFromRaw(data + sizeof(lhs) + sizeof(rhs), &acc);
+  TrapIfNotEqual(dimsum::simulated::dot_u8s8_i32(acc, lhs, rhs),
+                 dimsum::dot_u8s8_i32(acc, lhs, rhs));
+  auto signed_lhs = dimsum::bit_cast<int8>(lhs);
+  TrapIfNotEqual(dimsum::simulated::dot_s8s8_i32(acc, signed_lhs, rhs),
+                 dimsum::dot_s8s8_i32(acc, signed_lhs, rhs));
+}
+
 template <typename T>
 void TestAbs(const uint8_t* data) {
   NativeSimd<T> simd, res, sim_res;
@@ -308,6 +378,98 @@ void TestMulWidened(const uint8_t* data) {
                  mul_widened(lhs, rhs));
 }
 
+template <typename T>
+void TestAvgRoundAndMulHi(const uint8_t* data) {
+  NativeSimd<T> lhs, rhs;
+  LoadFromRaw(data, &lhs);
+  LoadFromRaw(data + sizeof(lhs), &rhs);
+  TrapIfNotEqual(dimsum::simulated::avg_round(lhs, rhs), avg_round(lhs, rhs));
+  TrapIfNotEqual(dimsum::simulated::mul_hi(lhs, rhs), mul_hi(lhs, rhs));
+}
+
+template <typename T>
+void TestSelect(const uint8_t* data) {
+  NativeSimd<T> lhs, rhs;
+  LoadFromRaw(data, &lhs);
+  LoadFromRaw(data + sizeof(lhs), &rhs);
+  // Works on the bits, so that NaNs are selected and compared like other
+  // values.
+  using Bits = typename NativeSimd<T>::ComparisonResultType;
+  auto mask =
+      dimsum::cmp_lt(dimsum::bit_cast<Bits>(lhs), dimsum::bit_cast<Bits>(rhs));
+  TrapIfNotEqual(
+      dimsum::bit_cast<Bits>(dimsum::simulated::select(mask, lhs, rhs)),
+      dimsum::bit_cast<Bits>(dimsum::select(mask, lhs, rhs)));
+}
+
+template <typename T>
+void TestShifts(const uint8_t* data) {
+  NativeSimd<T> simd, count;
+  LoadFromRaw(data, &simd);
+  LoadFromRaw(data + sizeof(simd), &count);
+  // Counts out of [0, bits) differ between backends.
+  count = count & NativeSimd<T>(8 * sizeof(T) - 1);
+  TrapIfNotEqual(dimsum::simulated::shl_simd(simd, count),
+                 shl_simd(simd, count));
+  TrapIfNotEqual(dimsum::simulated::shr_simd(simd, count),
+                 shr_simd(simd, count));
+  TrapIfNotEqual(dimsum::simulated::rotl_simd(simd, count),
+                 rotl_simd(simd, count));
+  TrapIfNotEqual(dimsum::simulated::rotr_simd(simd, count),
+                 rotr_simd(simd, count));
+  int uniform = count[0];
+  TrapIfNotEqual(dimsum::simulated::shl(simd, uniform), shl(simd, uniform));
+  TrapIfNotEqual(dimsum::simulated::shr(simd, uniform), shr(simd, uniform));
+  TrapIfNotEqual(dimsum::simulated::rotl(simd, uniform), rotl(simd, uniform));
+  TrapIfNotEqual(dimsum::simulated::rotr(simd, uniform), rotr(simd, uniform));
+}
+
+template <typename T>
+void TestArithmetic64Bit(const uint8_t* data) {
+  NativeSimd<T> lhs, rhs;
+  LoadFromRaw(data, &lhs);
+  LoadFromRaw(data + sizeof(lhs), &rhs);
+  TrapIfNotEqual(dimsum::simulated::mul(lhs, rhs), mul(lhs, rhs));
+  TrapIfNotEqual(dimsum::simulated::min(lhs, rhs), min(lhs, rhs));
+  TrapIfNotEqual(dimsum::simulated::max(lhs, rhs), max(lhs, rhs));
+  TrapIfNotEqual(dimsum::simulated::cmp_gt(lhs, rhs), cmp_gt(lhs, rhs));
+  TrapIfNotEqual(dimsum::simulated::cmp_lt(lhs, rhs), cmp_lt(lhs, rhs));
+}
+
+template <typename T>
+void TestUnsignedCompare(const uint8_t* data) {
+  NativeSimd<T> lhs, rhs;
+  LoadFromRaw(data, &lhs);
+  LoadFromRaw(data + sizeof(lhs), &rhs);
+  // Random inputs are rarely equal, so also compare against a vector that
+  // shares lanes with lhs.
+  for (auto other : {rhs, max(lhs, rhs)}) {
+    TrapIfNotEqual(dimsum::simulated::cmp_gt(lhs, other), cmp_gt(lhs, other));
+    TrapIfNotEqual(dimsum::simulated::cmp_lt(lhs, other), cmp_lt(lhs, other));
+    TrapIfNotEqual(dimsum::simulated::cmp_ge(lhs, other), cmp_ge(lhs, other));
+    TrapIfNotEqual(dimsum::simulated::cmp_le(lhs, other), cmp_le(lhs, other));
+  }
+}
+
+void TestMulHiRound(const uint8_t* data) {
+  NativeSimd<int16> lhs, rhs;
+  LoadFromRaw(data, &lhs);
+  LoadFromRaw(data + sizeof(lhs), &rhs);
+  // -32768 * -32768 differs between backends.
+  lhs = max(lhs, NativeSimd<int16>(-32767));
+  TrapIfNotEqual(dimsum::simulated::mul_hi_round(lhs, rhs),
+                 mul_hi_round(lhs, rhs));
+}
+
+void TestBlendU8(const uint8_t* data) {
+  NativeSimd<uint8> src, dst, alpha;
+  LoadFromRaw(data, &src);
+  LoadFromRaw(data + sizeof(src), &dst);
+  LoadFromRaw(data + sizeof(src) * 2, &alpha);
+  TrapIfNotEqual(dimsum::simulated::blend_u8(src, dst, alpha),
+                 blend_u8(src, dst, alpha));
+}
+
 template <typename Tin, typename Tout>
 void TestPack(const uint8_t* data) {
   NativeSimd<Tin> lhs, rhs;
@@ -340,6 +502,49 @@ void TestPacku(const uint8_t* data) {
   TrapIfNotEqual(sim_res, res);
 }
 
+template <typename T>
+void TestBitCounting(const uint8_t* data) {
+  NativeSimd<T> simd;
+  LoadFromRaw(data, &simd);
+  TrapIfNotEqual(dimsum::simulated::popcount(simd), dimsum::popcount(simd));
+  TrapIfNotEqual(dimsum::simulated::countl_zero(simd),
+                 dimsum::countl_zero(simd));
+  TrapIfNotEqual(dimsum::simulated::countr_zero(simd),
+                 dimsum::countr_zero(simd));
+  TrapIfNotEqual(dimsum::simulated::byte_reverse(simd),
+                 dimsum::byte_reverse(simd));
+  TrapIfNotEqual(dimsum::simulated::bit_reverse(simd),
+                 dimsum::bit_reverse(simd));
+}
+
+// Lanes are compared by their bits, so NaNs are compared too.
+template <typename T>
+void TestCompress(const uint8_t* data) {
+  using SimdType = NativeSimd<T>;
+  using Bits = typename SimdType::ComparisonResultType;
+  SimdType simd;
+  NativeSimd<Bits> mask;
+  LoadFromRaw(data, &simd);
+  LoadFromRaw(data + sizeof(simd), &mask);
+
+  TrapIfNotEqual(
+      dimsum::bit_cast<Bits>(dimsum::simulated::compress(simd, mask)),
+      dimsum::bit_cast<Bits>(dimsum::compress(simd, mask)));
+  TrapIfNotEqual(dimsum::bit_cast<Bits>(dimsum::simulated::expand(simd, mask)),
+                 dimsum::bit_cast<Bits>(dimsum::expand(simd, mask)));
+
+  Bits sim_stored[SimdType::size()] = {};
+  Bits stored[SimdType::size()] = {};
+  size_t sim_count = dimsum::simulated::compress_store(
+      reinterpret_cast<T*>(sim_stored), simd, mask);
+  size_t count =
+      dimsum::compress_store(reinterpret_cast<T*>(stored), simd, mask);
+  if (sim_count != count ||
+      memcmp(sim_stored, stored, sizeof(stored)) != 0) {
+    __builtin_trap();
+  }
+}
+
 template <typename T>
 void TestMovemask(const uint8_t* data) {
   NativeSimd<T> simd;
@@ -370,6 +575,32 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
     TestStaticSimdCast<uint32, int32>(data);
     TestStaticSimdCast<int64, uint64>(data);
     TestStaticSimdCast<uint64, int64>(data);
+    TestHalfPrecisionCast<dimsum::float16>(data);
+    TestHalfPrecisionCast<dimsum::bfloat16>(data);
+    TestSaturatedSimdCast<int8, int16>(data);
+    TestSaturatedSimdCast<uint8, int16>(data);
+    TestSaturatedSimdCast<uint8, uint16>(data);
+    TestSaturatedSimdCast<int16, int32>(data);
+    TestSaturatedSimdCast<uint16, int32>(data);
+    TestSaturatedSimdCast<uint16, uint32>(data);
+    TestSaturatedSimdCast<int32, int64>(data);
+    TestSaturatedSimdCast<uint32, int64>(data);
+    TestSaturatedSimdCast<uint32, uint64>(data);
+    TestSaturatedSimdCast<int8, int32>(data);
+    TestSaturatedSimdCast<uint8, int32>(data);
+    TestSaturatedSimdCast<int8, int64>(data);
+    TestSaturatedSimdCast<uint8, uint32>(data);
+    TestSaturatedSimdCast<int8, uint8>(data);
+    TestSaturatedSimdCast<uint8, int8>(data);
+    TestSaturatedSimdCast<int32, uint64>(data);
+    TestSaturatedSimdCast<uint64, int64>(data);
+    TestSaturatedSimdCast<int32, float>(data);
+    TestSaturatedSimdCast<uint32, float>(data);
+    TestSaturatedSimdCast<int8, float>(data);
+    TestSaturatedSimdCast<int64, float>(data);
+    TestSaturatedSimdCast<int32, double>(data);
+    TestSaturatedSimdCast<int64, double>(data);
+    TestSaturatedSimdCast<uint64, double>(data);
 
     TestAbs<int8>(data);
     TestAbs<int16>(data);
@@ -427,6 +658,15 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
     TestReduceAddWidened<uint16, 4>(data);
     TestReduceAddWidened<uint32, 2>(data);
 
+    TestBitCounting<int8>(data);
+    TestBitCounting<int16>(data);
+    TestBitCounting<int32>(data);
+    TestBitCounting<int64>(data);
+    TestBitCounting<uint8>(data);
+    TestBitCounting<uint16>(data);
+    TestBitCounting<uint32>(data);
+    TestBitCounting<uint64>(data);
+
     // ----- dimsum::x86::*
     TestMovemask<int8>(data);
     TestMovemask<int32>(data);
@@ -460,6 +700,11 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
     TestMin<float>(data);
     TestMin<double>(data);
 
+    TestZipHalvesAndUnzip<uint8>(data);
+    TestZipHalvesAndUnzip<uint16>(data);
+    TestZipHalvesAndUnzip<uint32>(data);
+    TestZipHalvesAndUnzip<uint64>(data);
+
     TestMulWidened<int8>(data);
     TestMulWidened<int16>(data);
     TestMulWidened<int32>(data);
@@ -467,12 +712,72 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
     TestMulWidened<uint16>(data);
     TestMulWidened<uint32>(data);
 
+    TestAvgRoundAndMulHi<int8>(data);
+    TestAvgRoundAndMulHi<int16>(data);
+    TestAvgRoundAndMulHi<int32>(data);
+    TestAvgRoundAndMulHi<uint8>(data);
+    TestAvgRoundAndMulHi<uint16>(data);
+    TestAvgRoundAndMulHi<uint32>(data);
+    TestAvgRoundAndMulHi<int64>(data);
+    TestAvgRoundAndMulHi<uint64>(data);
+    TestArithmetic64Bit<int64>(data);
+    TestArithmetic64Bit<uint64>(data);
+    TestUnsignedCompare<uint8>(data);
+    TestUnsignedCompare<uint16>(data);
+    TestUnsignedCompare<uint32>(data);
+    TestUnsignedCompare<uint64>(data);
+    TestMulHiRound(data);
+
+    TestShifts<int8>(data);
+    TestShifts<int16>(data);
+    TestShifts<int32>(data);
+    TestShifts<int64>(data);
+    TestShifts<uint8>(data);
+    TestShifts<uint16>(data);
+    TestShifts<uint32>(data);
+    TestShifts<uint64>(data);
+
+    TestSelect<int8>(data);
+    TestSelect<int16>(data);
+    TestSelect<int32>(data);
+    TestSelect<int64>(data);
+    TestSelect<float>(data);
+    TestSelect<double>(data);
+
+    TestCompress<int8>(data);
+    TestCompress<int16>(data);
+    TestCompress<int32>(data);
+    TestCompress<int64>(data);
+    TestCompress<uint8>(data);
+    TestCompress<uint16>(data);
+    TestCompress<uint32>(data);
+    TestCompress<uint64>(data);
+    TestCompress<float>(data);
+    TestCompress<double>(data);
+
     // ----- dimsum::x86::*
     TestMaddubs(data);
   }
 
   if (size >= dimsum::detail::kMachineWidth * 3) {
     TestMulSum<int16, int32>(data);
+    TestDotProduct(data);
+    TestBlendU8(data);
+  }
+
+  if (size >= dimsum::detail::kMachineWidth * 4) {
+    TestInterleaved<2, uint8>(data);
+    TestInterleaved<3, uint8>(data);
+    TestInterleaved<4, uint8>(data);
+    TestInterleaved<2, uint16>(data);
+    TestInterleaved<3, uint16>(data);
+    TestInterleaved<4, uint16>(data);
+    TestInterleaved<2, uint32>(data);
+    TestInterleaved<3, uint32>(data);
+    TestInterleaved<4, uint32>(data);
+    TestInterleaved<2, uint64>(data);
+    TestInterleaved<3, uint64>(data);
+    TestInterleaved<4, uint64>(data);
   }
 
   return 0;
@@ -0,0 +1,449 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_DIMSUM_GEMM_H_
+#define DIMSUM_DIMSUM_GEMM_H_
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "dimsum.h"
+
+// Matrix multiplication with packed panels and register-blocked micro-kernels.
+//
+// gemm computes C = A * B for row-major matrices. Supported element types are
+// uint8 * int8, int8 * int8 and int16 * int16, accumulated in int32, and
+// float and double, accumulated with fma.
+//
+// The structure is the usual one for BLAS-like libraries: B is packed in
+// blocks of kKc x kNc and A in blocks of kMc x kKc, so that a block of A stays
+// in L2 while it is multiplied by a panel of B in L1. The micro-kernel keeps a
+// kMr x kNr tile of C in kMr * kNv vector registers. Elements of A and B are
+// packed in groups of kGroup consecutive k, the number that one accumulator
+// lane sums at a time (4 for dot_u8s8_i32, 2 for mul_sum, 1 for fma), and
+// each packed group of A is broadcast to all lanes.
+//
+// Integer results wrap around modulo 2**32. The int8 kernels inherit the
+// rounding of dot_u8s8_i32 and dot_s8s8_i32: without VNNI, x86 saturates the
+// sum of each pair of adjacent products to int16.
+//
+// gemm_batched multiplies many small matrices whose dimensions are known at
+// compile time. It skips packing and keeps a block of rows of C in registers
+// while it streams through A and B.
+
+namespace dimsum {
+namespace detail {
+
+// The number of vector registers the micro-kernels can use.
+#if defined(__AVX512VL__) || defined(__aarch64__) || defined(__VSX__)
+constexpr size_t kGemmVectorRegisters = 32;
+#else
+constexpr size_t kGemmVectorRegisters = 16;
+#endif
+
+// Defines the accumulator type and the multiply-accumulate step for a pair of
+// element types.
+template <typename TA, typename TB, typename Abi>
+struct GemmTraits;
+
+template <typename Abi>
+struct GemmTraits<uint8, int8, Abi> {
+  using Acc = int32;
+  static Simd<int32, Abi> MulAdd(Simd<int32, Abi> acc, Simd<uint8, Abi> a,
+                                 Simd<int8, Abi> b) {
+    return dot_u8s8_i32(acc, a, b);
+  }
+};
+
+template <typename Abi>
+struct GemmTraits<int8, int8, Abi> {
+  using Acc = int32;
+  static Simd<int32, Abi> MulAdd(Simd<int32, Abi> acc, Simd<int8, Abi> a,
+                                 Simd<int8, Abi> b) {
+    return dot_s8s8_i32(acc, a, b);
+  }
+};
+
+template <typename Abi>
+struct GemmTraits<int16, int16, Abi> {
+  using Acc = int32;
+  static Simd<int32, Abi> MulAdd(Simd<int32, Abi> acc, Simd<int16, Abi> a,
+                                 Simd<int16, Abi> b) {
+    return mul_sum(a, b, acc);
+  }
+};
+
+template <typename Abi>
+struct GemmTraits<float, float, Abi> {
+  using Acc = float;
+  static Simd<float, Abi> MulAdd(Simd<float, Abi> acc, Simd<float, Abi> a,
+                                 Simd<float, Abi> b) {
+    return fma(a, b, acc);
+  }
+};
+
+template <typename Abi>
+struct GemmTraits<double, double, Abi> {
+  using Acc = double;
+  static Simd<double, Abi> MulAdd(Simd<double, Abi> acc, Simd<double, Abi> a,
+                                  Simd<double, Abi> b) {
+    return fma(a, b, acc);
+  }
+};
+
+template <typename TA, typename TB, typename Abi>
+struct GemmKernel {
+  using Traits = GemmTraits<TA, TB, Abi>;
+  using Acc = typename Traits::Acc;
+  using AccSimd = Simd<Acc, Abi>;
+
+  // Elements of A and B summed by one accumulator lane per step.
+  static constexpr size_t kGroup = sizeof(Acc) / sizeof(TA);
+  static constexpr size_t kLanes = AccSimd::size();
+
+  // The micro-kernel tile is kMr rows by kNv vectors of kLanes columns; the
+  // accumulators, the kNv vectors of B and one broadcast of A fill the
+  // registers.
+  static constexpr size_t kNv = kGemmVectorRegisters >= 32 ? 4 : 2;
+  static constexpr size_t kMr = (kGemmVectorRegisters - kNv - 1) / kNv;
+  static constexpr size_t kNr = kNv * kLanes;
+
+  // Block sizes in groups (kKc) and elements (kMc, kNc). A kKc x kNr panel
+  // of packed B takes 16KB (half of a typical L1), a kMc x kKc block of A
+  // 120KB or less (L2) and a kKc x kNc block of B 2MB or less (L3).
+  static constexpr size_t kKc = 16 * 1024 / (kNr * sizeof(Acc));
+  static constexpr size_t kMc = 120 * 1024 / (kKc * sizeof(Acc)) / kMr * kMr;
+  static constexpr size_t kNc = 2048 / kNr * kNr;
+  static_assert(kMc > 0 && kNc > 0, "The vector is too wide");
+
+  // Packs rows [0, rows) and groups [0, num_groups) of a, whose first element
+  // is at group `first_group`, into panels of kMr rows: panel-major, then
+  // group-major, then row-major, one Acc-sized word per group. Rows and
+  // elements past `rows` or `k` are zero.
+  static void PackA(const TA* a, size_t lda, size_t rows, size_t k,
+                    size_t first_group, size_t num_groups, Acc* packed) {
+    for (size_t i = 0; i < rows; i += kMr) {
+      for (size_t g = 0; g < num_groups; g++) {
+        for (size_t r = 0; r < kMr; r++) {
+          TA group[kGroup] = {};
+          for (size_t t = 0; t < kGroup; t++) {
+            size_t col = (first_group + g) * kGroup + t;
+            if (i + r < rows && col < k) {
+              group[t] = a[(i + r) * lda + col];
+            }
+          }
+          memcpy(packed++, group, sizeof(group));
+        }
+      }
+    }
+  }
+
+  // Packs columns [0, cols) of b, starting with group `first_group`, into
+  // panels of kNr columns: panel-major, then group-major, then column-major,
+  // kGroup elements per column. Columns and elements past `cols` or `k` are
+  // zero.
+  static void PackB(const TB* b, size_t ldb, size_t cols, size_t k,
+                    size_t first_group, size_t num_groups, TB* packed) {
+    // Rows of b are read in order; each group goes to every panel.
+    const size_t panel_size = num_groups * kNr * kGroup;
+    for (size_t g = 0; g < num_groups; g++) {
+      const size_t row = (first_group + g) * kGroup;
+      for (size_t j = 0; j < cols; j += kNr) {
+        TB* out = packed + j / kNr * panel_size + g * kNr * kGroup;
+        if (j + kNr <= cols && row + kGroup <= k) {
+          PackGroup(b + row * ldb + j, ldb, out,
+                    std::integral_constant<bool, kGroup == 1>());
+          continue;
+        }
+        for (size_t c = 0; c < kNr; c++) {
+          for (size_t t = 0; t < kGroup; t++) {
+            out[c * kGroup + t] = j + c < cols && row + t < k
+                                      ? b[(row + t) * ldb + j + c]
+                                      : TB{};
+          }
+        }
+      }
+    }
+  }
+
+  // Packs kNr columns of kGroup rows of b, ldb apart. Each column becomes a
+  // word of its kGroup elements, built by widening the rows and shifting
+  // them into place (the byte order is little-endian).
+  static void PackGroup(const TB* b, size_t ldb, TB* packed, std::false_type) {
+    using Unsigned = typename std::make_unsigned<TB>::type;
+    using Word = ScaleBy<Unsigned, kGroup>;
+    using RowSimd = ResizeTo<Simd<Unsigned, Abi>, kLanes>;
+    const Unsigned* src = reinterpret_cast<const Unsigned*>(b);
+    for (size_t v = 0; v < kNv; v++) {
+      Simd<Word, Abi> words(0);
+      for (size_t t = 0; t < kGroup; t++) {
+        RowSimd row(src + t * ldb + v * kLanes, flags::element_aligned);
+        words |= shl(static_simd_cast<Word>(row), t * sizeof(TB) * CHAR_BIT);
+      }
+      bit_cast<TB>(words).memstore(packed + v * kLanes * kGroup,
+                                   flags::element_aligned);
+    }
+  }
+
+  static void PackGroup(const TB* b, size_t /*ldb*/, TB* packed,
+                        std::true_type) {
+    std::copy(b, b + kNr, packed);
+  }
+
+  // Multiplies a packed panel of A by a packed panel of B and adds the
+  // product to the rows x cols tile of C (or stores it, if !accumulate).
+  static void MicroKernel(size_t num_groups, const Acc* a, const TB* b,
+                          Acc* c, size_t ldc, size_t rows, size_t cols,
+                          bool accumulate) {
+    MicroKernelImpl(make_index_sequence<kNv>(),
+                    make_index_sequence<kMr * kNv>(), num_groups, a, b, c,
+                    ldc, rows, cols, accumulate);
+  }
+
+  // Accumulator kTile holds row kTile / kNv and vector kTile % kNv of the
+  // tile. The packs are expanded so that every index is a constant and the
+  // accumulators can live in registers.
+  template <size_t... kVectors, size_t... kTile>
+  static void MicroKernelImpl(index_sequence<kVectors...>,
+                              index_sequence<kTile...>, size_t num_groups,
+                              const Acc* a, const TB* b, Acc* c, size_t ldc,
+                              size_t rows, size_t cols, bool accumulate) {
+    AccSimd acc[] = {(static_cast<void>(kTile), AccSimd(0))...};
+    for (size_t g = 0; g < num_groups; g++) {
+      const TB* b_group = b + g * kNr * kGroup;
+      const Acc* a_group = a + g * kMr;
+      Simd<TB, Abi> bv[] = {Simd<TB, Abi>(b_group + kVectors * kLanes * kGroup,
+                                          flags::element_aligned)...};
+      int expand[] = {(acc[kTile] = Traits::MulAdd(
+                           acc[kTile],
+                           bit_cast<TA>(AccSimd(a_group[kTile / kNv])),
+                           bv[kTile % kNv]),
+                       0)...};
+      static_cast<void>(expand);
+    }
+
+    if (rows == kMr && cols == kNr) {
+      int store[] = {
+          (StoreTileVector(acc[kTile],
+                           c + kTile / kNv * ldc + kTile % kNv * kLanes,
+                           accumulate),
+           0)...};
+      static_cast<void>(store);
+      return;
+    }
+    Acc tile[kMr * kNr];
+    int spill[] = {(acc[kTile].memstore(tile + kTile * kLanes,
+                                        flags::element_aligned),
+                    0)...};
+    static_cast<void>(spill);
+    for (size_t r = 0; r < rows; r++) {
+      for (size_t j = 0; j < cols; j++) {
+        Acc sum = tile[r * kNr + j];
+        c[r * ldc + j] = accumulate ? c[r * ldc + j] + sum : sum;
+      }
+    }
+  }
+
+  static void StoreTileVector(AccSimd acc, Acc* out, bool accumulate) {
+    if (accumulate) {
+      acc += AccSimd(out, flags::element_aligned);
+    }
+    acc.memstore(out, flags::element_aligned);
+  }
+
+  // Computes C = A * B on the calling thread.
+  static void Gemm(size_t m, size_t n, size_t k, const TA* a, size_t lda,
+                   const TB* b, size_t ldb, Acc* c, size_t ldc) {
+    if (k == 0) {
+      for (size_t i = 0; i < m; i++) {
+        std::fill(c + i * ldc, c + i * ldc + n, Acc{0});
+      }
+      return;
+    }
+    const size_t num_groups = (k + kGroup - 1) / kGroup;
+    std::vector<Acc> packed_a(kMc * kKc);
+    std::vector<TB> packed_b(kNc * kKc * kGroup);
+    for (size_t j0 = 0; j0 < n; j0 += kNc) {
+      const size_t nc = std::min(kNc, n - j0);
+      for (size_t g0 = 0; g0 < num_groups; g0 += kKc) {
+        const size_t kc = std::min(kKc, num_groups - g0);
+        PackB(b + j0, ldb, nc, k, g0, kc, packed_b.data());
+        for (size_t i0 = 0; i0 < m; i0 += kMc) {
+          const size_t mc = std::min(kMc, m - i0);
+          PackA(a + i0 * lda, lda, mc, k, g0, kc, packed_a.data());
+          for (size_t j = 0; j < nc; j += kNr) {
+            for (size_t i = 0; i < mc; i += kMr) {
+              MicroKernel(kc, &packed_a[i * kc], &packed_b[j * kc * kGroup],
+                          c + (i0 + i) * ldc + j0 + j, ldc,
+                          std::min(kMr, mc - i), std::min(kNr, nc - j),
+                          g0 != 0);
+            }
+          }
+        }
+      }
+    }
+  }
+};
+
+template <typename TA, typename TB, typename Abi>
+constexpr size_t GemmKernel<TA, TB, Abi>::kGroup;
+template <typename TA, typename TB, typename Abi>
+constexpr size_t GemmKernel<TA, TB, Abi>::kLanes;
+template <typename TA, typename TB, typename Abi>
+constexpr size_t GemmKernel<TA, TB, Abi>::kNv;
+template <typename TA, typename TB, typename Abi>
+constexpr size_t GemmKernel<TA, TB, Abi>::kMr;
+template <typename TA, typename TB, typename Abi>
+constexpr size_t GemmKernel<TA, TB, Abi>::kNr;
+template <typename TA, typename TB, typename Abi>
+constexpr size_t GemmKernel<TA, TB, Abi>::kKc;
+template <typename TA, typename TB, typename Abi>
+constexpr size_t GemmKernel<TA, TB, Abi>::kMc;
+template <typename TA, typename TB, typename Abi>
+constexpr size_t GemmKernel<TA, TB, Abi>::kNc;
+
+constexpr size_t FloorPowerOfTwo(size_t n) {
+  return n < 2 ? 1 : 2 * FloorPowerOfTwo(n / 2);
+}
+
+// C = A * B for one kM x kK matrix A and one kK x kN matrix B of type T. Rows
+// of C are split into vectors of kW lanes, and blocks of kRows rows are
+// accumulated in registers; columns past the last full vector are computed
+// one by one.
+template <size_t kM, size_t kN, size_t kK, typename T>
+struct SmallGemm {
+  static constexpr size_t kW =
+      std::min(NativeSimd<T>::size(), FloorPowerOfTwo(kN));
+  using RowSimd = ResizeTo<NativeSimd<T>, kW>;
+  static constexpr size_t kNv = kN / kW;
+  static constexpr size_t kRows = std::max<size_t>(
+      1, std::min(kM, (kGemmVectorRegisters - kNv - 1) / kNv));
+
+  static void Multiply(const T* a, const T* b, T* c) {
+    size_t i = 0;
+    for (; i + kRows <= kM; i += kRows) {
+      RowBlock(a + i * kK, b, c + i * kN, make_index_sequence<kNv>(),
+               make_index_sequence<kRows * kNv>());
+    }
+    if (kM % kRows != 0) {
+      RowBlock(a + i * kK, b, c + i * kN, make_index_sequence<kNv>(),
+               make_index_sequence<kM % kRows * kNv>());
+    }
+    for (size_t row = 0; row < kM; row++) {
+      for (size_t j = kNv * kW; j < kN; j++) {
+        T sum = 0;
+        for (size_t p = 0; p < kK; p++) {
+          sum += a[row * kK + p] * b[p * kN + j];
+        }
+        c[row * kN + j] = sum;
+      }
+    }
+  }
+
+  // Accumulator kTile holds row kTile / kNv and vector kTile % kNv of the
+  // block, as in GemmKernel::MicroKernelImpl. The arrays end with an unused
+  // element so that they are not empty.
+  template <size_t... kVectors, size_t... kTile>
+  static void RowBlock(const T* a, const T* b, T* c,
+                       index_sequence<kVectors...>, index_sequence<kTile...>) {
+    // a and c are only read through the packs, which can be empty.
+    static_cast<void>(a);
+    static_cast<void>(c);
+    RowSimd acc[] = {(static_cast<void>(kTile), RowSimd(0))..., RowSimd(0)};
+    for (size_t p = 0; p < kK; p++) {
+      RowSimd bv[] = {RowSimd(b + p * kN + kVectors * kW,
+                              flags::element_aligned)...,
+                      RowSimd(0)};
+      int expand[] = {(acc[kTile] = fma(RowSimd(a[kTile / kNv * kK + p]),
+                                        bv[kTile % kNv], acc[kTile]),
+                       0)...,
+                      0};
+      static_cast<void>(expand);
+    }
+    int store[] = {(acc[kTile].memstore(c + kTile / kNv * kN + kTile % kNv * kW,
+                                        flags::element_aligned),
+                    0)...,
+                   0};
+    static_cast<void>(store);
+  }
+};
+
+// Products smaller than this many multiply-adds are not worth a thread.
+constexpr size_t kMinParallelGemmSize = 1 << 22;
+
+}  // namespace detail
+
+// Computes C = A * B, where A is m x k, B is k x n and C is m x n, all stored
+// row-major with lda, ldb and ldc elements between rows. The columns of C (or
+// its rows, if it has too few columns) are split between up to `num_threads`
+// threads, including the calling one.
+//
+// Abi selects the vector width of the micro-kernel.
+template <typename Abi = NativeSimd<int32>::abi_type, typename TA,
+          typename TB, typename TC>
+void gemm(size_t m, size_t n, size_t k, const TA* a, size_t lda, const TB* b,
+          size_t ldb, TC* c, size_t ldc,
+          size_t num_threads = std::thread::hardware_concurrency()) {
+  using Kernel = detail::GemmKernel<TA, TB, Abi>;
+  static_assert(std::is_same<TC, typename Kernel::Acc>::value,
+                "C must have the accumulator type of A and B");
+  num_threads = std::min(std::max<size_t>(num_threads, 1),
+                         m * n * k / detail::kMinParallelGemmSize + 1);
+  if (num_threads == 1) {
+    Kernel::Gemm(m, n, k, a, lda, b, ldb, c, ldc);
+    return;
+  }
+
+  std::vector<std::thread> threads;
+  if (n >= num_threads * Kernel::kNr) {
+    size_t chunk = (n / Kernel::kNr + num_threads - 1) / num_threads *
+                   Kernel::kNr;
+    for (size_t j = chunk; j < n; j += chunk) {
+      threads.emplace_back(Kernel::Gemm, m, std::min(chunk, n - j), k, a, lda,
+                           b + j, ldb, c + j, ldc);
+    }
+    Kernel::Gemm(m, std::min(chunk, n), k, a, lda, b, ldb, c, ldc);
+  } else {
+    size_t chunk = (m / Kernel::kMr + num_threads) / num_threads * Kernel::kMr;
+    for (size_t i = chunk; i < m; i += chunk) {
+      threads.emplace_back(Kernel::Gemm, std::min(chunk, m - i), n, k,
+                           a + i * lda, lda, b, ldb, c + i * ldc, ldc);
+    }
+    Kernel::Gemm(std::min(chunk, m), n, k, a, lda, b, ldb, c, ldc);
+  }
+  for (std::thread& thread : threads) thread.join();
+}
+
+// Computes c[i] = a[i] * b[i] for i in [0, batch_size), where a[i] is the
+// kM x kK matrix at a + i * kM * kK, b[i] the kK x kN matrix at b + i * kK * kN
+// and c[i] the kM x kN matrix at c + i * kM * kN, all stored row-major.
+//
+// Example: multiply 1000 pairs of 4x4 float matrices.
+//   gemm_batched<4, 4, 4>(a, b, c, 1000);
+template <size_t kM, size_t kN, size_t kK, typename T>
+void gemm_batched(const T* a, const T* b, T* c, size_t batch_size) {
+  static_assert(std::is_floating_point<T>::value,
+                "Only floating point types are supported");
+  for (size_t i = 0; i < batch_size; i++) {
+    detail::SmallGemm<kM, kN, kK, T>::Multiply(a + i * kM * kK, b + i * kK * kN,
+                                               c + i * kM * kN);
+  }
+}
+
+}  // namespace dimsum
+
+#endif  // DIMSUM_DIMSUM_GEMM_H_
@@ -0,0 +1,163 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "dimsum_gemm.h"
+
+namespace dimsum {
+namespace {
+
+// Arguments are m, n and k. Both a multiply and an add count as operations.
+template <typename T>
+std::vector<T> MakeMatrix(size_t size) {
+  std::mt19937 rng(42);
+  std::vector<T> matrix(size);
+  for (T& element : matrix) element = static_cast<T>(rng() % 128);
+  return matrix;
+}
+
+template <typename T>
+void SetOpsProcessed(benchmark::State& state) {
+  const char* name = std::is_floating_point<T>::value ? "GFLOP/s" : "GOP/s";
+  state.counters[name] = benchmark::Counter(
+      2e-9 * state.range(0) * state.range(1) * state.range(2) *
+          state.iterations(),
+      benchmark::Counter::kIsRate);
+}
+
+template <typename TA, typename TB>
+using GemmAcc =
+    typename detail::GemmTraits<TA, TB, NativeSimd<int32>::abi_type>::Acc;
+
+template <typename TA, typename TB>
+void BM_GemmNaive(benchmark::State& state) {
+  const size_t m = state.range(0), n = state.range(1), k = state.range(2);
+  auto a = MakeMatrix<TA>(m * k);
+  auto b = MakeMatrix<TB>(k * n);
+  std::vector<GemmAcc<TA, TB>> c(m * n);
+  for (auto _ : state) {
+    for (size_t i = 0; i < m; i++) {
+      for (size_t j = 0; j < n; j++) {
+        GemmAcc<TA, TB> sum = 0;
+        for (size_t p = 0; p < k; p++) {
+          sum += GemmAcc<TA, TB>{a[i * k + p]} * b[p * n + j];
+        }
+        c[i * n + j] = sum;
+      }
+    }
+    benchmark::DoNotOptimize(c.data());
+  }
+  SetOpsProcessed<TA>(state);
+}
+
+template <typename TA, typename TB>
+void BM_Gemm(benchmark::State& state) {
+  const size_t m = state.range(0), n = state.range(1), k = state.range(2);
+  auto a = MakeMatrix<TA>(m * k);
+  auto b = MakeMatrix<TB>(k * n);
+  std::vector<GemmAcc<TA, TB>> c(m * n);
+  for (auto _ : state) {
+    gemm(m, n, k, a.data(), k, b.data(), n, c.data(), n);
+    benchmark::DoNotOptimize(c.data());
+  }
+  SetOpsProcessed<TA>(state);
+}
+
+void GemmShapes(benchmark::internal::Benchmark* b) {
+  b->Args({1, 4096, 4096});
+  b->Args({128, 1024, 1024});
+  b->Args({256, 256, 256});
+  b->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK_TEMPLATE(BM_GemmNaive, uint8, int8)->Apply(GemmShapes);
+BENCHMARK_TEMPLATE(BM_Gemm, uint8, int8)->Apply(GemmShapes);
+BENCHMARK_TEMPLATE(BM_GemmNaive, int8, int8)->Apply(GemmShapes);
+BENCHMARK_TEMPLATE(BM_Gemm, int8, int8)->Apply(GemmShapes);
+BENCHMARK_TEMPLATE(BM_GemmNaive, int16, int16)->Apply(GemmShapes);
+BENCHMARK_TEMPLATE(BM_Gemm, int16, int16)->Apply(GemmShapes);
+BENCHMARK_TEMPLATE(BM_GemmNaive, float, float)->Apply(GemmShapes);
+BENCHMARK_TEMPLATE(BM_Gemm, float, float)->Apply(GemmShapes);
+BENCHMARK_TEMPLATE(BM_GemmNaive, double, double)->Apply(GemmShapes);
+BENCHMARK_TEMPLATE(BM_Gemm, double, double)->Apply(GemmShapes);
+
+// Multiplies kBatchSize independent kSize x kSize matrices.
+constexpr size_t kBatchSize = 1024;
+
+template <size_t kSize, typename T>
+void SetBatchedFlopsProcessed(benchmark::State& state) {
+  state.counters["GFLOP/s"] = benchmark::Counter(
+      2e-9 * kSize * kSize * kSize * kBatchSize * state.iterations(),
+      benchmark::Counter::kIsRate);
+}
+
+template <size_t kSize, typename T>
+void BM_GemmBatchedNaive(benchmark::State& state) {
+  constexpr size_t kElements = kSize * kSize;
+  auto a = MakeMatrix<T>(kElements * kBatchSize);
+  auto b = MakeMatrix<T>(kElements * kBatchSize);
+  std::vector<T> c(kElements * kBatchSize);
+  for (auto _ : state) {
+    for (size_t batch = 0; batch < kBatchSize; batch++) {
+      const T* a_batch = &a[batch * kElements];
+      const T* b_batch = &b[batch * kElements];
+      T* c_batch = &c[batch * kElements];
+      for (size_t i = 0; i < kSize; i++) {
+        for (size_t j = 0; j < kSize; j++) {
+          T sum = 0;
+          for (size_t p = 0; p < kSize; p++) {
+            sum += a_batch[i * kSize + p] * b_batch[p * kSize + j];
+          }
+          c_batch[i * kSize + j] = sum;
+        }
+      }
+    }
+    benchmark::DoNotOptimize(c.data());
+  }
+  SetBatchedFlopsProcessed<kSize, T>(state);
+}
+
+template <size_t kSize, typename T>
+void BM_GemmBatched(benchmark::State& state) {
+  constexpr size_t kElements = kSize * kSize;
+  auto a = MakeMatrix<T>(kElements * kBatchSize);
+  auto b = MakeMatrix<T>(kElements * kBatchSize);
+  std::vector<T> c(kElements * kBatchSize);
+  for (auto _ : state) {
+    gemm_batched<kSize, kSize, kSize>(a.data(), b.data(), c.data(),
+                                      kBatchSize);
+    benchmark::DoNotOptimize(c.data());
+  }
+  SetBatchedFlopsProcessed<kSize, T>(state);
+}
+
+BENCHMARK_TEMPLATE(BM_GemmBatchedNaive, 4, float);
+BENCHMARK_TEMPLATE(BM_GemmBatched, 4, float);
+BENCHMARK_TEMPLATE(BM_GemmBatchedNaive, 8, float);
+BENCHMARK_TEMPLATE(BM_GemmBatched, 8, float);
+BENCHMARK_TEMPLATE(BM_GemmBatchedNaive, 16, float);
+BENCHMARK_TEMPLATE(BM_GemmBatched, 16, float);
+BENCHMARK_TEMPLATE(BM_GemmBatchedNaive, 32, float);
+BENCHMARK_TEMPLATE(BM_GemmBatched, 32, float);
+BENCHMARK_TEMPLATE(BM_GemmBatchedNaive, 4, double);
+BENCHMARK_TEMPLATE(BM_GemmBatched, 4, double);
+BENCHMARK_TEMPLATE(BM_GemmBatchedNaive, 16, double);
+BENCHMARK_TEMPLATE(BM_GemmBatched, 16, double);
+
+}  // namespace
+}  // namespace dimsum
@@ -0,0 +1,148 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dimsum_gemm.h"
+
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+// Returns a value for which no lowering saturates or rounds: [0, 127] for
+// uint8, [-127, 127] for other integers and small integers for floating
+// point types.
+template <typename T>
+T RandomElement(std::mt19937* rng) {
+  if (std::is_floating_point<T>::value) {
+    return static_cast<T>(static_cast<int>((*rng)() % 17) - 8);
+  }
+  if (std::is_unsigned<T>::value) {
+    return static_cast<T>((*rng)() % 128);
+  }
+  return static_cast<T>(static_cast<int>((*rng)() % 255) - 127);
+}
+
+// C is padded to ldc = n + 3 to catch stores past the end of the rows.
+template <typename TA, typename TB, typename Abi = NativeSimd<int32>::abi_type>
+void TestGemm(size_t m, size_t n, size_t k, size_t num_threads = 1) {
+  using TC = typename detail::GemmTraits<TA, TB, Abi>::Acc;
+  std::mt19937 rng(m * 10007 + n * 101 + k);
+  std::vector<TA> a(m * k);
+  std::vector<TB> b(k * n);
+  for (TA& x : a) x = RandomElement<TA>(&rng);
+  for (TB& x : b) x = RandomElement<TB>(&rng);
+
+  const size_t ldc = n + 3;
+  std::vector<TC> c(m * ldc, 12345);
+  gemm<Abi>(m, n, k, a.data(), k, b.data(), n, c.data(), ldc, num_threads);
+  for (size_t i = 0; i < m; i++) {
+    for (size_t j = 0; j < ldc; j++) {
+      TC expected = 12345;
+      if (j < n) {
+        expected = 0;
+        for (size_t p = 0; p < k; p++) {
+          expected += TC{a[i * k + p]} * TC{b[p * n + j]};
+        }
+      }
+      ASSERT_EQ(expected, c[i * ldc + j])
+          << m << "x" << n << "x" << k << " at " << i << ", " << j;
+    }
+  }
+}
+
+template <typename TA, typename TB>
+void TestGemmShapes() {
+  for (size_t m : {1, 2, 7, 13}) {
+    for (size_t n : {1, 5, 16, 33}) {
+      for (size_t k : {0, 1, 3, 4, 9, 64}) {
+        TestGemm<TA, TB>(m, n, k);
+      }
+    }
+  }
+  // Several blocks of rows and of k, then of columns.
+  TestGemm<TA, TB>(130, 20, 1100);
+  TestGemm<TA, TB>(3, 2100, 9);
+}
+
+TEST(DimsumGemmTest, U8S8) { TestGemmShapes<uint8, int8>(); }
+
+TEST(DimsumGemmTest, S8S8) { TestGemmShapes<int8, int8>(); }
+
+TEST(DimsumGemmTest, S16S16) { TestGemmShapes<int16, int16>(); }
+
+TEST(DimsumGemmTest, Float) { TestGemmShapes<float, float>(); }
+
+TEST(DimsumGemmTest, Double) { TestGemmShapes<double, double>(); }
+
+TEST(DimsumGemmTest, Abi) {
+  TestGemm<uint8, int8, Simd128<int32>::abi_type>(9, 20, 70);
+  TestGemm<int16, int16, Simd64<int32>::abi_type>(9, 20, 70);
+  TestGemm<float, float, Simd128<float>::abi_type>(9, 20, 70);
+}
+
+TEST(DimsumGemmTest, Threads) {
+  // Split by columns.
+  TestGemm<uint8, int8>(64, 300, 256, 4);
+  // Too few columns; split by rows.
+  TestGemm<int8, int8>(300, 8, 2048, 4);
+}
+
+template <size_t kM, size_t kN, size_t kK, typename T>
+void TestGemmBatched() {
+  constexpr size_t kBatchSize = 3;
+  std::mt19937 rng(kM * 10007 + kN * 101 + kK);
+  std::vector<T> a(kBatchSize * kM * kK), b(kBatchSize * kK * kN);
+  for (T& x : a) x = RandomElement<T>(&rng);
+  for (T& x : b) x = RandomElement<T>(&rng);
+  // One more matrix to catch stores past the end.
+  std::vector<T> c((kBatchSize + 1) * kM * kN, 12345);
+  gemm_batched<kM, kN, kK>(a.data(), b.data(), c.data(), kBatchSize);
+  for (size_t batch = 0; batch < kBatchSize; batch++) {
+    for (size_t i = 0; i < kM; i++) {
+      for (size_t j = 0; j < kN; j++) {
+        T expected = 0;
+        for (size_t p = 0; p < kK; p++) {
+          expected +=
+              a[(batch * kM + i) * kK + p] * b[(batch * kK + p) * kN + j];
+        }
+        ASSERT_EQ(expected, c[(batch * kM + i) * kN + j])
+            << kM << "x" << kN << "x" << kK << " #" << batch << " at " << i
+            << ", " << j;
+      }
+    }
+  }
+  for (size_t i = kBatchSize * kM * kN; i < c.size(); i++) {
+    ASSERT_EQ(12345, c[i]) << i;
+  }
+}
+
+TEST(DimsumGemmTest, Batched) {
+  TestGemmBatched<1, 1, 1, float>();
+  TestGemmBatched<4, 4, 4, float>();
+  TestGemmBatched<3, 5, 7, float>();
+  TestGemmBatched<8, 8, 8, float>();
+  TestGemmBatched<13, 12, 3, float>();
+  TestGemmBatched<16, 16, 16, float>();
+  TestGemmBatched<64, 64, 64, float>();
+  TestGemmBatched<4, 4, 4, double>();
+  TestGemmBatched<7, 9, 5, double>();
+  TestGemmBatched<32, 32, 32, double>();
+}
+
+}  // namespace
+}  // namespace dimsum
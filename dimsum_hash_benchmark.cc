@@ -0,0 +1,89 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "dimsum_hash.h"
+
+namespace dimsum {
+namespace {
+
+constexpr size_t kNumKeys = 1 << 14;
+
+template <typename T>
+std::vector<T> MakeKeys() {
+  std::vector<T> keys(kNumKeys);
+  for (size_t i = 0; i < keys.size(); i++) {
+    keys[i] = static_cast<T>(i * 0x9e3779b97f4a7c15ull);
+  }
+  return keys;
+}
+
+uint32 HashScalar(uint32 key) { return hash_u32(key); }
+uint64 HashScalar(uint64 key) { return hash_u64(key); }
+
+template <typename T>
+void BM_HashScalar(benchmark::State& state) {
+  auto keys = MakeKeys<T>();
+  std::vector<T> out(kNumKeys);
+  for (auto _ : state) {
+    for (size_t i = 0; i < kNumKeys; i++) {
+      out[i] = HashScalar(keys[i]);
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumKeys);
+}
+BENCHMARK_TEMPLATE(BM_HashScalar, uint32);
+BENCHMARK_TEMPLATE(BM_HashScalar, uint64);
+
+template <typename T>
+void BM_HashNativeSimd(benchmark::State& state) {
+  auto keys = MakeKeys<T>();
+  std::vector<T> out(kNumKeys);
+  constexpr size_t kStep = NativeSimd<T>::size();
+  for (auto _ : state) {
+    for (size_t i = 0; i < kNumKeys; i += kStep) {
+      detail::HashLanes(NativeSimd<T>(&keys[i], flags::element_aligned), T{0})
+          .memstore(&out[i], flags::element_aligned);
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumKeys);
+}
+BENCHMARK_TEMPLATE(BM_HashNativeSimd, uint32);
+BENCHMARK_TEMPLATE(BM_HashNativeSimd, uint64);
+
+template <typename T, size_t kBatch>
+void BM_HashStrided(benchmark::State& state) {
+  auto keys = MakeKeys<T>();
+  std::vector<T> out(kNumKeys);
+  for (auto _ : state) {
+    for (size_t i = 0; i < kNumKeys; i += kBatch) {
+      hash_strided<kBatch>(&keys[i], sizeof(T), &out[i]);
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumKeys);
+}
+BENCHMARK_TEMPLATE(BM_HashStrided, uint32, 4);
+BENCHMARK_TEMPLATE(BM_HashStrided, uint32, 8);
+BENCHMARK_TEMPLATE(BM_HashStrided, uint32, 16);
+BENCHMARK_TEMPLATE(BM_HashStrided, uint64, 4);
+BENCHMARK_TEMPLATE(BM_HashStrided, uint64, 8);
+BENCHMARK_TEMPLATE(BM_HashStrided, uint64, 16);
+
+}  // namespace
+}  // namespace dimsum
@@ -0,0 +1,101 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dimsum_hash.h"
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+TEST(DimsumHashTest, ScalarMatchesXxHash) {
+  // Reference values are computed by the xxHash reference implementation
+  // (0.8.3), hashing the little-endian bytes of each key, e.g. in Python:
+  //   xxhash.xxh32(struct.pack("<I", 0x12345678)).intdigest()
+  //   xxhash.xxh64(struct.pack("<Q", 0), seed=7).intdigest()
+  EXPECT_EQ(0xf08a22b0u, hash_u32(0x12345678u));
+  EXPECT_EQ(0x14f110a0u, hash_u32(0u, 7));
+  EXPECT_EQ(0xea3c52081e9843ecull, hash_u64(0x0123456789abcdefull));
+  EXPECT_EQ(0x8562a8ca30d1d8c7ull, hash_u64(0ull, 7));
+}
+
+template <typename SimdType>
+void TestHashU32() {
+  for (uint32 seed : {0u, 7u, 0xdeadbeefu}) {
+    SimdType keys([](int i) { return i * 0x9e3779b9u + 1; });
+    auto hashes = hash_u32(keys, seed);
+    for (int i = 0; i < keys.size(); i++) {
+      EXPECT_EQ(hash_u32(keys[i], seed), hashes[i]) << i;
+    }
+  }
+}
+
+template <typename SimdType>
+void TestHashU64() {
+  for (uint64 seed : {0ull, 7ull, 0xdeadbeefcafef00dull}) {
+    SimdType keys(
+        [](int i) { return i * 0x9e3779b97f4a7c15ull + 0xffffffffull; });
+    auto hashes = hash_u64(keys, seed);
+    for (int i = 0; i < keys.size(); i++) {
+      EXPECT_EQ(hash_u64(keys[i], seed), hashes[i]) << i;
+    }
+  }
+}
+
+TEST(DimsumHashTest, HashU32) {
+  TestHashU32<Simd64<uint32>>();
+  TestHashU32<Simd128<uint32>>();
+  TestHashU32<NativeSimd<uint32>>();
+  TestHashU32<ResizeTo<NativeSimd<uint32>, 16>>();
+}
+
+TEST(DimsumHashTest, HashU64) {
+  TestHashU64<Simd128<uint64>>();
+  TestHashU64<NativeSimd<uint64>>();
+  TestHashU64<ResizeTo<NativeSimd<uint64>, 16>>();
+}
+
+struct Row {
+  uint32 id32;
+  uint64 id64;
+  double payload;
+};
+
+template <size_t kNumKeys>
+void TestHashStrided() {
+  Row rows[kNumKeys];
+  for (size_t i = 0; i < kNumKeys; i++) {
+    rows[i].id32 = static_cast<uint32>(i * 977 + 3);
+    rows[i].id64 = i * 0x100000001ull + 5;
+    rows[i].payload = i;
+  }
+
+  uint32 hashes32[kNumKeys];
+  hash_strided<kNumKeys>(&rows[0].id32, sizeof(Row), hashes32, uint32{11});
+  uint64 hashes64[kNumKeys];
+  hash_strided<kNumKeys>(&rows[0].id64, sizeof(Row), hashes64, uint64{11});
+  for (size_t i = 0; i < kNumKeys; i++) {
+    EXPECT_EQ(hash_u32(rows[i].id32, 11), hashes32[i]) << i;
+    EXPECT_EQ(hash_u64(rows[i].id64, 11), hashes64[i]) << i;
+  }
+}
+
+TEST(DimsumHashTest, HashStrided) {
+  TestHashStrided<4>();
+  TestHashStrided<8>();
+  TestHashStrided<16>();
+}
+
+}  // namespace
+}  // namespace dimsum
@@ -0,0 +1,126 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "benchmark/benchmark.h"
+#include "benchmark_util.h"
+#include "dimsum.h"
+#include "simulated.h"
+
+namespace dimsum {
+namespace {
+
+using bench::kNumValues;
+
+enum class Op { kMul, kMulHi, kMin, kMax, kCmpGt };
+
+template <Op kOp, typename T>
+T ApplyScalar(T lhs, T rhs) {
+  switch (kOp) {
+    case Op::kMul:
+      return static_cast<T>(static_cast<uint64>(lhs) * rhs);
+    case Op::kMulHi:
+      return detail::MulHiScalar(lhs, rhs);
+    case Op::kMin:
+      return lhs < rhs ? lhs : rhs;
+    case Op::kMax:
+      return lhs > rhs ? lhs : rhs;
+    case Op::kCmpGt:
+      return lhs > rhs ? ~T{0} : T{0};
+  }
+}
+
+// What the generic Simd operations lower to without the x86
+// specializations.
+template <Op kOp, typename Vec>
+Vec ApplyVectorExtension(Vec lhs, Vec rhs) {
+  switch (kOp) {
+    case Op::kMul:
+      return lhs * rhs;
+    case Op::kMulHi:
+      break;
+    case Op::kMin:
+      return lhs < rhs ? lhs : rhs;
+    case Op::kMax:
+      return lhs > rhs ? lhs : rhs;
+    case Op::kCmpGt:
+      return reinterpret_cast<Vec>(lhs > rhs);
+  }
+  return lhs;
+}
+
+template <Op kOp, typename T, typename Abi>
+Simd<T, Abi> ApplySimd(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
+  switch (kOp) {
+    case Op::kMul:
+      return lhs * rhs;
+    case Op::kMulHi:
+      return mul_hi(lhs, rhs);
+    case Op::kMin:
+      return min(lhs, rhs);
+    case Op::kMax:
+      return max(lhs, rhs);
+    case Op::kCmpGt:
+      return bit_cast<T>(cmp_gt(lhs, rhs));
+  }
+}
+
+template <Op kOp, typename T>
+void BM_Int64Scalar(benchmark::State& state) {
+  bench::ScalarLoop(state,
+                    [](T lhs, T rhs) { return ApplyScalar<kOp>(lhs, rhs); },
+                    bench::MakeValues<T>(0), bench::MakeValues<T>(kNumValues));
+}
+
+template <Op kOp, typename T>
+void BM_Int64VectorExtension(benchmark::State& state) {
+  using Vec = bench::NativeVec<T>;
+  bench::VectorExtensionLoop(
+      state,
+      [](Vec lhs, Vec rhs) { return ApplyVectorExtension<kOp>(lhs, rhs); },
+      bench::MakeValues<T>(0), bench::MakeValues<T>(kNumValues));
+}
+
+template <Op kOp, typename T>
+void BM_Int64NativeSimd(benchmark::State& state) {
+  bench::SimdLoop(
+      state,
+      [](NativeSimd<T> lhs, NativeSimd<T> rhs) {
+        return ApplySimd<kOp>(lhs, rhs);
+      },
+      bench::MakeValues<T>(0), bench::MakeValues<T>(kNumValues));
+}
+
+#define DIMSUM_INT64_BENCHMARKS(op)                          \
+  BENCHMARK_TEMPLATE(BM_Int64Scalar, op, int64);             \
+  BENCHMARK_TEMPLATE(BM_Int64VectorExtension, op, int64);    \
+  BENCHMARK_TEMPLATE(BM_Int64NativeSimd, op, int64);         \
+  BENCHMARK_TEMPLATE(BM_Int64Scalar, op, uint64);            \
+  BENCHMARK_TEMPLATE(BM_Int64VectorExtension, op, uint64);   \
+  BENCHMARK_TEMPLATE(BM_Int64NativeSimd, op, uint64)
+
+DIMSUM_INT64_BENCHMARKS(Op::kMul);
+DIMSUM_INT64_BENCHMARKS(Op::kMin);
+DIMSUM_INT64_BENCHMARKS(Op::kMax);
+DIMSUM_INT64_BENCHMARKS(Op::kCmpGt);
+
+#undef DIMSUM_INT64_BENCHMARKS
+
+// Vector extensions have no high half of products.
+BENCHMARK_TEMPLATE(BM_Int64Scalar, Op::kMulHi, int64);
+BENCHMARK_TEMPLATE(BM_Int64NativeSimd, Op::kMulHi, int64);
+BENCHMARK_TEMPLATE(BM_Int64Scalar, Op::kMulHi, uint64);
+BENCHMARK_TEMPLATE(BM_Int64NativeSimd, Op::kMulHi, uint64);
+
+}  // namespace
+}  // namespace dimsum
@@ -0,0 +1,130 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <type_traits>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "benchmark_util.h"
+#include "dimsum.h"
+#include "simulated.h"
+
+namespace dimsum {
+namespace {
+
+using bench::kNumValues;
+
+enum class Op { kShl, kShr, kRotl };
+
+// Counts in [0, 8 * sizeof(T)), different in neighboring lanes.
+template <typename T>
+std::vector<T> MakeCounts() {
+  std::vector<T> counts(kNumValues);
+  for (size_t i = 0; i < counts.size(); i++) {
+    counts[i] = static_cast<T>((i * 7 + (i >> 5)) % (8 * sizeof(T)));
+  }
+  return counts;
+}
+
+template <Op kOp, typename T>
+T ApplyScalar(T value, T count) {
+  using Bits = typename std::make_unsigned<T>::type;
+  constexpr int kBits = 8 * sizeof(T);
+  switch (kOp) {
+    case Op::kShl:
+      return static_cast<T>(static_cast<Bits>(value) << count);
+    case Op::kShr:
+      return static_cast<T>(value >> count);
+    case Op::kRotl:
+      return static_cast<T>(
+          static_cast<Bits>(value) << count |
+          static_cast<Bits>(value) >> (-count & (kBits - 1)));
+  }
+}
+
+template <Op kOp, typename T, typename Abi>
+Simd<T, Abi> ApplySimd(Simd<T, Abi> simd, Simd<T, Abi> count) {
+  switch (kOp) {
+    case Op::kShl:
+      return shl_simd(simd, count);
+    case Op::kShr:
+      return shr_simd(simd, count);
+    case Op::kRotl:
+      return rotl_simd(simd, count);
+  }
+}
+
+// The per-lane loops of the simulated backend, which is what a shift by a
+// vector of counts compiles to when it is not lowered to vector instructions.
+template <Op kOp, typename T, typename Abi>
+Simd<T, Abi> ApplySimulated(Simd<T, Abi> simd, Simd<T, Abi> count) {
+  switch (kOp) {
+    case Op::kShl:
+      return simulated::shl_simd(simd, count);
+    case Op::kShr:
+      return simulated::shr_simd(simd, count);
+    case Op::kRotl:
+      return simulated::rotl_simd(simd, count);
+  }
+}
+
+template <Op kOp, typename T>
+void BM_ShiftScalar(benchmark::State& state) {
+  bench::ScalarLoop(state,
+                    [](T value, T count) {
+                      return ApplyScalar<kOp>(value, count);
+                    },
+                    bench::MakeValues<T>(), MakeCounts<T>());
+}
+
+template <Op kOp, typename T>
+void BM_ShiftSimulated(benchmark::State& state) {
+  bench::SimdLoop(state,
+                  [](NativeSimd<T> simd, NativeSimd<T> count) {
+                    return ApplySimulated<kOp>(simd, count);
+                  },
+                  bench::MakeValues<T>(), MakeCounts<T>());
+}
+
+template <Op kOp, typename T>
+void BM_ShiftNativeSimd(benchmark::State& state) {
+  bench::SimdLoop(state,
+                  [](NativeSimd<T> simd, NativeSimd<T> count) {
+                    return ApplySimd<kOp>(simd, count);
+                  },
+                  bench::MakeValues<T>(), MakeCounts<T>());
+}
+
+#define DIMSUM_SHIFT_BENCHMARKS(op)                    \
+  BENCHMARK_TEMPLATE(BM_ShiftScalar, op, int8);        \
+  BENCHMARK_TEMPLATE(BM_ShiftSimulated, op, int8);     \
+  BENCHMARK_TEMPLATE(BM_ShiftNativeSimd, op, int8);    \
+  BENCHMARK_TEMPLATE(BM_ShiftScalar, op, uint16);      \
+  BENCHMARK_TEMPLATE(BM_ShiftSimulated, op, uint16);   \
+  BENCHMARK_TEMPLATE(BM_ShiftNativeSimd, op, uint16);  \
+  BENCHMARK_TEMPLATE(BM_ShiftScalar, op, int32);       \
+  BENCHMARK_TEMPLATE(BM_ShiftSimulated, op, int32);    \
+  BENCHMARK_TEMPLATE(BM_ShiftNativeSimd, op, int32);   \
+  BENCHMARK_TEMPLATE(BM_ShiftScalar, op, int64);       \
+  BENCHMARK_TEMPLATE(BM_ShiftSimulated, op, int64);    \
+  BENCHMARK_TEMPLATE(BM_ShiftNativeSimd, op, int64)
+
+DIMSUM_SHIFT_BENCHMARKS(Op::kShl);
+DIMSUM_SHIFT_BENCHMARKS(Op::kShr);
+DIMSUM_SHIFT_BENCHMARKS(Op::kRotl);
+
+#undef DIMSUM_SHIFT_BENCHMARKS
+
+}  // namespace
+}  // namespace dimsum
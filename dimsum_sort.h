@@ -0,0 +1,425 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_DIMSUM_SORT_H_
+#define DIMSUM_DIMSUM_SORT_H_
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "dimsum.h"
+#include "dimsum_x86.h"
+
+// Sorting networks built on min, max and shuffle.
+//
+// sort(Simd) sorts the lanes of one Simd object with a bitonic network of
+// log2(N) * (log2(N) + 1) / 2 compare-exchange stages. small_sort sorts an
+// array by sorting NativeSimd-sized runs in registers and merging them with
+// the same networks.
+//
+// simd_partition and simd_sort handle large arrays. Partitioning compares a
+// whole vector against the pivot, moves the smaller lanes to the front with
+// compress, and stores the vector at both ends of the output; simd_sort is a
+// quicksort on top of it that hands sub-arrays to small_sort and to other
+// threads.
+//
+// As with min and max, elements must not contain NaN.
+
+namespace dimsum {
+namespace detail {
+
+// In the stage of a bitonic network that compare-exchanges lanes i and
+// i ^ kStride, within blocks of kBlock lanes that alternate between ascending
+// and descending order, returns whether lane i receives the smaller element.
+constexpr bool BitonicTakesMin(size_t i, size_t block, size_t stride) {
+  return ((i & block) == 0) == ((i & stride) == 0);
+}
+
+template <size_t kBlock, size_t kStride, typename T, typename Abi,
+          size_t... indices>
+Simd<T, Abi> BitonicStage(Simd<T, Abi> simd,
+                          dimsum::index_sequence<indices...>) {
+  auto partner = shuffle<(indices ^ kStride)...>(simd);
+  return blend<BitonicTakesMin(indices, kBlock, kStride)...>(
+      min(simd, partner), max(simd, partner));
+}
+
+// Like BitonicStage, but moves the lanes of `values` along with `keys`. On
+// ties both lanes keep their own element, so the pairing is never broken.
+template <size_t kBlock, size_t kStride, typename K, typename V, typename Abi,
+          size_t... indices>
+void BitonicStage(Simd<K, Abi>* keys, Simd<V, Abi>* values,
+                  dimsum::index_sequence<indices...>) {
+  auto partner_keys = shuffle<(indices ^ kStride)...>(*keys);
+  auto partner_values = shuffle<(indices ^ kStride)...>(*values);
+  auto keep = blend<BitonicTakesMin(indices, kBlock, kStride)...>(
+      cmp_le(*keys, partner_keys), cmp_ge(*keys, partner_keys));
+  *keys = select(keep, *keys, partner_keys);
+  using ValueBits = typename Simd<V, Abi>::ComparisonResultType;
+  *values = select(bit_cast<ValueBits>(keep), *values, partner_values);
+}
+
+// Runs the stages with strides kStride, kStride / 2, ..., 1.
+template <size_t kBlock, size_t kStride>
+struct BitonicMerge {
+  template <typename SimdType>
+  static SimdType Apply(SimdType simd) {
+    simd = BitonicStage<kBlock, kStride>(
+        simd, dimsum::make_index_sequence<SimdType::size()>{});
+    return BitonicMerge<kBlock, kStride / 2>::Apply(simd);
+  }
+
+  template <typename KeySimd, typename ValueSimd>
+  static void Apply(KeySimd* keys, ValueSimd* values) {
+    BitonicStage<kBlock, kStride>(
+        keys, values, dimsum::make_index_sequence<KeySimd::size()>{});
+    BitonicMerge<kBlock, kStride / 2>::Apply(keys, values);
+  }
+};
+
+template <size_t kBlock>
+struct BitonicMerge<kBlock, 0> {
+  template <typename SimdType>
+  static SimdType Apply(SimdType simd) {
+    return simd;
+  }
+
+  template <typename KeySimd, typename ValueSimd>
+  static void Apply(KeySimd*, ValueSimd*) {}
+};
+
+// Merges blocks of size kBlock, 2 * kBlock, ..., kSize.
+template <size_t kBlock, size_t kSize, bool kDone = (kBlock > kSize)>
+struct BitonicSort {
+  template <typename SimdType>
+  static SimdType Apply(SimdType simd) {
+    simd = BitonicMerge<kBlock, kBlock / 2>::Apply(simd);
+    return BitonicSort<kBlock * 2, kSize>::Apply(simd);
+  }
+
+  template <typename KeySimd, typename ValueSimd>
+  static void Apply(KeySimd* keys, ValueSimd* values) {
+    BitonicMerge<kBlock, kBlock / 2>::Apply(keys, values);
+    BitonicSort<kBlock * 2, kSize>::Apply(keys, values);
+  }
+};
+
+template <size_t kBlock, size_t kSize>
+struct BitonicSort<kBlock, kSize, true> {
+  template <typename SimdType>
+  static SimdType Apply(SimdType simd) {
+    return simd;
+  }
+
+  template <typename KeySimd, typename ValueSimd>
+  static void Apply(KeySimd*, ValueSimd*) {}
+};
+
+template <typename T, typename Abi, size_t... indices>
+Simd<T, Abi> Reverse(Simd<T, Abi> simd, dimsum::index_sequence<indices...>) {
+  return shuffle<(sizeof...(indices) - 1 - indices)...>(simd);
+}
+
+// Given sorted *lo and *hi, sorts their concatenation: afterwards *lo holds
+// the smaller half and *hi the larger half, both in ascending order.
+template <typename T, typename Abi>
+void MergeSorted(Simd<T, Abi>* lo, Simd<T, Abi>* hi) {
+  constexpr size_t size = Simd<T, Abi>::size();
+  auto reversed = Reverse(*hi, dimsum::make_index_sequence<size>{});
+  // Both halves of the bitonic sequence (*lo, reversed) are now bitonic.
+  *hi = BitonicMerge<size, size / 2>::Apply(max(*lo, reversed));
+  *lo = BitonicMerge<size, size / 2>::Apply(min(*lo, reversed));
+}
+
+// Returns a value that is not less than any other value of T.
+template <typename T>
+constexpr T SortSentinel() {
+  return std::numeric_limits<T>::has_infinity
+             ? std::numeric_limits<T>::infinity()
+             : std::numeric_limits<T>::max();
+}
+
+// Merges the sorted runs [lhs, lhs + lhs_size) and [rhs, rhs + rhs_size) into
+// out. Sizes must be multiples of SimdType::size().
+template <typename SimdType, typename T>
+void MergeRuns(const T* lhs, size_t lhs_size, const T* rhs, size_t rhs_size,
+               T* out) {
+  constexpr size_t size = SimdType::size();
+  if (lhs_size == 0 || rhs_size == 0) {
+    std::copy(lhs, lhs + lhs_size, out);
+    std::copy(rhs, rhs + rhs_size, out);
+    return;
+  }
+  const T* lhs_end = lhs + lhs_size;
+  const T* rhs_end = rhs + rhs_size;
+  SimdType lo(lhs, flags::element_aligned);
+  SimdType hi(rhs, flags::element_aligned);
+  lhs += size;
+  rhs += size;
+  for (;;) {
+    MergeSorted(&lo, &hi);
+    lo.memstore(out, flags::element_aligned);
+    out += size;
+    // The next smallest elements are either in hi or in the run whose next
+    // vector starts with the smaller element.
+    if (lhs != lhs_end && (rhs == rhs_end || *lhs <= *rhs)) {
+      lo.memload(lhs, flags::element_aligned);
+      lhs += size;
+    } else if (rhs != rhs_end) {
+      lo.memload(rhs, flags::element_aligned);
+      rhs += size;
+    } else {
+      break;
+    }
+  }
+  hi.memstore(out, flags::element_aligned);
+}
+
+}  // namespace detail
+
+// Returns the lanes of `simd` in ascending order.
+template <typename T, typename Abi>
+Simd<T, Abi> sort(Simd<T, Abi> simd) {
+  constexpr size_t size = Simd<T, Abi>::size();
+  static_assert((size & (size - 1)) == 0, "Size must be a power of two");
+  return detail::BitonicSort<2, size>::Apply(simd);
+}
+
+// Sorts `keys` in ascending order and applies the same permutation to
+// `values`. The relative order of values with equal keys is unspecified.
+template <typename K, typename V, typename Abi>
+void sort(Simd<K, Abi>* keys, Simd<V, Abi>* values) {
+  constexpr size_t size = Simd<K, Abi>::size();
+  static_assert(sizeof(K) == sizeof(V), "Keys and values must be same-sized");
+  static_assert((size & (size - 1)) == 0, "Size must be a power of two");
+  detail::BitonicSort<2, size>::Apply(keys, values);
+}
+
+// The largest input small_sort handles with sorting networks.
+constexpr size_t kMaxSmallSortSize = 512;
+
+// Sorts data[0 .. size-1] in ascending order. It is meant for up to a few
+// hundred elements, where std::sort is dominated by per-call overhead; inputs
+// larger than kMaxSmallSortSize are passed to std::sort.
+template <typename T>
+void small_sort(T* data, size_t size) {
+  using SimdType = NativeSimd<T>;
+  constexpr size_t kRun = SimdType::size();
+  if (size > kMaxSmallSortSize) {
+    std::sort(data, data + size);
+    return;
+  }
+  if (size <= 1) return;
+
+  // Pads to whole vectors with elements that sort last. Up to two vectors are
+  // sorted without the merge passes below.
+  if (size <= 2 * kRun) {
+    T buffer[2 * kRun];
+    std::copy(data, data + size, buffer);
+    std::fill(buffer + size, buffer + 2 * kRun, detail::SortSentinel<T>());
+    SimdType lo = sort(SimdType(buffer, flags::element_aligned));
+    if (size > kRun) {
+      SimdType hi = sort(SimdType(buffer + kRun, flags::element_aligned));
+      detail::MergeSorted(&lo, &hi);
+      hi.memstore(buffer + kRun, flags::element_aligned);
+    }
+    lo.memstore(buffer, flags::element_aligned);
+    std::copy(buffer, buffer + size, data);
+    return;
+  }
+
+  alignas(sizeof(SimdType)) T buffer[2][kMaxSmallSortSize + kRun];
+  const size_t padded_size = (size + kRun - 1) / kRun * kRun;
+  std::copy(data, data + size, buffer[0]);
+  std::fill(buffer[0] + size, buffer[0] + padded_size,
+            detail::SortSentinel<T>());
+
+  for (size_t i = 0; i < padded_size; i += kRun) {
+    sort(SimdType(buffer[0] + i, flags::vector_aligned))
+        .memstore(buffer[0] + i, flags::vector_aligned);
+  }
+
+  int from = 0;
+  for (size_t run = kRun; run < padded_size; run *= 2) {
+    for (size_t i = 0; i < padded_size; i += 2 * run) {
+      size_t lhs_size = std::min(run, padded_size - i);
+      size_t rhs_size = std::min(run, padded_size - i - lhs_size);
+      detail::MergeRuns<SimdType>(buffer[from] + i, lhs_size,
+                                  buffer[from] + i + lhs_size, rhs_size,
+                                  buffer[1 - from] + i);
+    }
+    from = 1 - from;
+  }
+  std::copy(buffer[from], buffer[from] + size, data);
+}
+
+namespace detail {
+
+// Partitions `simd` into the output gap [*lhs, *rhs): elements selected by
+// the predicate go to *lhs, and the others go to the end, just before *rhs.
+// Needs at least size() free elements at both ends of the gap.
+template <bool kInclusive, typename T, typename Abi>
+void PartitionStore(Simd<T, Abi> simd, Simd<T, Abi> pivot, T** lhs, T** rhs) {
+  constexpr size_t size = Simd<T, Abi>::size();
+  auto mask = kInclusive ? cmp_le(simd, pivot) : cmp_lt(simd, pivot);
+  size_t count = __builtin_popcount(x86::movemask(mask));
+  auto partitioned = compress(simd, mask);
+  partitioned.memstore(*lhs, flags::element_aligned);
+  partitioned.memstore(*rhs - size, flags::element_aligned);
+  *lhs += count;
+  *rhs -= size - count;
+}
+
+// Partitions data[0 .. size-1] by `element < pivot`, or by
+// `element <= pivot` if kInclusive, and returns the number of elements that
+// satisfy it. The order within each part is unspecified.
+template <bool kInclusive, typename T>
+size_t Partition(T* data, size_t size, T pivot) {
+  using SimdType = NativeSimd<T>;
+  constexpr size_t kSize = SimdType::size();
+  auto selected = [pivot](T element) {
+    return kInclusive ? element <= pivot : element < pivot;
+  };
+  if (size < 4 * kSize) {
+    return std::partition(data, data + size, selected) - data;
+  }
+
+  // The first and last vectors are kept in registers, which leaves kSize free
+  // elements at each end. Reading from the end with less free space keeps at
+  // least kSize free at both ends for every PartitionStore.
+  const SimdType pivot_simd(pivot);
+  const SimdType first(data, flags::element_aligned);
+  const SimdType last(data + size - kSize, flags::element_aligned);
+  T* lhs_write = data;
+  T* rhs_write = data + size;
+  const T* lhs_read = data + kSize;
+  const T* rhs_read = data + size - kSize;
+  while (static_cast<size_t>(rhs_read - lhs_read) >= kSize) {
+    SimdType simd;
+    if (lhs_read - lhs_write <= rhs_write - rhs_read) {
+      simd.memload(lhs_read, flags::element_aligned);
+      lhs_read += kSize;
+    } else {
+      rhs_read -= kSize;
+      simd.memload(rhs_read, flags::element_aligned);
+    }
+    PartitionStore<kInclusive>(simd, pivot_simd, &lhs_write, &rhs_write);
+  }
+
+  // Fewer than kSize unread elements remain; move them out of the way so that
+  // the gap is contiguous, then partition `first` into it. `last` and the rest
+  // exactly fill what's left of the gap.
+  T rest[2 * kSize];
+  const size_t num_rest = rhs_read - lhs_read;
+  std::copy(lhs_read, rhs_read, rest);
+  PartitionStore<kInclusive>(first, pivot_simd, &lhs_write, &rhs_write);
+  last.memstore(rest + num_rest, flags::element_aligned);
+  for (size_t i = 0; i < num_rest + kSize; i++) {
+    if (selected(rest[i])) {
+      *lhs_write++ = rest[i];
+    } else {
+      *--rhs_write = rest[i];
+    }
+  }
+  return lhs_write - data;
+}
+
+template <typename T>
+T Median3(T a, T b, T c) {
+  return std::max(std::min(a, b), std::min(std::max(a, b), c));
+}
+
+template <typename T>
+T ChoosePivot(const T* data, size_t size) {
+  const size_t step = size / 8;
+  return Median3(Median3(data[0], data[step], data[2 * step]),
+                 Median3(data[3 * step], data[4 * step], data[5 * step]),
+                 Median3(data[6 * step], data[7 * step], data[size - 1]));
+}
+
+// Sub-arrays smaller than this are not worth a thread.
+constexpr size_t kMinParallelSortSize = 1 << 16;
+
+template <typename T>
+void QuickSort(T* data, size_t size, int depth_limit, size_t num_threads) {
+  std::vector<std::thread> helpers;
+  while (size > kMaxSmallSortSize) {
+    if (depth_limit-- == 0) {
+      // Too many bad pivots; bound the worst case like introsort.
+      std::sort(data, data + size);
+      size = 0;
+      break;
+    }
+    T pivot = ChoosePivot(data, size);
+    size_t split = Partition<false>(data, size, pivot);
+    if (split == 0) {
+      // The pivot is the minimum. Split off the elements equal to it, which
+      // are already in place.
+      split = Partition<true>(data, size, pivot);
+      data += split;
+      size -= split;
+      continue;
+    }
+    T* lhs = data;
+    size_t lhs_size = split;
+    T* rhs = data + split;
+    size_t rhs_size = size - split;
+    if (lhs_size > rhs_size) {
+      std::swap(lhs, rhs);
+      std::swap(lhs_size, rhs_size);
+    }
+    if (num_threads > 1 && lhs_size >= kMinParallelSortSize) {
+      // The smaller side goes to a new thread with its share of the budget,
+      // and this thread keeps splitting the larger side with the rest.
+      size_t helper_threads = std::max<size_t>(
+          num_threads * lhs_size / (lhs_size + rhs_size), 1);
+      helpers.emplace_back(QuickSort<T>, lhs, lhs_size, depth_limit,
+                           helper_threads);
+      num_threads -= helper_threads;
+    } else {
+      QuickSort(lhs, lhs_size, depth_limit, 1);
+    }
+    data = rhs;
+    size = rhs_size;
+  }
+  small_sort(data, size);
+  for (std::thread& helper : helpers) helper.join();
+}
+
+}  // namespace detail
+
+// Reorders data[0 .. size-1] so that the elements less than `pivot` come
+// first, and returns their number. The order within each part is unspecified.
+template <typename T>
+size_t simd_partition(T* data, size_t size, T pivot) {
+  return detail::Partition<false>(data, size, pivot);
+}
+
+// Sorts data[0 .. size-1] in ascending order. The sort is not stable. Large
+// inputs are sorted by up to `num_threads` threads, including the calling one.
+template <typename T>
+void simd_sort(T* data, size_t size,
+               size_t num_threads = std::thread::hardware_concurrency()) {
+  int depth_limit = 0;
+  for (size_t n = size; n > 1; n /= 2) depth_limit += 2;
+  detail::QuickSort(data, size, depth_limit, std::max<size_t>(num_threads, 1));
+}
+
+}  // namespace dimsum
+
+#endif  // DIMSUM_DIMSUM_SORT_H_
@@ -0,0 +1,185 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "dimsum_sort.h"
+
+namespace dimsum {
+namespace {
+
+// Every iteration sorts kNumArrays arrays of state.range(0) elements, so that
+// the inputs don't stay sorted after the first iteration.
+constexpr size_t kNumArrays = 256;
+
+template <typename T>
+std::vector<T> MakeInput(size_t size) {
+  std::mt19937_64 rng(42);
+  std::vector<T> input(size * kNumArrays);
+  for (T& element : input) element = static_cast<T>(rng());
+  return input;
+}
+
+template <typename T>
+void BM_StdSort(benchmark::State& state) {
+  const size_t size = state.range(0);
+  const std::vector<T> input = MakeInput<T>(size);
+  std::vector<T> data(input.size());
+  for (auto _ : state) {
+    state.PauseTiming();
+    data = input;
+    state.ResumeTiming();
+    for (size_t i = 0; i < data.size(); i += size) {
+      std::sort(&data[i], &data[i] + size);
+    }
+    benchmark::DoNotOptimize(data.data());
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+template <typename T>
+void BM_SmallSort(benchmark::State& state) {
+  const size_t size = state.range(0);
+  const std::vector<T> input = MakeInput<T>(size);
+  std::vector<T> data(input.size());
+  for (auto _ : state) {
+    state.PauseTiming();
+    data = input;
+    state.ResumeTiming();
+    for (size_t i = 0; i < data.size(); i += size) {
+      small_sort(&data[i], size);
+    }
+    benchmark::DoNotOptimize(data.data());
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+void SortSizes(benchmark::internal::Benchmark* b) {
+  for (int size : {8, 16, 32, 64, 128, 256, 512}) b->Arg(size);
+}
+
+BENCHMARK_TEMPLATE(BM_StdSort, int32)->Apply(SortSizes);
+BENCHMARK_TEMPLATE(BM_SmallSort, int32)->Apply(SortSizes);
+BENCHMARK_TEMPLATE(BM_StdSort, uint64)->Apply(SortSizes);
+BENCHMARK_TEMPLATE(BM_SmallSort, uint64)->Apply(SortSizes);
+BENCHMARK_TEMPLATE(BM_StdSort, float)->Apply(SortSizes);
+BENCHMARK_TEMPLATE(BM_SmallSort, float)->Apply(SortSizes);
+BENCHMARK_TEMPLATE(BM_StdSort, int16)->Apply(SortSizes);
+BENCHMARK_TEMPLATE(BM_SmallSort, int16)->Apply(SortSizes);
+
+// Sorts one NativeSimd at a time, which is the top-k candidate case.
+template <typename T>
+void BM_SortSimd(benchmark::State& state) {
+  using SimdType = NativeSimd<T>;
+  const std::vector<T> input = MakeInput<T>(SimdType::size());
+  std::vector<T> out(input.size());
+  for (auto _ : state) {
+    for (size_t i = 0; i < input.size(); i += SimdType::size()) {
+      sort(SimdType(&input[i], flags::element_aligned))
+          .memstore(&out[i], flags::element_aligned);
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+BENCHMARK_TEMPLATE(BM_SortSimd, int16);
+BENCHMARK_TEMPLATE(BM_SortSimd, int32);
+BENCHMARK_TEMPLATE(BM_SortSimd, uint64);
+BENCHMARK_TEMPLATE(BM_SortSimd, float);
+
+// Large arrays, where simd_sort competes with std::sort and std::stable_sort.
+template <typename T>
+std::vector<T> MakeLargeInput(size_t size) {
+  std::mt19937_64 rng(42);
+  std::vector<T> input(size);
+  for (T& element : input) element = static_cast<T>(rng());
+  return input;
+}
+
+enum class Sorter { kStdSort, kStdStableSort, kSimdSort, kSimdSortThreads };
+
+template <typename T, Sorter kSorter>
+void BM_LargeSort(benchmark::State& state) {
+  const std::vector<T> input = MakeLargeInput<T>(state.range(0));
+  std::vector<T> data;
+  for (auto _ : state) {
+    state.PauseTiming();
+    data = input;
+    state.ResumeTiming();
+    switch (kSorter) {
+      case Sorter::kStdSort:
+        std::sort(data.begin(), data.end());
+        break;
+      case Sorter::kStdStableSort:
+        std::stable_sort(data.begin(), data.end());
+        break;
+      case Sorter::kSimdSort:
+        simd_sort(data.data(), data.size(), 1);
+        break;
+      case Sorter::kSimdSortThreads:
+        simd_sort(data.data(), data.size());
+        break;
+    }
+    benchmark::DoNotOptimize(data.data());
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+#define LARGE_SORT_BENCHMARKS(T)                                         \
+  BENCHMARK_TEMPLATE(BM_LargeSort, T, Sorter::kStdSort)                  \
+      ->Arg(1 << 20)                                                     \
+      ->Arg(10 << 20)                                                    \
+      ->Unit(benchmark::kMillisecond);                                   \
+  BENCHMARK_TEMPLATE(BM_LargeSort, T, Sorter::kStdStableSort)            \
+      ->Arg(1 << 20)                                                     \
+      ->Arg(10 << 20)                                                    \
+      ->Unit(benchmark::kMillisecond);                                   \
+  BENCHMARK_TEMPLATE(BM_LargeSort, T, Sorter::kSimdSort)                 \
+      ->Arg(1 << 20)                                                     \
+      ->Arg(10 << 20)                                                    \
+      ->Unit(benchmark::kMillisecond);                                   \
+  BENCHMARK_TEMPLATE(BM_LargeSort, T, Sorter::kSimdSortThreads)          \
+      ->Arg(1 << 20)                                                     \
+      ->Arg(10 << 20)                                                    \
+      ->Unit(benchmark::kMillisecond)                                    \
+      ->UseRealTime()
+
+LARGE_SORT_BENCHMARKS(uint32);
+LARGE_SORT_BENCHMARKS(uint64);
+LARGE_SORT_BENCHMARKS(float);
+
+#undef LARGE_SORT_BENCHMARKS
+
+template <typename T>
+void BM_SimdPartition(benchmark::State& state) {
+  const std::vector<T> input = MakeLargeInput<T>(state.range(0));
+  const T pivot = input[input.size() / 2];
+  std::vector<T> data;
+  for (auto _ : state) {
+    state.PauseTiming();
+    data = input;
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(simd_partition(data.data(), data.size(), pivot));
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+BENCHMARK_TEMPLATE(BM_SimdPartition, uint32)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_SimdPartition, uint64)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_SimdPartition, float)->Arg(1 << 20);
+
+}  // namespace
+}  // namespace dimsum
@@ -0,0 +1,234 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dimsum_sort.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+template <typename T>
+T RandomElement(std::mt19937_64* rng) {
+  // A small range makes duplicates likely.
+  return static_cast<T>(static_cast<int64>((*rng)() % 64) - 16);
+}
+
+template <typename SimdType>
+void TestSortSimd() {
+  using T = typename SimdType::value_type;
+  std::mt19937_64 rng(42);
+  for (int iter = 0; iter < 100; iter++) {
+    T buffer[SimdType::size()];
+    for (auto& element : buffer) element = RandomElement<T>(&rng);
+    auto sorted = sort(SimdType(buffer, flags::element_aligned));
+    std::sort(buffer, buffer + SimdType::size());
+    for (int i = 0; i < SimdType::size(); i++) {
+      EXPECT_EQ(buffer[i], sorted[i]) << i;
+    }
+  }
+}
+
+TEST(DimsumSortTest, SortSimd) {
+  TestSortSimd<NativeSimd<int8>>();
+  TestSortSimd<NativeSimd<uint8>>();
+  TestSortSimd<NativeSimd<int16>>();
+  TestSortSimd<NativeSimd<uint16>>();
+  TestSortSimd<NativeSimd<int32>>();
+  TestSortSimd<NativeSimd<uint32>>();
+  TestSortSimd<NativeSimd<int64>>();
+  TestSortSimd<NativeSimd<uint64>>();
+  TestSortSimd<NativeSimd<float>>();
+  TestSortSimd<NativeSimd<double>>();
+  TestSortSimd<Simd64<int32>>();
+  TestSortSimd<ResizeTo<NativeSimd<int32>, 16>>();
+}
+
+template <typename K, typename V>
+void TestSortKeyValue() {
+  using KeySimd = NativeSimd<K>;
+  using ValueSimd = NativeSimd<V>;
+  constexpr size_t kSize = KeySimd::size();
+  std::mt19937_64 rng(42);
+  for (int iter = 0; iter < 100; iter++) {
+    K keys[kSize];
+    for (auto& key : keys) key = RandomElement<K>(&rng);
+    KeySimd key_simd(keys, flags::element_aligned);
+    // Each value remembers the lane its key came from.
+    ValueSimd value_simd([](int i) { return static_cast<V>(i); });
+    sort(&key_simd, &value_simd);
+
+    std::sort(keys, keys + kSize);
+    bool seen[kSize] = {};
+    for (int i = 0; i < kSize; i++) {
+      EXPECT_EQ(keys[i], key_simd[i]) << i;
+      size_t origin = static_cast<size_t>(value_simd[i]);
+      ASSERT_LT(origin, kSize);
+      EXPECT_FALSE(seen[origin]);
+      seen[origin] = true;
+    }
+  }
+}
+
+TEST(DimsumSortTest, SortKeyValue) {
+  TestSortKeyValue<int32, uint32>();
+  TestSortKeyValue<float, int32>();
+  TestSortKeyValue<uint64, double>();
+  TestSortKeyValue<int16, uint16>();
+}
+
+// Checks that sorted values are paired with the original keys, i.e. that
+// values travel with their keys rather than being permuted independently.
+TEST(DimsumSortTest, SortKeyValuePairing) {
+  using KeySimd = NativeSimd<int32>;
+  KeySimd keys([](int i) { return (i * 7) % KeySimd::size(); });
+  KeySimd values = keys * KeySimd(10);
+  sort(&keys, &values);
+  for (int i = 0; i < KeySimd::size(); i++) {
+    EXPECT_EQ(i, keys[i]);
+    EXPECT_EQ(i * 10, values[i]);
+  }
+}
+
+template <typename T>
+void TestSmallSort() {
+  std::mt19937_64 rng(42);
+  for (size_t size : {0, 1, 2, 3, 7, 8, 15, 16, 17, 31, 32, 33, 63, 64, 100,
+                      255, 256, 300, 511, 512, 513, 1000}) {
+    std::vector<T> data(size);
+    for (T& element : data) element = RandomElement<T>(&rng);
+    std::vector<T> expected = data;
+    std::sort(expected.begin(), expected.end());
+    small_sort(data.data(), data.size());
+    EXPECT_EQ(expected, data) << size;
+  }
+}
+
+TEST(DimsumSortTest, SmallSort) {
+  TestSmallSort<int8>();
+  TestSmallSort<uint16>();
+  TestSmallSort<int32>();
+  TestSmallSort<uint32>();
+  TestSmallSort<int64>();
+  TestSmallSort<float>();
+  TestSmallSort<double>();
+}
+
+TEST(DimsumSortTest, SmallSortExtremes) {
+  std::vector<uint32> data = {0xffffffffu, 0, 0xffffffffu, 5, 0xfffffffeu};
+  small_sort(data.data(), data.size());
+  EXPECT_EQ((std::vector<uint32>{0, 5, 0xfffffffeu, 0xffffffffu, 0xffffffffu}),
+            data);
+
+  std::vector<float> floats = {std::numeric_limits<float>::infinity(), -1.f,
+                               -std::numeric_limits<float>::infinity(), 2.f};
+  small_sort(floats.data(), floats.size());
+  EXPECT_EQ((std::vector<float>{-std::numeric_limits<float>::infinity(), -1.f,
+                                2.f, std::numeric_limits<float>::infinity()}),
+            floats);
+}
+
+template <typename T>
+void TestSimdPartition() {
+  std::mt19937_64 rng(42);
+  for (size_t size : {0, 1, 5, 31, 32, 33, 64, 100, 1000, 4097}) {
+    for (int range : {2, 64, 1 << 20}) {
+      std::vector<T> data(size);
+      for (T& element : data) element = static_cast<T>(rng() % range);
+      std::vector<T> sorted = data;
+      std::sort(sorted.begin(), sorted.end());
+      for (T pivot : {T(0), T(1), static_cast<T>(range / 2), T(range)}) {
+        std::vector<T> partitioned = data;
+        size_t split =
+            simd_partition(partitioned.data(), partitioned.size(), pivot);
+        ASSERT_EQ(std::lower_bound(sorted.begin(), sorted.end(), pivot) -
+                      sorted.begin(),
+                  split);
+        for (size_t i = 0; i < size; i++) {
+          ASSERT_EQ(i < split, partitioned[i] < pivot) << i;
+        }
+        std::sort(partitioned.begin(), partitioned.end());
+        ASSERT_EQ(sorted, partitioned);
+      }
+    }
+  }
+}
+
+TEST(DimsumSortTest, SimdPartition) {
+  TestSimdPartition<uint32>();
+  TestSimdPartition<int32>();
+  TestSimdPartition<uint64>();
+  TestSimdPartition<float>();
+  TestSimdPartition<double>();
+  TestSimdPartition<int16>();
+}
+
+template <typename T>
+void TestSimdSort(size_t num_threads) {
+  std::mt19937_64 rng(42);
+  for (size_t size : {0, 1, 100, 513, 5000, 300000}) {
+    for (int pattern = 0; pattern < 5; pattern++) {
+      std::vector<T> data(size);
+      for (size_t i = 0; i < size; i++) {
+        switch (pattern) {
+          case 0:  // Random.
+            data[i] = static_cast<T>(rng());
+            break;
+          case 1:  // Few distinct values.
+            data[i] = static_cast<T>(rng() % 4);
+            break;
+          case 2:  // Sorted.
+            data[i] = static_cast<T>(i);
+            break;
+          case 3:  // Reversed.
+            data[i] = static_cast<T>(size - i);
+            break;
+          case 4:  // All equal.
+            data[i] = T(7);
+            break;
+        }
+      }
+      std::vector<T> expected = data;
+      std::sort(expected.begin(), expected.end());
+      simd_sort(data.data(), data.size(), num_threads);
+      ASSERT_EQ(expected, data) << size << " " << pattern;
+    }
+  }
+}
+
+TEST(DimsumSortTest, SimdSort) {
+  TestSimdSort<uint32>(1);
+  TestSimdSort<int32>(1);
+  TestSimdSort<uint64>(1);
+  TestSimdSort<float>(1);
+  TestSimdSort<double>(1);
+}
+
+TEST(DimsumSortTest, SimdSortThreads) {
+  TestSimdSort<uint32>(4);
+  TestSimdSort<int64>(3);
+}
+
+// More threads than there are partitions worth a thread.
+TEST(DimsumSortTest, SimdSortManyThreads) {
+  TestSimdSort<uint32>(64);
+  TestSimdSort<double>(1000);
+}
+
+}  // namespace
+}  // namespace dimsum
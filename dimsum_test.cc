@@ -14,9 +14,12 @@
 
 #include "dimsum.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <limits>
 #include <type_traits>
+#include <vector>
 
 #include "simulated.h"
 #include "gtest/gtest.h"
@@ -271,6 +274,33 @@ TEST(DimsumTest, Store) {
   }
 }
 
+template <typename SimdType>
+void TestStreaming() {
+  using T = typename SimdType::value_type;
+  alignas(sizeof(SimdType)) T in[SimdType::size()];
+  alignas(sizeof(SimdType)) T out[SimdType::size()] = {};
+  for (size_t i = 0; i < SimdType::size(); i++) {
+    in[i] = static_cast<T>(i + 1);
+  }
+  prefetch(in);
+  prefetch<0>(in);
+  SimdType(in, flags::streaming_load).memstore(out, flags::streaming);
+  streaming_fence();
+  for (size_t i = 0; i < SimdType::size(); i++) {
+    EXPECT_EQ(in[i], out[i]) << i;
+  }
+}
+
+TEST(DimsumTest, Streaming) {
+  TestStreaming<Simd64<float>>();
+  TestStreaming<Simd128<int8>>();
+  TestStreaming<Simd128<double>>();
+  TestStreaming<NativeSimd<uint16>>();
+  TestStreaming<NativeSimd<float>>();
+  TestStreaming<ResizeBy<NativeSimd<int32>, 2>>();
+  TestStreaming<ResizeBy<Simd128<int64>, 4>>();
+}
+
 TEST(DimsumTest, Negate) {
   SIMD_UNARY_FREE_FUNC_TEST(int32, negate, boring_unary_op_test);
   SIMD_UNARY_FREE_FUNC_TEST(float, negate, boring_unary_op_test_float);
@@ -454,12 +484,182 @@ TEST(DimsumTest, Sub_saturated) {
   EXPECT_EQ(u16_valid, sub_saturated(u16_lhs, u16_rhs));
 }
 
+// Compares avg_round and mul_hi with their simulated versions on lanes
+// spread over the whole range of T.
+template <typename SimdType>
+void TestAvgRoundAndMulHi() {
+  using T = typename SimdType::value_type;
+  for (size_t seed = 0; seed < 256; seed++) {
+    SimdType lhs, rhs;
+    for (size_t i = 0; i < SimdType::size(); i++) {
+      lhs.set(i, static_cast<T>((seed * 64 + i) * 2654435761u));
+      rhs.set(i, static_cast<T>((seed * 64 + i) * 40503u + 12345));
+    }
+    EXPECT_EQ(simulated::avg_round(lhs, rhs), avg_round(lhs, rhs));
+    EXPECT_EQ(simulated::mul_hi(lhs, rhs), mul_hi(lhs, rhs));
+  }
+}
+
+TEST(DimsumTest, AvgRound) {
+  auto u8_lhs = Simd128<uint8>::list(0, 0, 1, 1, 2, 3, 100, 101, 254, 255, 255,
+                                     255, 0, 128, 127, 200);
+  auto u8_rhs = Simd128<uint8>::list(0, 1, 1, 2, 5, 4, 100, 100, 255, 254, 255,
+                                     0, 255, 127, 128, 201);
+  auto u8_valid = Simd128<uint8>::list(0, 1, 1, 2, 4, 4, 100, 101, 255, 255,
+                                       255, 128, 128, 128, 128, 201);
+  EXPECT_EQ(u8_valid, simulated::avg_round(u8_lhs, u8_rhs));
+  EXPECT_EQ(u8_valid, avg_round(u8_lhs, u8_rhs));
+
+  auto s16_lhs =
+      Simd128<int16>::list(-32768, -32768, 32767, -1, -2, -3, 0, 32767);
+  auto s16_rhs = Simd128<int16>::list(-32768, 32767, 32767, 0, -1, 0, 1, 0);
+  auto s16_valid =
+      Simd128<int16>::list(-32768, 0, 32767, 0, -1, -1, 1, 16384);
+  EXPECT_EQ(s16_valid, simulated::avg_round(s16_lhs, s16_rhs));
+  EXPECT_EQ(s16_valid, avg_round(s16_lhs, s16_rhs));
+
+  auto u32_lhs = Simd128<uint32>::list(0xffffffff, 0xffffffff, 0, 7);
+  auto u32_rhs = Simd128<uint32>::list(0xffffffff, 0, 1, 8);
+  auto u32_valid = Simd128<uint32>::list(0xffffffff, 0x80000000, 1, 8);
+  EXPECT_EQ(u32_valid, simulated::avg_round(u32_lhs, u32_rhs));
+  EXPECT_EQ(u32_valid, avg_round(u32_lhs, u32_rhs));
+}
+
+TEST(DimsumTest, MulHi) {
+  auto s16_lhs =
+      Simd128<int16>::list(-32768, -32768, 32767, 16384, -1, 1, 300, -300);
+  auto s16_rhs =
+      Simd128<int16>::list(-32768, 32767, 32767, 4, -1, -1, 300, 300);
+  auto s16_valid = Simd128<int16>::list(16384, -16384, 16383, 1, 0, -1, 1, -2);
+  EXPECT_EQ(s16_valid, simulated::mul_hi(s16_lhs, s16_rhs));
+  EXPECT_EQ(s16_valid, mul_hi(s16_lhs, s16_rhs));
+
+  auto u16_lhs =
+      Simd128<uint16>::list(65535, 65535, 32768, 256, 255, 1, 0, 40000);
+  auto u16_rhs = Simd128<uint16>::list(65535, 1, 2, 256, 257, 65535, 9, 40000);
+  auto u16_valid =
+      Simd128<uint16>::list(65534, 0, 1, 1, 0, 0, 0, 24414);
+  EXPECT_EQ(u16_valid, simulated::mul_hi(u16_lhs, u16_rhs));
+  EXPECT_EQ(u16_valid, mul_hi(u16_lhs, u16_rhs));
+
+  constexpr int64 kMin64 = std::numeric_limits<int64>::min();
+  constexpr int64 kMax64 = std::numeric_limits<int64>::max();
+  auto s64_lhs = Simd128<int64>::list(kMin64, kMin64);
+  auto s64_rhs = Simd128<int64>::list(kMin64, kMax64);
+  auto s64_valid = Simd128<int64>::list(1ll << 62, -(1ll << 62));
+  EXPECT_EQ(s64_valid, simulated::mul_hi(s64_lhs, s64_rhs));
+  EXPECT_EQ(s64_valid, mul_hi(s64_lhs, s64_rhs));
+  s64_lhs = Simd128<int64>::list(-1, -1);
+  s64_rhs = Simd128<int64>::list(-1, 1);
+  s64_valid = Simd128<int64>::list(0, -1);
+  EXPECT_EQ(s64_valid, simulated::mul_hi(s64_lhs, s64_rhs));
+  EXPECT_EQ(s64_valid, mul_hi(s64_lhs, s64_rhs));
+
+  auto u64_lhs = Simd128<uint64>::list(~0ull, 1ull << 32);
+  auto u64_rhs = Simd128<uint64>::list(~0ull, 1ull << 32);
+  auto u64_valid = Simd128<uint64>::list(~0ull - 1, 1);
+  EXPECT_EQ(u64_valid, simulated::mul_hi(u64_lhs, u64_rhs));
+  EXPECT_EQ(u64_valid, mul_hi(u64_lhs, u64_rhs));
+
+  TestAvgRoundAndMulHi<NativeSimd<int8>>();
+  TestAvgRoundAndMulHi<NativeSimd<uint8>>();
+  TestAvgRoundAndMulHi<NativeSimd<int16>>();
+  TestAvgRoundAndMulHi<NativeSimd<uint16>>();
+  TestAvgRoundAndMulHi<NativeSimd<int32>>();
+  TestAvgRoundAndMulHi<NativeSimd<uint32>>();
+  TestAvgRoundAndMulHi<NativeSimd<int64>>();
+  TestAvgRoundAndMulHi<NativeSimd<uint64>>();
+  TestAvgRoundAndMulHi<Simd128<int8>>();
+  TestAvgRoundAndMulHi<Simd128<int16>>();
+  TestAvgRoundAndMulHi<Simd128<uint16>>();
+}
+
+TEST(DimsumTest, MulHiRound) {
+  // Q15 products: 0.5 * 0.5, 0.5 * -0.5, and ties that round up.
+  auto lhs = Simd128<int16>::list(16384, 16384, 1, -1, 32767, -32768, 3, 100);
+  auto rhs = Simd128<int16>::list(16384, -16384, 16384, 16384, 32767, 32767,
+                                  -16384, 200);
+  auto valid = Simd128<int16>::list(8192, -8192, 1, 0, 32766, -32767, -1, 1);
+  EXPECT_EQ(valid, simulated::mul_hi_round(lhs, rhs));
+  EXPECT_EQ(valid, mul_hi_round(lhs, rhs));
+
+  // Every lhs against a few rhs, leaving out -32768 * -32768.
+  for (int32 r : {-32768, -32767, -12345, -1, 0, 1, 2, 12345, 32767}) {
+    for (int32 l = -32767; l <= 32767; l += NativeSimd<int16>::size()) {
+      NativeSimd<int16> lhs_simd;
+      for (size_t i = 0; i < lhs_simd.size(); i++) {
+        lhs_simd.set(i, static_cast<int16>(std::min<int32>(l + i, 32767)));
+      }
+      NativeSimd<int16> rhs_simd(static_cast<int16>(r));
+      ASSERT_EQ(simulated::mul_hi_round(lhs_simd, rhs_simd),
+                mul_hi_round(lhs_simd, rhs_simd))
+          << l << " * " << r;
+    }
+  }
+}
+
+TEST(DimsumTest, BlendU8) {
+  auto src = Simd128<uint8>::list(255, 255, 0, 0, 200, 200, 100, 1, 254, 128,
+                                  10, 255, 3, 90, 17, 0);
+  auto dst = Simd128<uint8>::list(0, 0, 255, 255, 100, 100, 200, 0, 0, 0, 20,
+                                  0, 5, 90, 17, 255);
+  auto alpha = Simd128<uint8>::list(255, 0, 255, 0, 128, 127, 1, 128, 1, 1,
+                                    64, 128, 255, 77, 200, 128);
+  auto valid = Simd128<uint8>::list(255, 0, 0, 255, 150, 150, 200, 1, 1, 1, 17,
+                                    128, 3, 90, 17, 127);
+  EXPECT_EQ(valid, simulated::blend_u8(src, dst, alpha));
+  EXPECT_EQ(valid, blend_u8(src, dst, alpha));
+
+  // Every (src, alpha) pair, over a few backgrounds.
+  using SimdType = NativeSimd<uint8>;
+  for (int d : {0, 1, 127, 128, 254, 255}) {
+    for (int s = 0; s < 256; s++) {
+      for (int a = 0; a < 256; a += SimdType::size()) {
+        SimdType alpha_simd;
+        for (size_t i = 0; i < SimdType::size(); i++) {
+          alpha_simd.set(i, static_cast<uint8>(a + i));
+        }
+        auto result = blend_u8(SimdType(static_cast<uint8>(s)),
+                               SimdType(static_cast<uint8>(d)), alpha_simd);
+        for (size_t i = 0; i < SimdType::size(); i++) {
+          ASSERT_EQ((s * (a + i) + d * (255 - a - i) + 127) / 255, result[i])
+              << s << ", " << d << ", " << a + i;
+        }
+      }
+    }
+  }
+}
+
 TEST(DimsumTest, Mul) {
   SIMD_BINARY_FREE_FUNC_TEST(int32, mul, elementwise_mul_test);
   SIMD_BINARY_FREE_FUNC_TEST(uint32, mul, elementwise_mul_test_uint);
   SIMD_BINARY_FREE_FUNC_TEST(float, mul, elementwise_mul_test_float);
 }
 
+TEST(DimsumTest, Fma) {
+  // The products are exact, so fused and unfused lowerings agree.
+  auto f_lhs = Simd128<float>::list(1.5, -2, 0.25, 3e10);
+  auto f_rhs = Simd128<float>::list(4, 3, -8, 2);
+  auto f_acc = Simd128<float>::list(0.5, 7, 1, -6e10);
+  auto f_valid = Simd128<float>::list(6.5, 1, -1, 0);
+  EXPECT_EQ(f_valid, simulated::fma(f_lhs, f_rhs, f_acc));
+  EXPECT_EQ(f_valid, fma(f_lhs, f_rhs, f_acc));
+
+  auto d_lhs = Simd128<double>::list(1.5, -2);
+  auto d_rhs = Simd128<double>::list(4, 1e300);
+  auto d_acc = Simd128<double>::list(0.5, 2e300);
+  auto d_valid = Simd128<double>::list(6.5, 0);
+  EXPECT_EQ(d_valid, simulated::fma(d_lhs, d_rhs, d_acc));
+  EXPECT_EQ(d_valid, fma(d_lhs, d_rhs, d_acc));
+
+  auto i_lhs = Simd128<int32>::list(3, -4, 300, 7);
+  auto i_rhs = Simd128<int32>::list(5, 6, -300, -1);
+  auto i_acc = Simd128<int32>::list(1, 24, 9, 7);
+  auto i_valid = Simd128<int32>::list(16, 0, -89991, 0);
+  EXPECT_EQ(i_valid, simulated::fma(i_lhs, i_rhs, i_acc));
+  EXPECT_EQ(i_valid, fma(i_lhs, i_rhs, i_acc));
+}
+
 TEST(DimsumTest, ShiftLeft) {
   int32 input[][5] = {
       {1, 2, 3, 4, 1},
@@ -500,6 +700,74 @@ TEST(DimsumTest, ShiftRight) {
             shr(Simd128<int32>::list(1, 2, 3, 4), 1));
 }
 
+template <typename SimdType>
+void TestShifts() {
+  using T = typename SimdType::value_type;
+  constexpr size_t kBits = 8 * sizeof(T);
+  for (size_t seed = 0; seed < 256; seed++) {
+    SimdType simd, count;
+    for (size_t i = 0; i < SimdType::size(); i++) {
+      simd.set(i, static_cast<T>((seed * 64 + i) * 0x9e3779b97f4a7c15ull));
+      count.set(i, static_cast<T>((seed + i * 7) % kBits));
+    }
+    EXPECT_EQ(simulated::shl_simd(simd, count), shl_simd(simd, count))
+        << "shl_simd(" << simd << ", " << count << ")";
+    EXPECT_EQ(simulated::shr_simd(simd, count), shr_simd(simd, count))
+        << "shr_simd(" << simd << ", " << count << ")";
+    EXPECT_EQ(simulated::rotl_simd(simd, count), rotl_simd(simd, count))
+        << "rotl_simd(" << simd << ", " << count << ")";
+    EXPECT_EQ(simulated::rotr_simd(simd, count), rotr_simd(simd, count))
+        << "rotr_simd(" << simd << ", " << count << ")";
+
+    int uniform = seed % kBits;
+    EXPECT_EQ(simulated::shl(simd, uniform), shl(simd, uniform));
+    EXPECT_EQ(simulated::shr(simd, uniform), shr(simd, uniform));
+    EXPECT_EQ(simulated::rotl(simd, uniform), rotl(simd, uniform));
+    EXPECT_EQ(simulated::rotr(simd, uniform), rotr(simd, uniform));
+  }
+}
+
+TEST(DimsumTest, VariableShifts) {
+  TestShifts<NativeSimd<int8>>();
+  TestShifts<NativeSimd<uint8>>();
+  TestShifts<NativeSimd<int16>>();
+  TestShifts<NativeSimd<uint16>>();
+  TestShifts<NativeSimd<int32>>();
+  TestShifts<NativeSimd<uint32>>();
+  TestShifts<NativeSimd<int64>>();
+  TestShifts<NativeSimd<uint64>>();
+  TestShifts<Simd128<int8>>();
+  TestShifts<Simd128<uint8>>();
+  TestShifts<Simd128<int16>>();
+  TestShifts<Simd128<uint16>>();
+  TestShifts<Simd128<int32>>();
+  TestShifts<Simd128<uint32>>();
+  TestShifts<Simd128<int64>>();
+  TestShifts<Simd128<uint64>>();
+}
+
+TEST(DimsumTest, Rotate) {
+  auto u8 = Simd128<uint8>::list(0x81, 0x81, 0x81, 0x81, 0x12, 0x12, 0x12,
+                                 0x12, 1, 1, 1, 1, 0xf0, 0xf0, 0xf0, 0xf0);
+  auto u8_count = Simd128<uint8>::list(0, 1, 4, 7, 0, 1, 4, 7, 0, 1, 4, 7, 0,
+                                       1, 4, 7);
+  auto u8_valid = Simd128<uint8>::list(0x81, 0x03, 0x18, 0xc0, 0x12, 0x24,
+                                       0x21, 0x09, 1, 2, 0x10, 0x80, 0xf0,
+                                       0xe1, 0x0f, 0x78);
+  EXPECT_EQ(u8_valid, simulated::rotl_simd(u8, u8_count));
+  EXPECT_EQ(u8_valid, rotl_simd(u8, u8_count));
+  EXPECT_EQ(u8, rotr_simd(u8_valid, u8_count));
+
+  auto s32 = Simd128<int32>::list(-1, bitconvert(0x80000001), 0x12345678,
+                                  0x12345678);
+  auto s32_valid = Simd128<int32>::list(-1, 3, 0x23456781, 0x34567812);
+  EXPECT_EQ(s32_valid, rotl_simd(s32, Simd128<int32>::list(5, 1, 4, 8)));
+  EXPECT_EQ((Simd128<int32>::list(-1, 0x30, 0x23456781, 0x23456781)),
+            rotl(Simd128<int32>::list(-1, 3, 0x12345678, 0x12345678), 4));
+  EXPECT_EQ((Simd128<uint64>::list(0x8000000000000000ull, 0x2ull)),
+            rotr(Simd128<uint64>::list(1, 4), 1));
+}
+
 TEST(DimsumTest, BitAnd) {
   SIMD_BINARY_FREE_FUNC_TEST(int32, bit_and, boring_binary_op_test);
 }
@@ -645,16 +913,209 @@ TEST(DimsumTest, MulSum) {
                      Simd128<int32>::list(0, 1, 2, 3))));
 }
 
+// Lanes are in the ranges where every lowering is exact.
+template <typename Abi>
+void TestDotProduct() {
+  Simd<uint8, Abi> small_u8([](int i) { return i * 37 % 128; });
+  Simd<uint8, Abi> u8([](int i) { return 255 - i * 29 % 256; });
+  Simd<int8, Abi> s8([](int i) { return i % 2 ? -128 + i : 127 - i; });
+  Simd<int8, Abi> small_s8([](int i) { return i * 13 % 129 - 64; });
+  Simd<int8, Abi> s8_no_min([](int i) { return i % 2 ? -127 + i : 127 - i; });
+  Simd<int32, Abi> acc([](int i) { return i * 1000 - 3000; });
+
+  auto expect_dot = [&](Simd<int32, Abi> result, auto lhs, auto rhs) {
+    for (size_t i = 0; i < acc.size(); i++) {
+      int32 expected = acc[i];
+      for (size_t j = 4 * i; j < 4 * i + 4; j++) {
+        expected += int32{lhs[j]} * rhs[j];
+      }
+      EXPECT_EQ(expected, result[i]) << i;
+    }
+  };
+  expect_dot(dot_u8s8_i32(acc, small_u8, s8), small_u8, s8);
+  expect_dot(dot_u8s8_i32(acc, u8, small_s8), u8, small_s8);
+  expect_dot(dot_s8s8_i32(acc, s8, s8_no_min), s8, s8_no_min);
+  expect_dot(dot_s8s8_i32(acc, bit_cast<int8>(u8), small_s8),
+             bit_cast<int8>(u8), small_s8);
+
+  // 255 * 127 * 2 overflows int16.
+  bool saturates = detail::DotProductKindOf<Abi>() ==
+                   detail::DotProductKind::kSaturatedPairs;
+  EXPECT_EQ(saturates ? 32767 * 2 : 255 * 127 * 4,
+            (dot_u8s8_i32(Simd<int32, Abi>(0), Simd<uint8, Abi>(255),
+                          Simd<int8, Abi>(127))[0]));
+  EXPECT_EQ(saturates ? -128 * 127 * 4 : 128 * 127 * 4,
+            (dot_s8s8_i32(Simd<int32, Abi>(0), Simd<int8, Abi>(-127),
+                          Simd<int8, Abi>(-128))[0]));
+}
+
+TEST(DimsumTest, DotProduct) {
+  TestDotProduct<Simd128<int32>::abi_type>();
+  TestDotProduct<NativeSimd<int32>::abi_type>();
+}
+
 TEST(DimsumTest, Max) {
   EXPECT_EQ(
       (Simd128<int32>::list(2, 3, 5, 6)),
       max(Simd128<int32>::list(2, 3, 2, 6), Simd128<int32>::list(0, 1, 5, 3)));
+  EXPECT_EQ((Simd128<int64>::list(-1, 1ll << 40)),
+            max(Simd128<int64>::list(-1, -2),
+                Simd128<int64>::list(-5, 1ll << 40)));
+  EXPECT_EQ((Simd128<uint64>::list(~0ull, 3)),
+            max(Simd128<uint64>::list(~0ull, 2), Simd128<uint64>::list(1, 3)));
 }
 
 TEST(DimsumTest, Min) {
   EXPECT_EQ(
       (Simd128<int32>::list(0, 1, 2, 3)),
       min(Simd128<int32>::list(2, 3, 2, 6), Simd128<int32>::list(0, 1, 5, 3)));
+  EXPECT_EQ((Simd128<int64>::list(-5, -2)),
+            min(Simd128<int64>::list(-1, -2),
+                Simd128<int64>::list(-5, 1ll << 40)));
+  EXPECT_EQ((Simd128<uint64>::list(1, 2)),
+            min(Simd128<uint64>::list(~0ull, 2), Simd128<uint64>::list(1, 3)));
+}
+
+// Pairs lanes that differ only in the low or only in the high 32 bits, and
+// in the sign bit, which the 64-bit lowerings built from 32-bit operations
+// have to get right.
+template <typename SimdType>
+void Test64BitArithmetic() {
+  using T = typename SimdType::value_type;
+  const uint64 kValues[] = {0,
+                            1,
+                            0xffffffff,
+                            0x100000000ull,
+                            0x1ffffffffull,
+                            0x7fffffffffffffffull,
+                            0x8000000000000000ull,
+                            0x80000000ffffffffull,
+                            0xffffffff00000000ull,
+                            0xffffffff7fffffffull,
+                            ~0ull,
+                            0x123456789abcdef0ull};
+  constexpr size_t kNumValues = sizeof(kValues) / sizeof(kValues[0]);
+  for (size_t i = 0; i < kNumValues; i++) {
+    for (size_t j = 0; j < kNumValues; j += SimdType::size()) {
+      SimdType lhs(static_cast<T>(kValues[i])), rhs;
+      for (size_t k = 0; k < SimdType::size(); k++) {
+        rhs.set(k, static_cast<T>(kValues[(j + k) % kNumValues]));
+      }
+      EXPECT_EQ(simulated::mul(lhs, rhs), mul(lhs, rhs));
+      EXPECT_EQ(simulated::mul_hi(lhs, rhs), mul_hi(lhs, rhs));
+      EXPECT_EQ(simulated::min(lhs, rhs), min(lhs, rhs));
+      EXPECT_EQ(simulated::max(lhs, rhs), max(lhs, rhs));
+      EXPECT_EQ(simulated::cmp_gt(lhs, rhs), cmp_gt(lhs, rhs));
+      EXPECT_EQ(simulated::cmp_lt(lhs, rhs), cmp_lt(lhs, rhs));
+    }
+  }
+}
+
+TEST(DimsumTest, Arithmetic64Bit) {
+  Test64BitArithmetic<NativeSimd<int64>>();
+  Test64BitArithmetic<NativeSimd<uint64>>();
+  Test64BitArithmetic<Simd128<int64>>();
+  Test64BitArithmetic<Simd128<uint64>>();
+}
+
+// Compares every pair of values around zero, the sign bit and the maximum,
+// which is where sign-flipped and min/max-based unsigned comparisons go wrong.
+template <typename SimdType>
+void TestUnsignedCompare() {
+  using T = typename SimdType::value_type;
+  constexpr T kSignBit = T{1} << (8 * sizeof(T) - 1);
+  const T kValues[] = {0,
+                       1,
+                       2,
+                       static_cast<T>(kSignBit - 2),
+                       static_cast<T>(kSignBit - 1),
+                       kSignBit,
+                       static_cast<T>(kSignBit + 1),
+                       static_cast<T>(~T{0} - 1),
+                       static_cast<T>(~T{0})};
+  constexpr size_t kNumValues = sizeof(kValues) / sizeof(kValues[0]);
+  for (size_t i = 0; i < kNumValues; i++) {
+    for (size_t j = 0; j < kNumValues; j += SimdType::size()) {
+      SimdType lhs(kValues[i]), rhs;
+      for (size_t k = 0; k < SimdType::size(); k++) {
+        rhs.set(k, kValues[(j + k) % kNumValues]);
+      }
+      EXPECT_EQ(simulated::cmp_gt(lhs, rhs), cmp_gt(lhs, rhs));
+      EXPECT_EQ(simulated::cmp_lt(lhs, rhs), cmp_lt(lhs, rhs));
+      EXPECT_EQ(simulated::cmp_ge(lhs, rhs), cmp_ge(lhs, rhs));
+      EXPECT_EQ(simulated::cmp_le(lhs, rhs), cmp_le(lhs, rhs));
+    }
+  }
+}
+
+TEST(DimsumTest, UnsignedCompare) {
+  TestUnsignedCompare<NativeSimd<uint8>>();
+  TestUnsignedCompare<NativeSimd<uint16>>();
+  TestUnsignedCompare<NativeSimd<uint32>>();
+  TestUnsignedCompare<NativeSimd<uint64>>();
+  TestUnsignedCompare<Simd128<uint8>>();
+  TestUnsignedCompare<Simd128<uint16>>();
+  TestUnsignedCompare<Simd128<uint32>>();
+  TestUnsignedCompare<Simd128<uint64>>();
+}
+
+// Selects between two vectors by the comparison of their lanes with
+// `threshold`, and checks every lane against the scalar condition.
+template <typename SimdType>
+void TestSelect() {
+  using T = typename SimdType::value_type;
+  SimdType lhs, rhs;
+  for (size_t i = 0; i < SimdType::size(); i++) {
+    lhs.set(i, static_cast<T>(i * 37 % 11));
+    rhs.set(i, static_cast<T>(100 - i));
+  }
+  const T threshold = 5;
+  auto mask = cmp_lt(lhs, SimdType(threshold));
+  auto result = select(mask, lhs, rhs);
+  for (size_t i = 0; i < SimdType::size(); i++) {
+    EXPECT_EQ(lhs[i] < threshold ? lhs[i] : rhs[i], result[i]) << i;
+  }
+  EXPECT_EQ(simulated::select(mask, lhs, rhs), result);
+}
+
+TEST(DimsumTest, Select) {
+  EXPECT_EQ((Simd128<int32>::list(1, 6, 3, 8)),
+            select(Simd128<uint32>::list(~0u, 0, ~0u, 0),
+                   Simd128<int32>::list(1, 2, 3, 4),
+                   Simd128<int32>::list(5, 6, 7, 8)));
+  auto x = Simd128<float>::list(-1, 0.5, -3, 2);
+  EXPECT_EQ((Simd128<float>::list(0, 0.5, 0, 2)),
+            select(cmp_lt(x, Simd128<float>(0)), Simd128<float>(0), x));
+  TestSelect<NativeSimd<int8>>();
+  TestSelect<NativeSimd<uint8>>();
+  TestSelect<NativeSimd<int16>>();
+  TestSelect<NativeSimd<uint16>>();
+  TestSelect<NativeSimd<int32>>();
+  TestSelect<NativeSimd<uint32>>();
+  TestSelect<NativeSimd<int64>>();
+  TestSelect<NativeSimd<uint64>>();
+  TestSelect<NativeSimd<float>>();
+  TestSelect<NativeSimd<double>>();
+  TestSelect<Simd128<int16>>();
+  TestSelect<Simd128<double>>();
+}
+
+TEST(DimsumTest, Blend) {
+  auto a = Simd128<int32>::list(1, 2, 3, 4);
+  auto b = Simd128<int32>::list(5, 6, 7, 8);
+  EXPECT_EQ((Simd128<int32>::list(1, 6, 3, 8)), (blend<1, 0, 1, 0>(a, b)));
+  EXPECT_EQ((Simd128<int32>::list(5, 6, 3, 4)), (blend<0, 0, 1, 1>(a, b)));
+  EXPECT_EQ(b, (blend<0, 0, 0, 0>(a, b)));
+  EXPECT_EQ(a, (blend<1, 1, 1, 1>(a, b)));
+  EXPECT_EQ((simulated::blend<0, 1, 1, 0>(a, b)), (blend<0, 1, 1, 0>(a, b)));
+
+  auto c = Simd128<uint16>::list(0, 1, 2, 3, 4, 5, 6, 7);
+  auto d = Simd128<uint16>::list(10, 11, 12, 13, 14, 15, 16, 17);
+  EXPECT_EQ((Simd128<uint16>::list(0, 11, 12, 3, 4, 15, 16, 17)),
+            (blend<1, 0, 0, 1, 1, 0, 0, 0>(c, d)));
+  EXPECT_EQ((Simd128<double>::list(2, 1)),
+            (blend<0, 1>(Simd128<double>::list(0, 1),
+                         Simd128<double>::list(2, 3))));
 }
 
 TEST(DimsumTest, HorizontalSum) {
@@ -811,6 +1272,175 @@ TEST(DimsumTest, StaticSimdCast) {
   TestSignStaticSimdCast<NativeSimd<uint64>, NativeSimd<int64>>();
 }
 
+template <typename T>
+void AddWithNeighbors(T value, std::vector<T>* values) {
+  values->push_back(value);
+  if (std::is_floating_point<T>::value) {
+    values->push_back(std::nextafter(value, -INFINITY));
+    values->push_back(std::nextafter(value, INFINITY));
+  } else {
+    values->push_back(static_cast<T>(static_cast<uint64>(value) - 1));
+    values->push_back(static_cast<T>(static_cast<uint64>(value) + 1));
+  }
+}
+
+// Checks saturated_simd_cast against the scalar reference for values around
+// the bounds of both types.
+template <typename Dest, typename SrcSimd>
+void TestSaturatedSimdCast() {
+  using Src = typename SrcSimd::value_type;
+  std::vector<Src> values;
+  AddWithNeighbors<Src>(0, &values);
+  AddWithNeighbors(std::numeric_limits<Src>::lowest(), &values);
+  AddWithNeighbors(std::numeric_limits<Src>::max(), &values);
+  AddWithNeighbors(static_cast<Src>(std::numeric_limits<Dest>::min()),
+                   &values);
+  AddWithNeighbors(static_cast<Src>(std::numeric_limits<Dest>::max()),
+                   &values);
+  if (std::is_floating_point<Src>::value) {
+    values.push_back(std::numeric_limits<Src>::quiet_NaN());
+    values.push_back(-std::numeric_limits<Src>::quiet_NaN());
+    values.push_back(std::numeric_limits<Src>::infinity());
+    values.push_back(-std::numeric_limits<Src>::infinity());
+    values.push_back(static_cast<Src>(0.75));
+    values.push_back(static_cast<Src>(-0.75));
+  }
+  while (values.size() % SrcSimd::size() != 0) values.push_back(1);
+  for (size_t i = 0; i < values.size(); i += SrcSimd::size()) {
+    SrcSimd simd(&values[i], flags::element_aligned);
+    EXPECT_EQ(simulated::saturated_simd_cast<Dest>(simd),
+              saturated_simd_cast<Dest>(simd))
+        << simd;
+  }
+}
+
+template <typename Src, template <typename> class SimdType>
+void TestSaturatedSimdCastFrom() {
+  TestSaturatedSimdCast<int8, SimdType<Src>>();
+  TestSaturatedSimdCast<int16, SimdType<Src>>();
+  TestSaturatedSimdCast<int32, SimdType<Src>>();
+  TestSaturatedSimdCast<int64, SimdType<Src>>();
+  TestSaturatedSimdCast<uint8, SimdType<Src>>();
+  TestSaturatedSimdCast<uint16, SimdType<Src>>();
+  TestSaturatedSimdCast<uint32, SimdType<Src>>();
+  TestSaturatedSimdCast<uint64, SimdType<Src>>();
+}
+
+TEST(DimsumTest, SaturatedSimdCast) {
+  EXPECT_EQ((ChangeElemTo<Simd128<int32>, uint8>::list(0, 7, 255, 255)),
+            saturated_simd_cast<uint8>(Simd128<int32>::list(-1, 7, 300, 255)));
+  EXPECT_EQ((ChangeElemTo<Simd128<float>, int32>::list(
+                std::numeric_limits<int32>::max(),
+                std::numeric_limits<int32>::min(), 0, -3)),
+            saturated_simd_cast<int32>(
+                Simd128<float>::list(3e9, -1e20, NAN, -3.9)));
+
+  TestSaturatedSimdCastFrom<int8, NativeSimd>();
+  TestSaturatedSimdCastFrom<int16, NativeSimd>();
+  TestSaturatedSimdCastFrom<int32, NativeSimd>();
+  TestSaturatedSimdCastFrom<int64, NativeSimd>();
+  TestSaturatedSimdCastFrom<uint8, NativeSimd>();
+  TestSaturatedSimdCastFrom<uint16, NativeSimd>();
+  TestSaturatedSimdCastFrom<uint32, NativeSimd>();
+  TestSaturatedSimdCastFrom<uint64, NativeSimd>();
+  TestSaturatedSimdCastFrom<float, NativeSimd>();
+  TestSaturatedSimdCastFrom<double, NativeSimd>();
+  TestSaturatedSimdCastFrom<int16, Simd128>();
+  TestSaturatedSimdCastFrom<int32, Simd128>();
+  TestSaturatedSimdCastFrom<uint32, Simd128>();
+  TestSaturatedSimdCastFrom<uint16, Simd128>();
+  TestSaturatedSimdCastFrom<int64, Simd128>();
+  TestSaturatedSimdCastFrom<uint64, Simd128>();
+  TestSaturatedSimdCastFrom<float, Simd128>();
+  TestSaturatedSimdCastFrom<double, Simd128>();
+}
+
+uint32 FloatBits(float value) {
+  uint32 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+float FloatFromBits(uint32 bits) {
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+TEST(DimsumTest, Float16) {
+  EXPECT_EQ(0x3c00, float16(1.f).bits());
+  EXPECT_EQ(0xc000, float16(-2.f).bits());
+  EXPECT_EQ(0x3555, float16(1.f / 3).bits());
+  EXPECT_EQ(0x7bff, float16(65504.f).bits());
+  EXPECT_EQ(0x7bff, float16(65519.f).bits());
+  EXPECT_EQ(0x7c00, float16(65520.f).bits());
+  EXPECT_EQ(0xfc00, float16(-1e10f).bits());
+  // Subnormals, with ties rounding to even.
+  EXPECT_EQ(0x0001, float16(FloatFromBits(0x33800000)).bits());
+  EXPECT_EQ(0x0000, float16(FloatFromBits(0x33000000)).bits());
+  EXPECT_EQ(0x0002, float16(FloatFromBits(0x33c00000)).bits());
+  EXPECT_EQ(0x0400, float16(FloatFromBits(0x387fe000)).bits());
+  EXPECT_EQ(0x7e00, float16(FloatFromBits(0x7f800001)).bits());
+
+  EXPECT_EQ(0x387fc000u, FloatBits(float16::from_bits(0x03ff)));
+  EXPECT_EQ(0x3f802000u, FloatBits(float16::from_bits(0x3c01)));
+  EXPECT_EQ(0xff800000u, FloatBits(float16::from_bits(0xfc00)));
+  EXPECT_EQ(0x7fc02000u, FloatBits(float16::from_bits(0x7c01)));
+}
+
+TEST(DimsumTest, Bfloat16) {
+  EXPECT_EQ(0x3f80, bfloat16(1.f).bits());
+  EXPECT_EQ(0x3f80, bfloat16(FloatFromBits(0x3f808000)).bits());
+  EXPECT_EQ(0x3f82, bfloat16(FloatFromBits(0x3f818000)).bits());
+  EXPECT_EQ(0x3f81, bfloat16(FloatFromBits(0x3f808001)).bits());
+  EXPECT_EQ(0x7f80, bfloat16(FloatFromBits(0x7f7fffff)).bits());
+  EXPECT_EQ(0x7fc0, bfloat16(FloatFromBits(0x7f800001)).bits());
+  EXPECT_EQ(0xc0490000u, FloatBits(bfloat16::from_bits(0xc049)));
+}
+
+// Checks static_simd_cast between FloatSimd and the same number of Half lanes
+// against the scalar conversions, bit by bit since lanes may be NaNs.
+template <typename Half, typename FloatSimd>
+void TestHalfPrecisionCast() {
+  using HalfSimd = ChangeElemTo<FloatSimd, Half>;
+  constexpr size_t kSize = FloatSimd::size();
+  for (uint32 i = 0; i < 65536; i += kSize) {
+    HalfSimd halves([i](size_t j) { return Half::from_bits(i + j); });
+    FloatSimd floats = static_simd_cast<float>(halves);
+    HalfSimd round_trip = static_simd_cast<Half>(floats);
+    for (size_t j = 0; j < kSize; j++) {
+      ASSERT_EQ(FloatBits(halves[j]), FloatBits(floats[j])) << i + j;
+      ASSERT_EQ(Half(floats[j]).bits(), round_trip[j].bits()) << i + j;
+    }
+  }
+  // Steps through float bit patterns by a prime, covering all exponents.
+  for (uint64 i = 0; i < (uint64{1} << 32); i += 4099 * kSize) {
+    FloatSimd floats(
+        [i](size_t j) { return FloatFromBits(static_cast<uint32>(i + j)); });
+    HalfSimd halves = static_simd_cast<Half>(floats);
+    for (size_t j = 0; j < kSize; j++) {
+      ASSERT_EQ(Half(floats[j]).bits(), halves[j].bits()) << i + j;
+    }
+  }
+}
+
+TEST(DimsumTest, HalfPrecisionCast) {
+  TestHalfPrecisionCast<float16, NativeSimd<float>>();
+  TestHalfPrecisionCast<float16, Simd128<float>>();
+  TestHalfPrecisionCast<bfloat16, NativeSimd<float>>();
+  TestHalfPrecisionCast<bfloat16, Simd128<float>>();
+
+  auto floats = Simd128<float>::list(1, -2.5, 65504, 1e-3);
+  auto halves = static_simd_cast<float16>(floats);
+  EXPECT_EQ(0x3c00, halves[0].bits());
+  EXPECT_EQ(0xc100, halves[1].bits());
+  EXPECT_EQ(0x7bff, halves[2].bits());
+  EXPECT_EQ(0x1419, halves[3].bits());
+  halves.set(3, float16(0.5f));
+  EXPECT_EQ(Simd128<float>::list(1, -2.5, 65504, 0.5),
+            static_simd_cast<float>(halves));
+}
+
 template <typename SimdType, size_t num_elements>
 struct TestZipImpl {
   static void Apply() {}
@@ -901,6 +1531,189 @@ TEST(DimsumTest, Zip) {
   TestZip<NativeSimd<double>>();
 }
 
+template <typename SimdType>
+void TestZipHalvesAndUnzip() {
+  using T = typename SimdType::value_type;
+  constexpr int kSize = SimdType::size();
+  SimdType lhs, rhs;
+  for (int i = 0; i < kSize; i++) {
+    lhs.set(i, static_cast<T>(i + 1));
+    rhs.set(i, static_cast<T>(i + 1 + kSize));
+  }
+  SimdType lo = zip_lo(lhs, rhs), hi = zip_hi(lhs, rhs);
+  auto zipped = zip(lhs, rhs);
+  for (int i = 0; i < kSize; i++) {
+    EXPECT_EQ(zipped[i], lo[i]);
+    EXPECT_EQ(zipped[i + kSize], hi[i]);
+  }
+  EXPECT_EQ(lhs, unzip_even(lo, hi));
+  EXPECT_EQ(rhs, unzip_odd(lo, hi));
+  EXPECT_EQ(simulated::unzip_even(lhs, rhs), unzip_even(lhs, rhs));
+  EXPECT_EQ(simulated::unzip_odd(lhs, rhs), unzip_odd(lhs, rhs));
+}
+
+TEST(DimsumTest, ZipHalvesAndUnzip) {
+  TestZipHalvesAndUnzip<NativeSimd<int8>>();
+  TestZipHalvesAndUnzip<NativeSimd<int16>>();
+  TestZipHalvesAndUnzip<NativeSimd<int32>>();
+  TestZipHalvesAndUnzip<NativeSimd<int64>>();
+  TestZipHalvesAndUnzip<NativeSimd<uint8>>();
+  TestZipHalvesAndUnzip<NativeSimd<uint16>>();
+  TestZipHalvesAndUnzip<NativeSimd<uint32>>();
+  TestZipHalvesAndUnzip<NativeSimd<uint64>>();
+  TestZipHalvesAndUnzip<NativeSimd<float>>();
+  TestZipHalvesAndUnzip<NativeSimd<double>>();
+  TestZipHalvesAndUnzip<Simd128<uint8>>();
+  TestZipHalvesAndUnzip<Simd128<int16>>();
+  TestZipHalvesAndUnzip<Simd128<float>>();
+  TestZipHalvesAndUnzip<Simd128<double>>();
+  TestZipHalvesAndUnzip<Simd64<int16>>();
+
+  auto lhs = Simd128<int32>::list(1, 2, 3, 4);
+  auto rhs = Simd128<int32>::list(5, 6, 7, 8);
+  EXPECT_EQ(Simd128<int32>::list(1, 5, 2, 6), zip_lo(lhs, rhs));
+  EXPECT_EQ(Simd128<int32>::list(3, 7, 4, 8), zip_hi(lhs, rhs));
+  EXPECT_EQ(Simd128<int32>::list(1, 3, 5, 7), unzip_even(lhs, rhs));
+  EXPECT_EQ(Simd128<int32>::list(2, 4, 6, 8), unzip_odd(lhs, rhs));
+}
+
+// Small integral parts keep every product and sum exact, so fused and unfused
+// lowerings agree with the reference.
+template <typename SimdType>
+void TestComplex() {
+  using T = typename SimdType::value_type;
+  constexpr int kSize = SimdType::size();
+  SimdType lhs, rhs;
+  for (int i = 0; i < kSize; i++) {
+    lhs.set(i, static_cast<T>(i % 3 == 0 ? i + 1 : -i));
+    rhs.set(i, static_cast<T>(i % 4 == 1 ? 2 - i : i * 2 + 3));
+  }
+  EXPECT_EQ(simulated::complex_mul(lhs, rhs), complex_mul(lhs, rhs));
+  EXPECT_EQ(simulated::complex_conj_mul(lhs, rhs),
+            complex_conj_mul(lhs, rhs));
+  EXPECT_EQ(simulated::complex_abs2(lhs), complex_abs2(lhs));
+}
+
+TEST(DimsumTest, Complex) {
+  TestComplex<NativeSimd<float>>();
+  TestComplex<NativeSimd<double>>();
+  TestComplex<Simd128<float>>();
+  TestComplex<Simd128<double>>();
+  TestComplex<Simd64<float>>();
+
+  // (1 + 2i)(3 - 4i) = 11 + 2i, (-1 + 0.5i)(2 + 2i) = -3 - i.
+  auto lhs = Simd128<float>::list(1, 2, -1, 0.5);
+  auto rhs = Simd128<float>::list(3, -4, 2, 2);
+  EXPECT_EQ(Simd128<float>::list(11, 2, -3, -1), complex_mul(lhs, rhs));
+  // (1 + 2i)(3 + 4i) = -5 + 10i, (-1 + 0.5i)(2 - 2i) = -1 + 3i.
+  EXPECT_EQ(Simd128<float>::list(-5, 10, -1, 3), complex_conj_mul(lhs, rhs));
+  EXPECT_EQ(Simd128<float>::list(5, 5, 1.25, 1.25), complex_abs2(lhs));
+
+  auto d_lhs = Simd128<double>::list(1, 2);
+  auto d_rhs = Simd128<double>::list(3, -4);
+  EXPECT_EQ(Simd128<double>::list(11, 2), complex_mul(d_lhs, d_rhs));
+  EXPECT_EQ(Simd128<double>::list(-5, 10), complex_conj_mul(d_lhs, d_rhs));
+  EXPECT_EQ(Simd128<double>::list(5, 5), complex_abs2(d_lhs));
+}
+
+template <size_t kN, typename SimdType>
+void TestInterleaved() {
+  using T = typename SimdType::value_type;
+  constexpr size_t kSize = kN * SimdType::size();
+  T buffer[kSize];
+  for (size_t i = 0; i < kSize; i++) {
+    buffer[i] = static_cast<T>(i * 7 + 1);
+  }
+  auto channels = load_interleaved<kN, SimdType>(buffer);
+  for (size_t c = 0; c < kN; c++) {
+    for (size_t i = 0; i < SimdType::size(); i++) {
+      EXPECT_EQ(buffer[kN * i + c], channels[c][i]);
+    }
+  }
+
+  T stored[kSize] = {};
+  store_interleaved<kN>(stored, channels);
+  for (size_t i = 0; i < kSize; i++) {
+    EXPECT_EQ(buffer[i], stored[i]);
+  }
+}
+
+template <typename SimdType>
+void TestInterleavedAllChannels() {
+  TestInterleaved<2, SimdType>();
+  TestInterleaved<3, SimdType>();
+  TestInterleaved<4, SimdType>();
+}
+
+TEST(DimsumTest, Interleaved) {
+  TestInterleavedAllChannels<NativeSimd<int8>>();
+  TestInterleavedAllChannels<NativeSimd<int16>>();
+  TestInterleavedAllChannels<NativeSimd<int32>>();
+  TestInterleavedAllChannels<NativeSimd<int64>>();
+  TestInterleavedAllChannels<NativeSimd<uint8>>();
+  TestInterleavedAllChannels<NativeSimd<uint16>>();
+  TestInterleavedAllChannels<NativeSimd<uint32>>();
+  TestInterleavedAllChannels<NativeSimd<uint64>>();
+  TestInterleavedAllChannels<NativeSimd<float>>();
+  TestInterleavedAllChannels<NativeSimd<double>>();
+  TestInterleavedAllChannels<Simd128<uint8>>();
+  TestInterleavedAllChannels<Simd128<float>>();
+  TestInterleavedAllChannels<Simd64<int16>>();
+
+  auto rgb = load_interleaved<3, Simd64<uint8>>(
+      std::array<uint8, 24>{{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12,
+                             13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24}}
+          .data());
+  EXPECT_EQ(Simd64<uint8>::list(1, 4, 7, 10, 13, 16, 19, 22), rgb[0]);
+  EXPECT_EQ(Simd64<uint8>::list(2, 5, 8, 11, 14, 17, 20, 23), rgb[1]);
+  EXPECT_EQ(Simd64<uint8>::list(3, 6, 9, 12, 15, 18, 21, 24), rgb[2]);
+}
+
+template <typename SimdType>
+void TestTranspose() {
+  using T = typename SimdType::value_type;
+  constexpr size_t kSize = SimdType::size();
+  std::array<SimdType, kSize> rows;
+  for (size_t i = 0; i < kSize; i++) {
+    for (size_t j = 0; j < kSize; j++) {
+      rows[i].set(j, static_cast<T>(i * kSize + j));
+    }
+  }
+  transpose(rows);
+  for (size_t i = 0; i < kSize; i++) {
+    for (size_t j = 0; j < kSize; j++) {
+      EXPECT_EQ(static_cast<T>(j * kSize + i), rows[i][j]);
+    }
+  }
+}
+
+TEST(DimsumTest, Transpose) {
+  TestTranspose<NativeSimd<int8>>();
+  TestTranspose<NativeSimd<int16>>();
+  TestTranspose<NativeSimd<int32>>();
+  TestTranspose<NativeSimd<int64>>();
+  TestTranspose<NativeSimd<uint8>>();
+  TestTranspose<NativeSimd<uint16>>();
+  TestTranspose<NativeSimd<uint32>>();
+  TestTranspose<NativeSimd<uint64>>();
+  TestTranspose<NativeSimd<float>>();
+  TestTranspose<NativeSimd<double>>();
+  TestTranspose<Simd128<int8>>();
+  TestTranspose<Simd128<int16>>();
+  TestTranspose<Simd128<float>>();
+  TestTranspose<Simd64<uint8>>();
+
+  std::array<Simd128<int32>, 4> rows = {
+      {Simd128<int32>::list(1, 2, 3, 4), Simd128<int32>::list(5, 6, 7, 8),
+       Simd128<int32>::list(9, 10, 11, 12),
+       Simd128<int32>::list(13, 14, 15, 16)}};
+  transpose(rows);
+  EXPECT_EQ(Simd128<int32>::list(1, 5, 9, 13), rows[0]);
+  EXPECT_EQ(Simd128<int32>::list(2, 6, 10, 14), rows[1]);
+  EXPECT_EQ(Simd128<int32>::list(3, 7, 11, 15), rows[2]);
+  EXPECT_EQ(Simd128<int32>::list(4, 8, 12, 16), rows[3]);
+}
+
 template <typename SrcSimdType>
 void TestMulWidened() {
   using T = typename SrcSimdType::value_type;
@@ -1034,6 +1847,126 @@ TEST(DimsumTest, ReduceAdd) {
                                       Simd128<int32>::list(13, 14, 15, 16))));
 }
 
+template <typename SimdType>
+void TestCompress() {
+  using T = typename SimdType::value_type;
+  using Bits = typename SimdType::ComparisonResultType;
+  using MaskType = ChangeElemTo<SimdType, Bits>;
+  constexpr size_t size = SimdType::size();
+  SimdType simd([](int i) { return static_cast<T>(i + 1); });
+  // All masks for up to 8 lanes, a pseudo-random subset for more.
+  uint64 num_masks = size <= 8 ? 1u << size : 1000;
+  for (uint64 n = 0; n < num_masks; n++) {
+    uint64 bits = size <= 8 ? n : n * 0x9e3779b97f4a7c15ull >> (64 - size);
+    MaskType mask(
+        [bits](int i) { return static_cast<Bits>(-(bits >> i & 1)); });
+
+    SimdType compressed = compress(simd, mask);
+    SimdType expanded = expand(simd, mask);
+    T stored[size + 1];
+    std::fill(stored, stored + size + 1, T(-1));
+    size_t count = compress_store(stored, simd, mask);
+    ASSERT_EQ(__builtin_popcountll(bits), count) << bits;
+
+    size_t lo = 0;
+    size_t hi = count;
+    for (size_t i = 0; i < size; i++) {
+      if (bits >> i & 1) {
+        EXPECT_EQ(simd[i], stored[lo]) << bits;
+        EXPECT_EQ(simd[i], compressed[lo++]) << bits;
+        EXPECT_EQ(simd[lo - 1], expanded[i]) << bits;
+      } else {
+        EXPECT_EQ(simd[i], compressed[hi++]) << bits;
+        EXPECT_EQ(T(0), expanded[i]) << bits;
+      }
+    }
+    for (size_t i = count; i < size + 1; i++) {
+      EXPECT_EQ(T(-1), stored[i]) << bits;
+    }
+  }
+
+  // Only the most significant bit of each mask lane counts.
+  constexpr Bits kLow = std::numeric_limits<Bits>::max() >> 1;
+  MaskType mask([](int i) { return static_cast<Bits>(i % 2 ? ~kLow : kLow); });
+  SimdType expected([](int i) {
+    return static_cast<T>(i < size / 2 ? 2 * i + 2 : 2 * (i - size / 2) + 1);
+  });
+  EXPECT_EQ(expected, compress(simd, mask));
+}
+
+TEST(DimsumTest, Compress) {
+  TestCompress<NativeSimd<int8>>();
+  TestCompress<NativeSimd<int16>>();
+  TestCompress<NativeSimd<int32>>();
+  TestCompress<NativeSimd<int64>>();
+  TestCompress<NativeSimd<uint8>>();
+  TestCompress<NativeSimd<uint16>>();
+  TestCompress<NativeSimd<uint32>>();
+  TestCompress<NativeSimd<uint64>>();
+  TestCompress<NativeSimd<float>>();
+  TestCompress<NativeSimd<double>>();
+  TestCompress<Simd128<int16>>();
+  TestCompress<Simd128<uint32>>();
+  TestCompress<Simd128<uint64>>();
+  TestCompress<Simd64<int32>>();
+  TestCompress<ResizeBy<NativeSimd<int32>, 2>>();
+}
+
+template <typename SimdType>
+void TestBitCounting() {
+  using T = typename SimdType::value_type;
+  using Unsigned = typename std::make_unsigned<T>::type;
+  constexpr T kBits = sizeof(T) * CHAR_BIT;
+  // Lanes with no bits, all bits, single bits and mixed patterns.
+  SimdType simd([](int i) {
+    switch (i % 4) {
+      case 0:
+        return static_cast<T>(i % 8 == 0 ? 0 : -1);
+      case 1:
+        return static_cast<T>(Unsigned{1} << (i % kBits));
+      default:
+        return static_cast<T>(i * 0x9e3779b97f4a7c15ull >> (i % 16));
+    }
+  });
+  auto popcounts = popcount(simd);
+  auto leading = countl_zero(simd);
+  auto trailing = countr_zero(simd);
+  auto bytes = byte_reverse(simd);
+  auto bits = bit_reverse(simd);
+  for (size_t i = 0; i < simd.size(); i++) {
+    Unsigned x = simd[i];
+    Unsigned reversed_bytes = 0;
+    Unsigned reversed_bits = 0;
+    for (int j = 0; j < kBits; j++) {
+      reversed_bits |= static_cast<Unsigned>((x >> j) & 1) << (kBits - 1 - j);
+    }
+    for (int j = 0; j < kBits; j += CHAR_BIT) {
+      reversed_bytes |= static_cast<Unsigned>((x >> j) & 0xff)
+                        << (kBits - CHAR_BIT - j);
+    }
+    EXPECT_EQ(__builtin_popcountll(x), popcounts[i]) << i;
+    EXPECT_EQ(x == 0 ? kBits : __builtin_clzll(x) - (64 - kBits), leading[i])
+        << i;
+    EXPECT_EQ(x == 0 ? kBits : __builtin_ctzll(x), trailing[i]) << i;
+    EXPECT_EQ(static_cast<T>(reversed_bytes), bytes[i]) << i;
+    EXPECT_EQ(static_cast<T>(reversed_bits), bits[i]) << i;
+  }
+}
+
+TEST(DimsumTest, BitCounting) {
+  TestBitCounting<NativeSimd<int8>>();
+  TestBitCounting<NativeSimd<int16>>();
+  TestBitCounting<NativeSimd<int32>>();
+  TestBitCounting<NativeSimd<int64>>();
+  TestBitCounting<NativeSimd<uint8>>();
+  TestBitCounting<NativeSimd<uint16>>();
+  TestBitCounting<NativeSimd<uint32>>();
+  TestBitCounting<NativeSimd<uint64>>();
+  TestBitCounting<Simd128<uint32>>();
+  TestBitCounting<Simd64<uint16>>();
+  TestBitCounting<ResizeBy<NativeSimd<uint64>, 2>>();
+}
+
 #undef SIMD_BINARY_OP_ASSIGN_TEST
 #undef SIMD_BINARY_OP_TEST
 #undef SIMD_BINARY_FUNC_TEST
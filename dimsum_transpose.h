@@ -0,0 +1,123 @@
+/*
+ * Copyright 2017 Google Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DIMSUM_DIMSUM_TRANSPOSE_H_
+#define DIMSUM_DIMSUM_TRANSPOSE_H_
+
+#include <algorithm>
+
+#include "dimsum.h"
+
+// Transposition of row-major matrices in memory.
+//
+// The matrix is split in half along its longer side, recursively, until a
+// block fits in L1. This keeps both the reads and the writes cache friendly at
+// every level of the hierarchy without tuning for a particular cache size.
+// Each leaf block is transposed in square tiles, one row of a tile per vector
+// register, with the in-register transpose() from simd.h. Elements outside
+// whole tiles are copied one at a time.
+
+namespace dimsum {
+namespace detail {
+
+// Leaves are no larger than this, so that a leaf of the source and its
+// transpose both stay in a 32 KiB L1.
+constexpr size_t kTransposeLeafBytes = 8 * 1024;
+
+// Narrow elements use 128-bit tiles. Wider tiles would need more registers
+// than the machine has, and AVX2 can't zip across its 128-bit lanes cheaply.
+template <typename T>
+using TransposeTileSimd =
+    ResizeTo<NativeSimd<T>, (sizeof(T) >= 4 ? NativeSimd<T>::size()
+                                            : 16 / sizeof(T))>;
+
+template <typename T, size_t... rows>
+void TransposeTile(const T* src, size_t src_stride, T* dst, size_t dst_stride,
+                   dimsum::index_sequence<rows...>) {
+  using SimdType = TransposeTileSimd<T>;
+  std::array<SimdType, sizeof...(rows)> tile = {
+      {SimdType(src + rows * src_stride, flags::element_aligned)...}};
+  transpose(tile);
+  int expand[] = {
+      (tile[rows].memstore(dst + rows * dst_stride, flags::element_aligned),
+       0)...};
+  (void)expand;
+}
+
+template <typename T>
+void TransposeLeaf(size_t rows, size_t cols, const T* src, size_t src_stride,
+                   T* dst, size_t dst_stride) {
+  constexpr size_t kTile = TransposeTileSimd<T>::size();
+  const size_t tiled_rows = rows / kTile * kTile;
+  const size_t tiled_cols = cols / kTile * kTile;
+  for (size_t i = 0; i < tiled_rows; i += kTile) {
+    for (size_t j = 0; j < tiled_cols; j += kTile) {
+      TransposeTile(src + i * src_stride + j, src_stride,
+                    dst + j * dst_stride + i, dst_stride,
+                    dimsum::make_index_sequence<kTile>{});
+    }
+    for (size_t j = tiled_cols; j < cols; j++) {
+      for (size_t k = i; k < i + kTile; k++) {
+        dst[j * dst_stride + k] = src[k * src_stride + j];
+      }
+    }
+  }
+  for (size_t i = tiled_rows; i < rows; i++) {
+    for (size_t j = 0; j < cols; j++) {
+      dst[j * dst_stride + i] = src[i * src_stride + j];
+    }
+  }
+}
+
+template <typename T>
+void TransposeRecursive(size_t rows, size_t cols, const T* src,
+                        size_t src_stride, T* dst, size_t dst_stride) {
+  constexpr size_t kTile = TransposeTileSimd<T>::size();
+  if (rows * cols * sizeof(T) <= kTransposeLeafBytes ||
+      (rows <= kTile && cols <= kTile)) {
+    TransposeLeaf(rows, cols, src, src_stride, dst, dst_stride);
+    return;
+  }
+  // Splits on a tile boundary, so that only the edges of the whole matrix
+  // are transposed one element at a time.
+  const size_t longer = std::max(rows, cols);
+  size_t half = (longer / 2 + kTile - 1) / kTile * kTile;
+  if (half >= longer) half = longer / 2;
+  if (rows >= cols) {
+    TransposeRecursive(half, cols, src, src_stride, dst, dst_stride);
+    TransposeRecursive(rows - half, cols, src + half * src_stride, src_stride,
+                       dst + half, dst_stride);
+  } else {
+    TransposeRecursive(rows, half, src, src_stride, dst, dst_stride);
+    TransposeRecursive(rows, cols - half, src + half, src_stride,
+                       dst + half * dst_stride, dst_stride);
+  }
+}
+
+}  // namespace detail
+
+// Writes the transpose of the rows x cols matrix `src` to the cols x rows
+// matrix `dst`: dst[j * dst_stride + i] = src[i * src_stride + j]. Strides are
+// in elements. src and dst must not overlap.
+template <typename T>
+void transpose(size_t rows, size_t cols, const T* src, size_t src_stride,
+               T* dst, size_t dst_stride) {
+  detail::TransposeRecursive(rows, cols, src, src_stride, dst, dst_stride);
+}
+
+}  // namespace dimsum
+
+#endif  // DIMSUM_DIMSUM_TRANSPOSE_H_
@@ -0,0 +1,77 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "dimsum_transpose.h"
+
+namespace dimsum {
+namespace {
+
+// The argument is the number of rows and columns of a square matrix.
+template <typename T>
+std::vector<T> MakeMatrix(size_t size) {
+  std::vector<T> matrix(size * size);
+  for (size_t i = 0; i < matrix.size(); i++) {
+    matrix[i] = static_cast<T>(i);
+  }
+  return matrix;
+}
+
+template <typename T>
+void BM_TransposeNaive(benchmark::State& state) {
+  const size_t size = state.range(0);
+  auto src = MakeMatrix<T>(size);
+  std::vector<T> dst(size * size);
+  for (auto _ : state) {
+    for (size_t i = 0; i < size; i++) {
+      for (size_t j = 0; j < size; j++) {
+        dst[j * size + i] = src[i * size + j];
+      }
+    }
+    benchmark::DoNotOptimize(dst.data());
+  }
+  state.SetBytesProcessed(state.iterations() * size * size * sizeof(T));
+}
+
+template <typename T>
+void BM_Transpose(benchmark::State& state) {
+  const size_t size = state.range(0);
+  auto src = MakeMatrix<T>(size);
+  std::vector<T> dst(size * size);
+  for (auto _ : state) {
+    transpose(size, size, src.data(), size, dst.data(), size);
+    benchmark::DoNotOptimize(dst.data());
+  }
+  state.SetBytesProcessed(state.iterations() * size * size * sizeof(T));
+}
+
+// Powers of two are the worst case for the naive version, whose column
+// writes then all map to the same cache sets.
+void TransposeSizes(benchmark::internal::Benchmark* b) {
+  b->Arg(64)->Arg(256)->Arg(1000)->Arg(1024)->Arg(4096);
+}
+
+BENCHMARK_TEMPLATE(BM_TransposeNaive, uint8)->Apply(TransposeSizes);
+BENCHMARK_TEMPLATE(BM_Transpose, uint8)->Apply(TransposeSizes);
+BENCHMARK_TEMPLATE(BM_TransposeNaive, uint16)->Apply(TransposeSizes);
+BENCHMARK_TEMPLATE(BM_Transpose, uint16)->Apply(TransposeSizes);
+BENCHMARK_TEMPLATE(BM_TransposeNaive, float)->Apply(TransposeSizes);
+BENCHMARK_TEMPLATE(BM_Transpose, float)->Apply(TransposeSizes);
+BENCHMARK_TEMPLATE(BM_TransposeNaive, double)->Apply(TransposeSizes);
+BENCHMARK_TEMPLATE(BM_Transpose, double)->Apply(TransposeSizes);
+
+}  // namespace
+}  // namespace dimsum
@@ -0,0 +1,69 @@
+// Copyright 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dimsum_transpose.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace dimsum {
+namespace {
+
+// The destination is padded to dst_stride = rows + 3, and filled with a
+// sentinel to catch writes outside the transposed matrix.
+template <typename T>
+void TestTranspose(size_t rows, size_t cols) {
+  const size_t src_stride = cols + 1;
+  const size_t dst_stride = rows + 3;
+  const T kSentinel = static_cast<T>(99);
+  std::vector<T> src(rows * src_stride);
+  for (size_t i = 0; i < src.size(); i++) {
+    src[i] = static_cast<T>(i % 97);
+  }
+  std::vector<T> dst(cols * dst_stride, kSentinel);
+  transpose(rows, cols, src.data(), src_stride, dst.data(), dst_stride);
+  for (size_t j = 0; j < cols; j++) {
+    for (size_t i = 0; i < dst_stride; i++) {
+      T expected = i < rows ? src[i * src_stride + j] : kSentinel;
+      ASSERT_EQ(expected, dst[j * dst_stride + i])
+          << rows << "x" << cols << " at " << j << ", " << i;
+    }
+  }
+}
+
+template <typename T>
+void TestTransposeShapes() {
+  const size_t sizes[] = {1, 3, 8, 16, 17, 33, 64, 100, 257};
+  for (size_t rows : sizes) {
+    for (size_t cols : sizes) {
+      TestTranspose<T>(rows, cols);
+    }
+  }
+  TestTranspose<T>(1000, 31);
+  TestTranspose<T>(31, 1000);
+}
+
+TEST(TransposeTest, Int8) { TestTransposeShapes<int8>(); }
+
+TEST(TransposeTest, Uint16) { TestTransposeShapes<uint16>(); }
+
+TEST(TransposeTest, Int32) { TestTransposeShapes<int32>(); }
+
+TEST(TransposeTest, Float) { TestTransposeShapes<float>(); }
+
+TEST(TransposeTest, Double) { TestTransposeShapes<double>(); }
+
+}  // namespace
+}  // namespace dimsum
@@ -43,15 +43,159 @@ namespace dimsum {
 template <typename T, typename Abi>
 class Simd;
 
+// IEEE 754 binary16. It is a storage-only type: Simd objects of float16 can be
+// loaded, stored, shuffled and converted to and from other element types with
+// static_simd_cast. Arithmetic and comparisons on them do not compile; convert
+// to float to compute.
+//
+// Conversions from float round to nearest even. NaNs stay NaNs (quieted, with
+// the payload truncated), and values too large for float16 become infinities.
+class float16 {
+ public:
+  float16() = default;
+
+  explicit float16(float value) : bits_(FromFloat(value)) {}
+
+  operator float() const {  // NOLINT
+    // Renormalizes subnormals by subtracting 2^-14 after forcing a leading 1,
+    // and moves the exponent of infinities and NaNs to the float maximum.
+    uint32 bits = static_cast<uint32>(bits_ & 0x7fff) << 13;
+    const uint32 exponent = bits & 0x0f800000;
+    bits += (127 - 15) << 23;
+    if (exponent == 0x0f800000) {
+      bits += (128 - 16) << 23;
+      if (bits & 0x007fffff) bits |= 0x00400000;
+    } else if (exponent == 0) {
+      bits += 1 << 23;
+      float value;
+      memcpy(&value, &bits, sizeof(value));
+      value -= 6.103515625e-05f;
+      memcpy(&bits, &value, sizeof(bits));
+    }
+    bits |= static_cast<uint32>(bits_ & 0x8000) << 16;
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  static float16 from_bits(uint16 bits) {
+    float16 ret;
+    ret.bits_ = bits;
+    return ret;
+  }
+
+  uint16 bits() const { return bits_; }
+
+ private:
+  static uint16 FromFloat(float value) {
+    uint32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint32 sign = (bits >> 16) & 0x8000;
+    bits &= 0x7fffffff;
+    uint32 ret;
+    if (bits >= 0x47800000) {
+      // Infinity for overflows, a quiet NaN for NaNs.
+      ret = bits > 0x7f800000 ? 0x7e00 | ((bits >> 13) & 0x3ff) : 0x7c00;
+    } else if (bits < 0x38800000) {
+      // The result is subnormal. Adding 0.5 aligns the float mantissa so that
+      // the FPU rounds it to the 10-bit subnormal mantissa.
+      float magnitude;
+      memcpy(&magnitude, &bits, sizeof(magnitude));
+      magnitude += 0.5f;
+      memcpy(&ret, &magnitude, sizeof(ret));
+      ret -= 0x3f000000;
+    } else {
+      // Rebias the exponent and round the mantissa to nearest even. A carry
+      // out of the mantissa correctly bumps the exponent, up to infinity.
+      bits -= (127 - 15) << 23;
+      bits += 0xfff + ((bits >> 13) & 1);
+      ret = bits >> 13;
+    }
+    return static_cast<uint16>(ret | sign);
+  }
+
+  uint16 bits_;
+};
+
+// bfloat16: the upper 16 bits of an IEEE 754 binary32. It is a storage-only
+// type like float16.
+//
+// Conversions from float round to nearest even, and NaNs stay quiet NaNs.
+class bfloat16 {
+ public:
+  bfloat16() = default;
+
+  explicit bfloat16(float value) : bits_(FromFloat(value)) {}
+
+  operator float() const {  // NOLINT
+    uint32 bits = static_cast<uint32>(bits_) << 16;
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  static bfloat16 from_bits(uint16 bits) {
+    bfloat16 ret;
+    ret.bits_ = bits;
+    return ret;
+  }
+
+  uint16 bits() const { return bits_; }
+
+ private:
+  static uint16 FromFloat(float value) {
+    uint32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    if ((bits & 0x7fffffff) > 0x7f800000) {
+      return static_cast<uint16>((bits | 0x00400000) >> 16);
+    }
+    return static_cast<uint16>((bits + 0x7fff + ((bits >> 16) & 1)) >> 16);
+  }
+
+  uint16 bits_;
+};
+
 namespace detail {
 
+// LaneTraits maps an element type to the arithmetic type that it is stored as
+// in GCC vectors, and converts between the two. Storage-only types are stored
+// as their bit patterns.
+template <typename T>
+struct LaneTraits {
+  using type = T;
+  static T FromLane(T lane) { return lane; }
+  static T ToLane(T value) { return value; }
+};
+
+template <>
+struct LaneTraits<float16> {
+  using type = uint16;
+  static float16 FromLane(uint16 lane) { return float16::from_bits(lane); }
+  static uint16 ToLane(float16 value) { return value.bits(); }
+};
+
+template <>
+struct LaneTraits<bfloat16> {
+  using type = uint16;
+  static bfloat16 FromLane(uint16 lane) { return bfloat16::from_bits(lane); }
+  static uint16 ToLane(bfloat16 value) { return value.bits(); }
+};
+
+// Returns whether the lanes of T hold bit patterns, which arithmetic and
+// comparisons would not treat as numbers.
+template <typename T>
+constexpr bool IsStorageOnly() {
+  return !std::is_same<typename LaneTraits<T>::type, T>::value;
+}
+
 template <typename T, size_t num_bytes>
 struct GccVecTraits {};
 
-#define GCC_VEC_SPECIALIZATION(T, NUM_BYTES)                \
-  template <>                                               \
-  struct GccVecTraits<T, NUM_BYTES> {                       \
-    using type = T __attribute__((vector_size(NUM_BYTES))); \
+#define GCC_VEC_SPECIALIZATION(T, NUM_BYTES)                         \
+  template <>                                                        \
+  struct GccVecTraits<T, NUM_BYTES> {                                \
+    using type =                                                     \
+        LaneTraits<T>::type __attribute__((vector_size(NUM_BYTES))); \
   }
 #define GCC_VEC_SPECIALIZE_ON_NUM_BYTES(NUM_BYTES) \
   GCC_VEC_SPECIALIZATION(uint8, NUM_BYTES);        \
@@ -62,6 +206,8 @@ struct GccVecTraits {};
   GCC_VEC_SPECIALIZATION(int16, NUM_BYTES);        \
   GCC_VEC_SPECIALIZATION(int32, NUM_BYTES);        \
   GCC_VEC_SPECIALIZATION(int64, NUM_BYTES);        \
+  GCC_VEC_SPECIALIZATION(float16, NUM_BYTES);      \
+  GCC_VEC_SPECIALIZATION(bfloat16, NUM_BYTES);     \
   GCC_VEC_SPECIALIZATION(float, NUM_BYTES);        \
   GCC_VEC_SPECIALIZATION(double, NUM_BYTES)
 
@@ -78,12 +224,16 @@ GCC_VEC_SPECIALIZATION(uint32, 4);
 GCC_VEC_SPECIALIZATION(int8, 4);
 GCC_VEC_SPECIALIZATION(int16, 4);
 GCC_VEC_SPECIALIZATION(int32, 4);
+GCC_VEC_SPECIALIZATION(float16, 4);
+GCC_VEC_SPECIALIZATION(bfloat16, 4);
 GCC_VEC_SPECIALIZATION(float, 4);
 
 GCC_VEC_SPECIALIZATION(uint8, 2);
 GCC_VEC_SPECIALIZATION(uint16, 2);
 GCC_VEC_SPECIALIZATION(int8, 2);
 GCC_VEC_SPECIALIZATION(int16, 2);
+GCC_VEC_SPECIALIZATION(float16, 2);
+GCC_VEC_SPECIALIZATION(bfloat16, 2);
 
 GCC_VEC_SPECIALIZATION(uint8, 1);
 GCC_VEC_SPECIALIZATION(int8, 1);
@@ -99,6 +249,7 @@ enum class NumberKind {
   kUInt,
   kSInt,
   kFloat,
+  kBFloat,
 };
 
 // NumberTraits maps (width, kind) to a primitive integer type.
@@ -138,6 +289,10 @@ struct NumberTraits<8, NumberKind::kUInt> {
   using type = uint64;
 };
 template <>
+struct NumberTraits<2, NumberKind::kFloat> {
+  using type = float16;
+};
+template <>
 struct NumberTraits<4, NumberKind::kFloat> {
   using type = float;
 };
@@ -145,6 +300,10 @@ template <>
 struct NumberTraits<8, NumberKind::kFloat> {
   using type = double;
 };
+template <>
+struct NumberTraits<2, NumberKind::kBFloat> {
+  using type = bfloat16;
+};
 
 template <size_t width, NumberKind kind>
 using Number = typename NumberTraits<width, kind>::type;
@@ -160,12 +319,17 @@ static constexpr size_t kMachineWidth =
 // Returns the NumberKind of T.
 template <typename T>
 constexpr NumberKind get_number_kind() {
-  static_assert(std::is_integral<T>::value || std::is_floating_point<T>::value,
+  static_assert(std::is_integral<T>::value ||
+                    std::is_floating_point<T>::value ||
+                    std::is_same<T, float16>::value ||
+                    std::is_same<T, bfloat16>::value,
                 "Unexpected type");
-  return std::is_signed<T>::value
-             ? NumberKind::kSInt
-             : (std::is_unsigned<T>::value ? NumberKind::kUInt
-                                           : NumberKind::kFloat);
+  return std::is_same<T, bfloat16>::value
+             ? NumberKind::kBFloat
+             : (std::is_signed<T>::value
+                    ? NumberKind::kSInt
+                    : (std::is_unsigned<T>::value ? NumberKind::kUInt
+                                                  : NumberKind::kFloat));
 }
 
 // Returns a DestType with the value clamped into its representable range.
@@ -178,6 +342,41 @@ DestType saturated_convert(SrcType val) {
                     : static_cast<DestType>(val));
 }
 
+// Returns the smallest Src value that converts to Dest without saturating.
+template <typename Dest, typename Src>
+constexpr Src SaturationLowerBound() {
+  return std::is_unsigned<Src>::value || std::is_unsigned<Dest>::value
+             ? Src{0}
+             : (std::is_floating_point<Src>::value || sizeof(Dest) < sizeof(Src)
+                    ? static_cast<Src>(std::numeric_limits<Dest>::min())
+                    : std::numeric_limits<Src>::lowest());
+}
+
+// Returns the number of low bits of Dest's maximum that Src can't represent.
+template <typename Dest, typename Src>
+constexpr int SaturationPrecisionLoss() {
+  return std::numeric_limits<Dest>::digits > std::numeric_limits<Src>::digits
+             ? std::numeric_limits<Dest>::digits -
+                   std::numeric_limits<Src>::digits
+             : 0;
+}
+
+// Returns the largest Src value that converts to Dest without saturating. For
+// a floating point Src it is the maximum of Dest rounded down to the precision
+// of Src, e.g. 2^31 - 128 for float and int32.
+template <typename Dest, typename Src>
+constexpr Src SaturationUpperBound() {
+  return std::is_floating_point<Src>::value
+             ? static_cast<Src>(
+                   static_cast<uint64>(std::numeric_limits<Dest>::max()) >>
+                   SaturationPrecisionLoss<Dest, Src>()
+                       << SaturationPrecisionLoss<Dest, Src>())
+             : (std::numeric_limits<Dest>::digits <
+                        std::numeric_limits<Src>::digits
+                    ? static_cast<Src>(std::numeric_limits<Dest>::max())
+                    : std::numeric_limits<Src>::max());
+}
+
 enum class StoragePolicy {
   kSimulated,
   kXmm,
@@ -218,6 +417,15 @@ struct RebindTraits<Simd<T, Abi<kStorage, kNumBytes>>, NewElementType,
 template <typename T, typename Abi, typename Flags>
 struct LoadImpl;
 
+template <typename T, typename Abi, typename Flags>
+struct StoreImpl;
+
+template <typename DestSimd, typename SrcSimd>
+struct GccShuffleImpl;
+
+template <typename Dest, typename Src>
+struct StaticSimdCastImpl;
+
 template <typename To, typename From>
 constexpr auto IsNarrowingConversionImpl(From a[[gnu::unused]])
     -> decltype(To{a}, false) {
@@ -248,8 +456,44 @@ struct vector_aligned_tag {};
 
 constexpr vector_aligned_tag vector_aligned{};
 
+// Stores that bypass the caches (movntdq on x86), for output that is not read
+// again soon, e.g. a pass over buffers larger than the last level cache. The
+// buffer must be aligned as for vector_aligned. Streaming stores are weakly
+// ordered, so call streaming_fence() before other threads read the output.
+struct streaming_tag {};
+
+constexpr streaming_tag streaming{};
+
+// Loads with movntdqa on x86. Only write-combining memory, e.g. a mapped
+// device buffer, is read around the caches; x86 cores treat it as an aligned
+// load from ordinary memory. The buffer must be aligned as for vector_aligned.
+struct streaming_load_tag {};
+
+constexpr streaming_load_tag streaming_load{};
+
 }  // namespace flags
 
+// Orders all earlier streaming stores before any later store, e.g. the one
+// that tells another thread that the output is ready.
+inline void streaming_fence() {
+#ifdef __SSE2__
+  __builtin_ia32_sfence();
+#else
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+#endif
+}
+
+// Fetches the cache line at `ptr` ahead of a read. kLocality ranges from 0,
+// for data that is read once and should evict little else (prefetchnta on
+// x86), to 3, for data that should be kept in all cache levels (prefetcht0).
+// Sequential passes rarely need it, as the hardware prefetches those.
+template <int kLocality = 3>
+inline void prefetch(const void* ptr) {
+  static_assert(0 <= kLocality && kLocality <= 3,
+                "Locality should be in [0, 3]");
+  __builtin_prefetch(ptr, 0, kLocality);
+}
+
 // Returns a Simd type that's based on SimdType, but with a different size.
 template <typename SimdType, size_t kNewSize>
 using ResizeTo =
@@ -366,13 +610,22 @@ class Simd<T, detail::Abi<kStorage, kNumBytes>> {
 
   // Constructs a Simd object, using a single value for all elements.
   Simd(T value) {  // NOLINT
-    for (int i = 0; i < size(); i++) {
-      storage_[i] = value;
+    const auto lane = detail::LaneTraits<T>::ToLane(value);
+    if (std::is_integral<decltype(lane)>::value) {
+      // A scalar operand is splatted into a register, while GCC lowers the
+      // loop below for narrow lanes to partial stores and a reload.
+      storage_ = lane + typename Traits::InternalType{};
+    } else {
+      for (int i = 0; i < size(); i++) {
+        storage_[i] = lane;
+      }
     }
   }
 
   // Returns the ith element.
-  value_type operator[](size_t i) const { return storage_[i]; }
+  value_type operator[](size_t i) const {
+    return detail::LaneTraits<T>::FromLane(storage_[i]);
+  }
 
   // Changes the current object to Simd(buffer).
   template <typename Flags>
@@ -384,16 +637,14 @@ class Simd<T, detail::Abi<kStorage, kNumBytes>> {
   // Stores the Simd object to the buffer.
   template <typename Flags>
   void memstore(T* buffer, Flags) const {
-    constexpr size_t bytes = sizeof(storage_);
-    if (std::is_same<Flags, flags::vector_aligned_tag>::value) {
-      memcpy(__builtin_assume_aligned(buffer, bytes), &storage_, bytes);
-    } else {
-      memcpy(buffer, &storage_, bytes);
-    }
+    detail::StoreImpl<T, detail::Abi<kStorage, kNumBytes>, Flags>::Apply(
+        *this, buffer);
   }
 
   // Sets the ith element.
-  void set(size_t i, T value) { storage_[i] = value; }
+  void set(size_t i, T value) {
+    storage_[i] = detail::LaneTraits<T>::ToLane(value);
+  }
 
   template <typename Tp, typename Ap>
   friend class Simd;
@@ -401,6 +652,12 @@ class Simd<T, detail::Abi<kStorage, kNumBytes>> {
   template <typename Tp, typename Abi, typename Flags>
   friend struct detail::LoadImpl;
 
+  template <typename Tp, typename Abi, typename Flags>
+  friend struct detail::StoreImpl;
+
+  template <typename DestSimd, typename SrcSimd>
+  friend struct detail::GccShuffleImpl;
+
   template <size_t... indices, typename Tp, typename Ap>
   friend ResizeTo<Simd<Tp, Ap>, sizeof...(indices)> shuffle(Simd<Tp, Ap> lhs,
                                                             Simd<Tp, Ap> rhs);
@@ -420,6 +677,9 @@ class Simd<T, detail::Abi<kStorage, kNumBytes>> {
   template <typename Tp, typename Ap>
   friend Simd<Tp, Ap> mul(Simd<Tp, Ap> lhs, Simd<Tp, Ap> rhs);
 
+  template <typename Tp, typename Ap>
+  friend Simd<Tp, Ap> fma(Simd<Tp, Ap> lhs, Simd<Tp, Ap> rhs, Simd<Tp, Ap> acc);
+
   template <typename Tp, typename Ap>
   friend Simd<Tp, Ap> shl_simd(Simd<Tp, Ap> simd, Simd<Tp, Ap> count);
 
@@ -480,8 +740,8 @@ class Simd<T, detail::Abi<kStorage, kNumBytes>> {
   template <typename Dp, typename Tp, typename Ap>
   friend Simd<Dp, Ap> bit_cast(Simd<Tp, Ap> simd);
 
-  template <typename Dp, typename Sp, typename Ap>
-  friend ChangeElemTo<Simd<Sp, Ap>, Dp> static_simd_cast(Simd<Sp, Ap> simd);
+  template <typename Dp, typename Sp>
+  friend struct detail::StaticSimdCastImpl;
 
  private:
   static Simd from_storage(typename Traits::InternalType storage) {
@@ -591,18 +851,45 @@ ResizeTo<Simd<T, SrcAbi>, sizeof...(indices)> shuffle(
   return DestSimd::from_storage(
       __builtin_shufflevector(lhs.storage_, rhs.storage_, indices...));
 #else
-  // TODO(dimsum): GCC intrinsic doesn't support when sizeof...(indices) !=
-  // lhs.size(), so we have to simulate it. Still, we can invoke the intrinsic
-  // __builtin_shuffle when the input/output sizes are the same.
-  T a[sizeof...(indices)];
-  int i = 0;
-  for (auto index : {indices...}) {
-    a[i++] = index < lhs.size() ? lhs[index] : rhs[index - lhs.size()];
-  }
-  return DestSimd(a, flags::element_aligned);
+  return detail::GccShuffleImpl<DestSimd, Simd<T, SrcAbi>>::template Apply<
+      indices...>(lhs, rhs);
 #endif
 }
 
+#if !defined(__clang__)
+namespace detail {
+
+// GCC intrinsic doesn't support when sizeof...(indices) != lhs.size(), so we
+// have to simulate it.
+template <typename DestSimd, typename SrcSimd>
+struct GccShuffleImpl {
+  template <size_t... indices>
+  static DestSimd Apply(SrcSimd lhs, SrcSimd rhs) {
+    typename DestSimd::value_type a[sizeof...(indices)];
+    int i = 0;
+    for (auto index : {indices...}) {
+      a[i++] = index < lhs.size() ? lhs[index] : rhs[index - lhs.size()];
+    }
+    return DestSimd(a, flags::element_aligned);
+  }
+};
+
+// When the input/output sizes are the same, we invoke __builtin_shuffle.
+template <typename SimdType>
+struct GccShuffleImpl<SimdType, SimdType> {
+  template <size_t... indices>
+  static SimdType Apply(SimdType lhs, SimdType rhs) {
+    using T = typename SimdType::value_type;
+    using Mask = typename GccVecTraits<Number<sizeof(T), NumberKind::kSInt>,
+                                       sizeof(lhs.storage_)>::type;
+    return SimdType::from_storage(
+        __builtin_shuffle(lhs.storage_, rhs.storage_, Mask{indices...}));
+  }
+};
+
+}  // namespace detail
+#endif  // !defined(__clang__)
+
 namespace detail {
 
 template <size_t... indices, typename T, typename Abi>
@@ -633,6 +920,8 @@ Simd<T, Abi> abs(Simd<T, Abi> simd) {
 // The behavior of overflow is undefined.
 template <typename Tp, typename Abi>
 Simd<Tp, Abi> add(Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs) {
+  static_assert(!detail::IsStorageOnly<Tp>(),
+                "Storage-only types should be converted to float first");
   return Simd<Tp, Abi>::from_storage(lhs.storage_ + rhs.storage_);
 }
 
@@ -644,6 +933,8 @@ Simd<Tp, Abi> add_saturated(Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs);
 // The behavior of overflow is undefined.
 template <typename Tp, typename Abi>
 Simd<Tp, Abi> sub(Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs) {
+  static_assert(!detail::IsStorageOnly<Tp>(),
+                "Storage-only types should be converted to float first");
   return Simd<Tp, Abi>::from_storage(lhs.storage_ - rhs.storage_);
 }
 
@@ -655,9 +946,22 @@ Simd<Tp, Abi> sub_saturated(Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs);
 // The behavior of overflow is undefined.
 template <typename Tp, typename Abi>
 Simd<Tp, Abi> mul(Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs) {
+  static_assert(!detail::IsStorageOnly<Tp>(),
+                "Storage-only types should be converted to float first");
   return Simd<Tp, Abi>::from_storage(lhs.storage_ * rhs.storage_);
 }
 
+// Returns lhs * rhs + acc element-wise. For floating point types, backends
+// with fused multiply-add instructions (x86 FMA, ARM, VSX) round only once;
+// others round the product as well.
+template <typename Tp, typename Abi>
+Simd<Tp, Abi> fma(Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs, Simd<Tp, Abi> acc) {
+  static_assert(!detail::IsStorageOnly<Tp>(),
+                "Storage-only types should be converted to float first");
+  return Simd<Tp, Abi>::from_storage(lhs.storage_ * rhs.storage_ +
+                                     acc.storage_);
+}
+
 // Left shifts each lane by the number of bits specified in count.
 // If count is negative or greater than or equal to the number of bits,
 // the result is undefined.
@@ -668,14 +972,17 @@ Simd<Tp, Abi> shl_simd(Simd<Tp, Abi> simd, Simd<Tp, Abi> count) {
   return Simd<Tp, Abi>::from_storage(simd.storage_ << count.storage_);
 }
 
-// Returns shl_simd(Simd(count)).
+// Returns shl_simd(simd, Simd(count)). Shifting all lanes by the same count
+// is native on every backend, even where per-lane counts are emulated.
 template <typename Tp, typename Abi>
 Simd<Tp, Abi> shl(Simd<Tp, Abi> simd, int count) {
-  return shl_simd(simd, Simd<Tp, Abi>(count));
+  static_assert(std::is_integral<Tp>::value,
+                "Only integral types are supported");
+  return Simd<Tp, Abi>::from_storage(simd.storage_ << count);
 }
 
 // Right shifts each lane by the number of bits specified in count.
-// If the left operand is negative or greater than or equal to the number of
+// If count is negative or greater than or equal to the number of
 // bits, the result is undefined.
 template <typename Tp, typename Abi>
 Simd<Tp, Abi> shr_simd(Simd<Tp, Abi> simd, Simd<Tp, Abi> count) {
@@ -684,10 +991,12 @@ Simd<Tp, Abi> shr_simd(Simd<Tp, Abi> simd, Simd<Tp, Abi> count) {
   return Simd<Tp, Abi>::from_storage(simd.storage_ >> count.storage_);
 }
 
-// Returns shr_simd(Simd(count)).
+// Returns shr_simd(simd, Simd(count)), see shl.
 template <typename Tp, typename Abi>
 Simd<Tp, Abi> shr(Simd<Tp, Abi> simd, int count) {
-  return shr_simd(simd, Simd<Tp, Abi>(count));
+  static_assert(std::is_integral<Tp>::value,
+                "Only integral types are supported");
+  return Simd<Tp, Abi>::from_storage(simd.storage_ >> count);
 }
 
 // Returns the element-wise comparison result.
@@ -705,6 +1014,8 @@ Simd<Tp, Abi> shr(Simd<Tp, Abi> simd, int count) {
 template <typename Tp, typename Abi>
 Simd<typename Simd<Tp, Abi>::ComparisonResultType, Abi> cmp_eq(
     Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs) {
+  static_assert(!detail::IsStorageOnly<Tp>(),
+                "Storage-only types should be converted to float first");
   return Simd<typename Simd<Tp, Abi>::ComparisonResultType, Abi>::from_storage(
       lhs.storage_ == rhs.storage_);
 }
@@ -712,6 +1023,8 @@ Simd<typename Simd<Tp, Abi>::ComparisonResultType, Abi> cmp_eq(
 template <typename Tp, typename Abi>
 Simd<typename Simd<Tp, Abi>::ComparisonResultType, Abi> cmp_ne(
     Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs) {
+  static_assert(!detail::IsStorageOnly<Tp>(),
+                "Storage-only types should be converted to float first");
   return Simd<typename Simd<Tp, Abi>::ComparisonResultType, Abi>::from_storage(
       lhs.storage_ != rhs.storage_);
 }
@@ -719,6 +1032,8 @@ Simd<typename Simd<Tp, Abi>::ComparisonResultType, Abi> cmp_ne(
 template <typename Tp, typename Abi>
 Simd<typename Simd<Tp, Abi>::ComparisonResultType, Abi> cmp_lt(
     Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs) {
+  static_assert(!detail::IsStorageOnly<Tp>(),
+                "Storage-only types should be converted to float first");
   return Simd<typename Simd<Tp, Abi>::ComparisonResultType, Abi>::from_storage(
       lhs.storage_ < rhs.storage_);
 }
@@ -726,6 +1041,8 @@ Simd<typename Simd<Tp, Abi>::ComparisonResultType, Abi> cmp_lt(
 template <typename Tp, typename Abi>
 Simd<typename Simd<Tp, Abi>::ComparisonResultType, Abi> cmp_le(
     Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs) {
+  static_assert(!detail::IsStorageOnly<Tp>(),
+                "Storage-only types should be converted to float first");
   return Simd<typename Simd<Tp, Abi>::ComparisonResultType, Abi>::from_storage(
       lhs.storage_ <= rhs.storage_);
 }
@@ -733,6 +1050,8 @@ Simd<typename Simd<Tp, Abi>::ComparisonResultType, Abi> cmp_le(
 template <typename Tp, typename Abi>
 Simd<typename Simd<Tp, Abi>::ComparisonResultType, Abi> cmp_gt(
     Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs) {
+  static_assert(!detail::IsStorageOnly<Tp>(),
+                "Storage-only types should be converted to float first");
   return Simd<typename Simd<Tp, Abi>::ComparisonResultType, Abi>::from_storage(
       lhs.storage_ > rhs.storage_);
 }
@@ -740,6 +1059,8 @@ Simd<typename Simd<Tp, Abi>::ComparisonResultType, Abi> cmp_gt(
 template <typename Tp, typename Abi>
 Simd<typename Simd<Tp, Abi>::ComparisonResultType, Abi> cmp_ge(
     Simd<Tp, Abi> lhs, Simd<Tp, Abi> rhs) {
+  static_assert(!detail::IsStorageOnly<Tp>(),
+                "Storage-only types should be converted to float first");
   return Simd<typename Simd<Tp, Abi>::ComparisonResultType, Abi>::from_storage(
       lhs.storage_ >= rhs.storage_);
 }
@@ -754,6 +1075,326 @@ ResizeBy<Simd<T, Abi>, 2> zip(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
 
 namespace detail {
 
+template <size_t kOffset, size_t... indices, typename T, typename Abi>
+Simd<T, Abi> ZipHalfImpl(Simd<T, Abi> lhs, Simd<T, Abi> rhs,
+                         dimsum::index_sequence<indices...>) {
+  constexpr auto size = Simd<T, Abi>::size();
+  return dimsum::shuffle<(kOffset + indices / 2 + indices % 2 * size)...>(lhs,
+                                                                          rhs);
+}
+
+template <size_t kOffset, size_t... indices, typename T, typename Abi>
+Simd<T, Abi> UnzipImpl(Simd<T, Abi> lhs, Simd<T, Abi> rhs,
+                       dimsum::index_sequence<indices...>) {
+  return dimsum::shuffle<(2 * indices + kOffset)...>(lhs, rhs);
+}
+
+}  // namespace detail
+
+// Returns the low and the high halves of zip(lhs, rhs), respectively:
+//   zip_lo: lhs[0], rhs[0], lhs[1], rhs[1], ..., lhs[n/2-1], rhs[n/2-1]
+//   zip_hi: lhs[n/2], rhs[n/2], ..., lhs[n-1], rhs[n-1].
+template <typename T, typename Abi>
+Simd<T, Abi> zip_lo(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
+  return detail::ZipHalfImpl<0>(
+      lhs, rhs, dimsum::make_index_sequence<Simd<T, Abi>::size()>{});
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> zip_hi(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
+  return detail::ZipHalfImpl<Simd<T, Abi>::size() / 2>(
+      lhs, rhs, dimsum::make_index_sequence<Simd<T, Abi>::size()>{});
+}
+
+// The inverse of zip_lo and zip_hi. For the concatenation c of lhs and rhs,
+// unzip_even returns c[0], c[2], ..., c[2n-2] and unzip_odd returns c[1],
+// c[3], ..., c[2n-1].
+//
+// Example: split interleaved stereo samples into the left and right channels.
+//   left = unzip_even(samples0, samples1);
+//   right = unzip_odd(samples0, samples1);
+template <typename T, typename Abi>
+Simd<T, Abi> unzip_even(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
+  return detail::UnzipImpl<0>(
+      lhs, rhs, dimsum::make_index_sequence<Simd<T, Abi>::size()>{});
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> unzip_odd(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
+  return detail::UnzipImpl<1>(
+      lhs, rhs, dimsum::make_index_sequence<Simd<T, Abi>::size()>{});
+}
+
+namespace detail {
+
+// Shuffles within (real, imaginary) pairs of interleaved complex numbers.
+enum class PairShuffleKind {
+  kDupEven,   // lhs[0], lhs[0], lhs[2], lhs[2], ...
+  kDupOdd,    // lhs[1], lhs[1], lhs[3], lhs[3], ...
+  kSwap,      // lhs[1], lhs[0], lhs[3], lhs[2], ...
+  kBlendOdd,  // lhs[0], rhs[1], lhs[2], rhs[3], ...
+};
+
+constexpr size_t PairShuffleIndex(PairShuffleKind kind, size_t i, size_t n) {
+  return kind == PairShuffleKind::kDupEven
+             ? i - i % 2
+             : kind == PairShuffleKind::kDupOdd
+                   ? i - i % 2 + 1
+                   : kind == PairShuffleKind::kSwap
+                         ? i ^ 1
+                         : (i % 2 == 0 ? i : n + i);
+}
+
+template <PairShuffleKind kKind, size_t... indices, typename T, typename Abi>
+Simd<T, Abi> PairShuffleImpl(Simd<T, Abi> lhs, Simd<T, Abi> rhs,
+                             dimsum::index_sequence<indices...>) {
+  return dimsum::shuffle<PairShuffleIndex(kKind, indices,
+                                          Simd<T, Abi>::size())...>(lhs, rhs);
+}
+
+template <PairShuffleKind kKind, typename T, typename Abi>
+Simd<T, Abi> PairShuffle(Simd<T, Abi> lhs, Simd<T, Abi> rhs = {}) {
+  return PairShuffleImpl<kKind>(
+      lhs, rhs, dimsum::make_index_sequence<Simd<T, Abi>::size()>{});
+}
+
+// Returns a * b - c in the even lanes and a * b + c in the odd lanes, like
+// x86's fmaddsub.
+template <typename T, typename Abi>
+Simd<T, Abi> FmAddSub(Simd<T, Abi> a, Simd<T, Abi> b, Simd<T, Abi> c) {
+  Simd<T, Abi> product = a * b;
+  return PairShuffle<PairShuffleKind::kBlendOdd>(product - c, product + c);
+}
+
+// Returns a * b + c in the even lanes and a * b - c in the odd lanes, like
+// x86's fmsubadd.
+template <typename T, typename Abi>
+Simd<T, Abi> FmSubAdd(Simd<T, Abi> a, Simd<T, Abi> b, Simd<T, Abi> c) {
+  return FmAddSub(a, b, -c);
+}
+
+}  // namespace detail
+
+// The complex arithmetic below treats a Simd as size() / 2 complex numbers,
+// with the real part of each in an even lane and the imaginary part in the
+// following odd lane, the layout of std::complex arrays.
+
+// Returns the complex products lhs * rhs.
+template <typename T, typename Abi>
+Simd<T, Abi> complex_mul(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
+  static_assert(std::is_floating_point<T>::value,
+                "Only floating point types are supported");
+  using detail::PairShuffleKind;
+  return detail::FmAddSub(
+      detail::PairShuffle<PairShuffleKind::kDupEven>(lhs), rhs,
+      detail::PairShuffle<PairShuffleKind::kDupOdd>(lhs) *
+          detail::PairShuffle<PairShuffleKind::kSwap>(rhs));
+}
+
+// Returns the complex products lhs * conj(rhs).
+template <typename T, typename Abi>
+Simd<T, Abi> complex_conj_mul(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
+  static_assert(std::is_floating_point<T>::value,
+                "Only floating point types are supported");
+  using detail::PairShuffleKind;
+  return detail::FmSubAdd(
+      detail::PairShuffle<PairShuffleKind::kDupEven>(rhs), lhs,
+      detail::PairShuffle<PairShuffleKind::kDupOdd>(rhs) *
+          detail::PairShuffle<PairShuffleKind::kSwap>(lhs));
+}
+
+// Returns the squared magnitude re * re + im * im of each complex number, in
+// both lanes of its pair, so that it can scale interleaved data directly, e.g.
+// lhs / rhs == complex_conj_mul(lhs, rhs) / complex_abs2(rhs).
+template <typename T, typename Abi>
+Simd<T, Abi> complex_abs2(Simd<T, Abi> simd) {
+  static_assert(std::is_floating_point<T>::value,
+                "Only floating point types are supported");
+  Simd<T, Abi> squares = simd * simd;
+  return squares +
+         detail::PairShuffle<detail::PairShuffleKind::kSwap>(squares);
+}
+
+namespace detail {
+
+// Deinterleaving channel `channel` of kN vectors v[0 .. kN-1] of n lanes each
+// takes kN-1 two-input shuffles: step 1 gathers the lanes that come from v[0]
+// and v[1], and step `step` >= 2 blends in the lanes that come from v[step].
+// Lane i of the channel is element kN*i+channel of the concatenated input.
+constexpr size_t DeinterleaveIndex(size_t lane, size_t channel, size_t step,
+                                   size_t kN, size_t n) {
+  return step == 1 ? (kN * lane + channel < 2 * n ? kN * lane + channel : lane)
+                   : ((kN * lane + channel) / n == step
+                          ? n + (kN * lane + channel) % n
+                          : lane);
+}
+
+// The inverse: element `lane` of output vector `out` is element
+// (out*n+lane)/kN of channel (out*n+lane)%kN.
+constexpr size_t InterleaveIndex(size_t lane, size_t out, size_t step,
+                                 size_t kN, size_t n) {
+  return (out * n + lane) % kN == step
+             ? n + (out * n + lane) / kN
+             : (step == 1 && (out * n + lane) % kN == 0
+                    ? (out * n + lane) / kN
+                    : lane);
+}
+
+template <size_t kN, size_t kChannel, size_t kStep, typename SimdType,
+          size_t... lanes>
+SimdType DeinterleaveStep(SimdType acc, SimdType simd,
+                          dimsum::index_sequence<lanes...>) {
+  return shuffle<DeinterleaveIndex(lanes, kChannel, kStep, kN,
+                                   sizeof...(lanes))...>(acc, simd);
+}
+
+template <size_t kN, size_t kOut, size_t kStep, typename SimdType,
+          size_t... lanes>
+SimdType InterleaveStep(SimdType acc, SimdType simd,
+                        dimsum::index_sequence<lanes...>) {
+  return shuffle<InterleaveIndex(lanes, kOut, kStep, kN, sizeof...(lanes))...>(
+      acc, simd);
+}
+
+// Folds the steps above over the kN inputs, for channel (or output) kIndex.
+template <size_t kN, size_t kIndex, size_t kStep = 1>
+struct InterleaveFold {
+  template <typename SimdType>
+  static SimdType Deinterleave(SimdType acc,
+                               const std::array<SimdType, kN>& simds) {
+    return InterleaveFold<kN, kIndex, kStep + 1>::Deinterleave(
+        DeinterleaveStep<kN, kIndex, kStep>(
+            acc, simds[kStep],
+            dimsum::make_index_sequence<SimdType::size()>{}),
+        simds);
+  }
+
+  template <typename SimdType>
+  static SimdType Interleave(SimdType acc,
+                             const std::array<SimdType, kN>& simds) {
+    return InterleaveFold<kN, kIndex, kStep + 1>::Interleave(
+        InterleaveStep<kN, kIndex, kStep>(
+            acc, simds[kStep],
+            dimsum::make_index_sequence<SimdType::size()>{}),
+        simds);
+  }
+};
+
+template <size_t kN, size_t kIndex>
+struct InterleaveFold<kN, kIndex, kN> {
+  template <typename SimdType>
+  static SimdType Deinterleave(SimdType acc, const std::array<SimdType, kN>&) {
+    return acc;
+  }
+
+  template <typename SimdType>
+  static SimdType Interleave(SimdType acc, const std::array<SimdType, kN>&) {
+    return acc;
+  }
+};
+
+// Loads the kN vectors one by one; copying them into the array with a single
+// memcpy makes GCC spill the array to the stack.
+template <size_t kN, typename SimdType, size_t... indices>
+std::array<SimdType, kN> LoadDeinterleaved(
+    const typename SimdType::value_type* ptr,
+    dimsum::index_sequence<indices...>) {
+  const std::array<SimdType, kN> simds = {{SimdType(
+      ptr + indices * SimdType::size(), flags::element_aligned)...}};
+  return {{InterleaveFold<kN, indices>::Deinterleave(simds[0], simds)...}};
+}
+
+template <size_t kN, typename T, typename Abi, size_t... indices>
+void StoreInterleaved(T* ptr, const std::array<Simd<T, Abi>, kN>& simds,
+                      dimsum::index_sequence<indices...>) {
+  int expand[] = {
+      (InterleaveFold<kN, indices>::Interleave(simds[0], simds)
+           .memstore(ptr + indices * Simd<T, Abi>::size(),
+                     flags::element_aligned),
+       0)...};
+  (void)expand;
+}
+
+}  // namespace detail
+
+// Loads kN * SimdType::size() elements of array-of-structs data with kN
+// channels, and returns them deinterleaved into one Simd object per channel:
+// ret[c][i] = ptr[kN * i + c]. kN must be 2, 3 or 4.
+//
+// Example: split packed RGB pixels into planes.
+//   auto rgb = load_interleaved<3, NativeSimd<uint8>>(pixels);
+//   // rgb[0] holds the reds, rgb[1] the greens, rgb[2] the blues.
+template <size_t kN, typename SimdType>
+std::array<SimdType, kN> load_interleaved(
+    const typename SimdType::value_type* ptr) {
+  static_assert(kN >= 2 && kN <= 4, "Only 2, 3 or 4 channels are supported");
+  return detail::LoadDeinterleaved<kN, SimdType>(
+      ptr, dimsum::make_index_sequence<kN>{});
+}
+
+// The inverse of load_interleaved: writes ptr[kN * i + c] = simds[c][i].
+template <size_t kN, typename T, typename Abi>
+void store_interleaved(T* ptr, std::array<Simd<T, Abi>, kN> simds) {
+  static_assert(kN >= 2 && kN <= 4, "Only 2, 3 or 4 channels are supported");
+  detail::StoreInterleaved(ptr, simds, dimsum::make_index_sequence<kN>{});
+}
+
+namespace detail {
+
+template <typename T, typename Abi>
+Simd<T, Abi> ZipHalf(Simd<T, Abi> lhs, Simd<T, Abi> rhs, std::false_type) {
+  return zip_lo(lhs, rhs);
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> ZipHalf(Simd<T, Abi> lhs, Simd<T, Abi> rhs, std::true_type) {
+  return zip_hi(lhs, rhs);
+}
+
+// One stage of the transpose: row k of the result interleaves the low or high
+// halves of rows k/2 and k/2 + N/2. log2(N) stages transpose the matrix.
+template <typename SimdType, size_t N, size_t... rows>
+std::array<SimdType, N> TransposeStage(const std::array<SimdType, N>& simds,
+                                       dimsum::index_sequence<rows...>) {
+  return {{ZipHalf(simds[rows / 2], simds[rows / 2 + N / 2],
+                   std::integral_constant<bool, rows % 2 == 1>())...}};
+}
+
+template <size_t kWidth, size_t N>
+struct TransposeStages {
+  template <typename SimdType>
+  static std::array<SimdType, N> Apply(const std::array<SimdType, N>& simds) {
+    return TransposeStages<kWidth * 2, N>::Apply(
+        TransposeStage(simds, dimsum::make_index_sequence<N>{}));
+  }
+};
+
+template <size_t N>
+struct TransposeStages<N, N> {
+  template <typename SimdType>
+  static std::array<SimdType, N> Apply(const std::array<SimdType, N>& simds) {
+    return simds;
+  }
+};
+
+}  // namespace detail
+
+// Transposes the square matrix whose ith row is rows[i], in place:
+// afterwards rows[i][j] holds what was rows[j][i]. N must be equal to the
+// number of elements in a row.
+//
+// Example: transpose 4x4 floats in four XMM registers.
+//   std::array<Simd128<float>, 4> rows = ...;
+//   transpose(rows);
+template <typename T, typename Abi, size_t N>
+void transpose(std::array<Simd<T, Abi>, N>& rows) {
+  static_assert(N == Simd<T, Abi>::size(),
+                "transpose requires as many rows as elements in a row");
+  rows = detail::TransposeStages<1, N>::Apply(rows);
+}
+
+namespace detail {
+
 template <typename T, typename Abi, typename Flags>
 struct LoadImpl {
   static Simd<T, Abi> Apply(const T* buffer) {
@@ -763,6 +1404,18 @@ struct LoadImpl {
   }
 };
 
+template <typename T, typename Abi, typename Flags>
+struct StoreImpl {
+  static void Apply(Simd<T, Abi> simd, T* buffer) {
+    constexpr size_t bytes = sizeof(simd.storage_);
+    if (std::is_same<Flags, flags::element_aligned_tag>::value) {
+      memcpy(buffer, &simd.storage_, bytes);
+    } else {
+      memcpy(__builtin_assume_aligned(buffer, bytes), &simd.storage_, bytes);
+    }
+  }
+};
+
 template <size_t kArity>
 struct ReduceAddImpl;
 
@@ -843,6 +1496,8 @@ ScaleElemBy<Simd<T, Abi>, 2> mul_widened(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
 }
 
 // Returns the element-wise min result. Elements should not contain NaN.
+// The default implementation, defined below, compares and selects bits; it is
+// used where there is no native instruction, e.g. 64-bit lanes on x86.
 template <typename T, typename Abi>
 Simd<T, Abi> min(Simd<T, Abi> lhs, Simd<T, Abi> rhs);
 
@@ -853,6 +1508,8 @@ Simd<T, Abi> max(Simd<T, Abi> lhs, Simd<T, Abi> rhs);
 // Returns the element-wise negation.
 template <typename T, typename Abi>
 Simd<T, Abi> negate(Simd<T, Abi> simd) {
+  static_assert(!detail::IsStorageOnly<T>(),
+                "Storage-only types should be converted to float first");
   return Simd<T, Abi>::from_storage(-simd.storage_);
 }
 
@@ -918,22 +1575,179 @@ Simd<Dest, Abi> bit_cast(Simd<T, Abi> simd) {
   return ret;
 }
 
+namespace detail {
+
+// The bitwise default of select. Backends with a blend or bit select
+// instruction specialize it per Abi.
+template <typename T, typename Abi>
+struct SelectImpl {
+  static Simd<T, Abi> Apply(
+      Simd<typename Simd<T, Abi>::ComparisonResultType, Abi> mask,
+      Simd<T, Abi> if_true, Simd<T, Abi> if_false) {
+    using Bits = typename Simd<T, Abi>::ComparisonResultType;
+    return bit_cast<T>(
+        bit_or(bit_and(bit_cast<Bits>(if_true), mask),
+               bit_and(bit_cast<Bits>(if_false), bit_not(mask))));
+  }
+};
+
+template <size_t... kBits, typename T, typename Abi, size_t... indices>
+Simd<T, Abi> BlendImpl(Simd<T, Abi> if_true, Simd<T, Abi> if_false,
+                       dimsum::index_sequence<indices...>) {
+  return dimsum::shuffle<(kBits ? indices : indices + sizeof...(indices))...>(
+      if_true, if_false);
+}
+
+}  // namespace detail
+
+// Returns if_true[i] where mask[i] is set and if_false[i] elsewhere. Each lane
+// of mask must be all ones or all zeros, like the results of cmp_*: x86 only
+// looks at the most significant bit of each lane, while NEON and VSX select
+// bit by bit.
+//
+// Example: replace the negative lanes of x with zeros.
+//   x = select(cmp_lt(x, SimdType(0)), SimdType(0), x);
+template <typename T, typename Abi>
+Simd<T, Abi> select(
+    Simd<typename Simd<T, Abi>::ComparisonResultType, Abi> mask,
+    Simd<T, Abi> if_true, Simd<T, Abi> if_false) {
+  return detail::SelectImpl<T, Abi>::Apply(mask, if_true, if_false);
+}
+
+// The compile-time select: returns if_true[i] where the ith of kBits is 1 and
+// if_false[i] where it is 0. Compilers match the underlying shuffle to an
+// immediate blend, e.g. blendps, pblendw or vpblendd on x86.
+//
+// Example: blend<1, 0, 1, 0>(a, b) returns a[0], b[1], a[2], b[3].
+template <size_t... kBits, typename T, typename Abi>
+Simd<T, Abi> blend(Simd<T, Abi> if_true, Simd<T, Abi> if_false) {
+  static_assert(sizeof...(kBits) == Simd<T, Abi>::size(),
+                "blend takes one bit per lane");
+  return detail::BlendImpl<kBits...>(
+      if_true, if_false, dimsum::make_index_sequence<sizeof...(kBits)>{});
+}
+
+// Rotates the bits of each lane left by the number of bits in the same lane
+// of count, which must be in [0, 8 * sizeof(T)).
+template <typename T, typename Abi>
+Simd<T, Abi> rotl_simd(Simd<T, Abi> simd, Simd<T, Abi> count) {
+  static_assert(std::is_integral<T>::value,
+                "Only integral types are supported");
+  using Bits = typename Simd<T, Abi>::ComparisonResultType;
+  using BitsSimd = Simd<Bits, Abi>;
+  constexpr Bits kMask = 8 * sizeof(T) - 1;
+  const BitsSimd bits = bit_cast<Bits>(simd), left = bit_cast<Bits>(count);
+  // A count of 0 shifts right by 0 too, instead of the undefined 8 * sizeof(T).
+  const BitsSimd right = (BitsSimd(0) - left) & BitsSimd(kMask);
+  return bit_cast<T>(shl_simd(bits, left) | shr_simd(bits, right));
+}
+
+// Rotates the bits of each lane right, see rotl_simd.
+template <typename T, typename Abi>
+Simd<T, Abi> rotr_simd(Simd<T, Abi> simd, Simd<T, Abi> count) {
+  static_assert(std::is_integral<T>::value,
+                "Only integral types are supported");
+  using Bits = typename Simd<T, Abi>::ComparisonResultType;
+  using BitsSimd = Simd<Bits, Abi>;
+  constexpr Bits kMask = 8 * sizeof(T) - 1;
+  const BitsSimd bits = bit_cast<Bits>(simd), right = bit_cast<Bits>(count);
+  const BitsSimd left = (BitsSimd(0) - right) & BitsSimd(kMask);
+  return bit_cast<T>(shl_simd(bits, left) | shr_simd(bits, right));
+}
+
+// Rotates the bits of every lane left by count, which must be in
+// [0, 8 * sizeof(T)).
+template <typename T, typename Abi>
+Simd<T, Abi> rotl(Simd<T, Abi> simd, int count) {
+  static_assert(std::is_integral<T>::value,
+                "Only integral types are supported");
+  using Bits = typename Simd<T, Abi>::ComparisonResultType;
+  const Simd<Bits, Abi> bits = bit_cast<Bits>(simd);
+  return bit_cast<T>(shl(bits, count) |
+                     shr(bits, -count & (8 * sizeof(T) - 1)));
+}
+
+// Rotates the bits of every lane right, see rotl.
+template <typename T, typename Abi>
+Simd<T, Abi> rotr(Simd<T, Abi> simd, int count) {
+  return rotl(simd, -count & (8 * sizeof(T) - 1));
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> min(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
+  return select(cmp_lt(lhs, rhs), lhs, rhs);
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> max(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
+  return select(cmp_gt(lhs, rhs), lhs, rhs);
+}
+
+namespace detail {
+
+template <typename Dest, typename Src>
+struct StaticSimdCastImpl {
+  template <typename Abi>
+  static ChangeElemTo<Simd<Src, Abi>, Dest> Apply(Simd<Src, Abi> simd) {
+    using DestSimd = ChangeElemTo<Simd<Src, Abi>, Dest>;
+#if defined(__clang__)
+    if (std::is_same<typename LaneTraits<Src>::type, Src>::value &&
+        std::is_same<typename LaneTraits<Dest>::type, Dest>::value) {
+      return DestSimd::from_storage(__builtin_convertvector(
+          simd.storage_, typename DestSimd::Traits::InternalType));
+    }
+#endif
+    DestSimd ret;
+    for (int i = 0; i < ret.size(); i++) {
+      ret.storage_[i] = LaneTraits<Dest>::ToLane(
+          static_cast<Dest>(LaneTraits<Src>::FromLane(simd.storage_[i])));
+    }
+    return ret;
+  }
+};
+
+}  // namespace detail
+
 // Element-wise static_cast<Dest>().
+//
+// float16 and bfloat16 convert to and from the other element types through
+// float, see their definitions for the rounding.
 template <typename Dest, typename Src, typename Abi>
 ChangeElemTo<Simd<Src, Abi>, Dest> static_simd_cast(Simd<Src, Abi> simd) {
-  using DestSimd = ChangeElemTo<Simd<Src, Abi>, Dest>;
-#if defined(__clang__)
-  return DestSimd(__builtin_convertvector(
-      simd.storage_, typename DestSimd::Traits::InternalType));
-#else
-  DestSimd ret;
-  for (int i = 0; i < ret.size(); i++) {
-    ret.storage_[i] = static_cast<Dest>(simd.storage_[i]);
-  }
-  return ret;
-#endif
+  return detail::StaticSimdCastImpl<Dest, Src>::Apply(simd);
 }
 
+namespace detail {
+
+// bfloat16 is the upper half of a float, so widening is a shift.
+template <>
+struct StaticSimdCastImpl<float, bfloat16> {
+  template <typename Abi>
+  static ChangeElemTo<Simd<bfloat16, Abi>, float> Apply(
+      Simd<bfloat16, Abi> simd) {
+    auto bits = static_simd_cast<uint32>(bit_cast<uint16>(simd));
+    return bit_cast<float>(shl(bits, 16));
+  }
+};
+
+// Rounds to nearest even by adding 0x7fff plus the lowest kept bit, and keeps
+// NaNs quiet instead of letting the carry turn them into infinities.
+template <>
+struct StaticSimdCastImpl<bfloat16, float> {
+  template <typename Abi>
+  static ChangeElemTo<Simd<float, Abi>, bfloat16> Apply(
+      Simd<float, Abi> simd) {
+    using Bits = ChangeElemTo<Simd<float, Abi>, uint32>;
+    Bits bits = bit_cast<uint32>(simd);
+    Bits rounded = bits + Bits(0x7fff) + (shr(bits, 16) & Bits(1));
+    Bits is_nan = cmp_ne(simd, simd);
+    rounded = (rounded & ~is_nan) | ((bits | Bits(0x00400000)) & is_nan);
+    return bit_cast<bfloat16>(static_simd_cast<uint16>(shr(rounded, 16)));
+  }
+};
+
+}  // namespace detail
+
 // Element-wise static_cast<Dest>() prohibiting narrowing cast, e.g. every
 // possible value of the element type can be represented with Dest.
 template <typename Dest, typename Src, typename Abi>
@@ -952,6 +1766,62 @@ convert(Simd<Src, Abi> simd) {
   return static_simd_cast<Dest, Src, Abi>(simd);
 }
 
+namespace detail {
+
+template <typename Dest, typename Src, typename Abi>
+ChangeElemTo<Simd<Src, Abi>, Dest> SaturatedSimdCast(
+    Simd<Src, Abi> simd, std::false_type /* is_floating_point */) {
+  using SrcSimd = Simd<Src, Abi>;
+  constexpr Src kLower = SaturationLowerBound<Dest, Src>();
+  constexpr Src kUpper = SaturationUpperBound<Dest, Src>();
+  if (kLower != std::numeric_limits<Src>::lowest()) {
+    simd = max(simd, SrcSimd(kLower));
+  }
+  if (kUpper != std::numeric_limits<Src>::max()) {
+    simd = min(simd, SrcSimd(kUpper));
+  }
+  return static_simd_cast<Dest>(simd);
+}
+
+template <typename Dest, typename Src, typename Abi>
+ChangeElemTo<Simd<Src, Abi>, Dest> SaturatedSimdCast(
+    Simd<Src, Abi> simd, std::true_type /* is_floating_point */) {
+  using SrcSimd = Simd<Src, Abi>;
+  using DestSimd = ChangeElemTo<SrcSimd, Dest>;
+  using Mask = Number<sizeof(Src), NumberKind::kSInt>;
+  constexpr Src kUpper = SaturationUpperBound<Dest, Src>();
+  // NaNs become zeros, then everything else is clamped into the range where
+  // the conversion is exact after truncation.
+  auto ordered = bit_cast<Mask>(cmp_eq(simd, simd));
+  SrcSimd clamped = bit_cast<Src>(bit_cast<Mask>(simd) & ordered);
+  clamped = min(max(clamped, SrcSimd(SaturationLowerBound<Dest, Src>())),
+                SrcSimd(kUpper));
+  DestSimd ret = static_simd_cast<Dest>(clamped);
+  if (kUpper < static_cast<Src>(std::numeric_limits<Dest>::max())) {
+    // The maximum of Dest isn't representable, so lanes above kUpper are
+    // above it too. The sign extended masks select the maximum for them.
+    auto overflow = static_simd_cast<Dest>(
+        bit_cast<Mask>(cmp_gt(simd, SrcSimd(kUpper))));
+    ret = ret | (overflow & DestSimd(std::numeric_limits<Dest>::max()));
+  }
+  return ret;
+}
+
+}  // namespace detail
+
+// Element-wise conversion to the integer type Dest, clamping values outside of
+// its range to its minimum or maximum. Floating point values are truncated
+// toward zero like static_cast, and NaNs become 0.
+//
+// Example: saturated_simd_cast<uint8>(Simd128<int32>::list(-1, 7, 300, 255))
+// returns [0, 7, 255, 255].
+template <typename Dest, typename Src, typename Abi>
+ChangeElemTo<Simd<Src, Abi>, Dest> saturated_simd_cast(Simd<Src, Abi> simd) {
+  static_assert(std::is_integral<Dest>::value,
+                "saturated_simd_cast only converts to integers");
+  return detail::SaturatedSimdCast<Dest>(simd, std::is_floating_point<Src>());
+}
+
 // Overloaded operators.
 template <typename T, typename Abi>
 Simd<T, Abi> operator-(Simd<T, Abi> a) {
@@ -1057,6 +1927,470 @@ ResizeBy<ScaleElemBy<Simd<T, Abi>, 2>, 1, 2> mul_sum(
   return acc + reduce_add<2>(mul_widened(lhs, rhs));
 }
 
+namespace detail {
+
+// Sign- or zero-extends the low (kHigh = false) or high half of the lanes of
+// simd to twice their width. Zipping with the extension bits keeps this a
+// single shuffle, unlike split and static_simd_cast.
+template <bool kHigh, typename T, typename Abi>
+Simd<ScaleBy<T, 2>, Abi> WidenHalf(Simd<T, Abi> simd) {
+  const Simd<T, Abi> ext = std::is_signed<T>::value
+                               ? bit_cast<T>(cmp_lt(simd, Simd<T, Abi>(0)))
+                               : Simd<T, Abi>(0);
+  return bit_cast<ScaleBy<T, 2>>(kHigh ? zip_hi(simd, ext)
+                                       : zip_lo(simd, ext));
+}
+
+// Returns (product + 0x4000) >> 15 in the low 16 bits of each lane.
+template <typename Abi>
+Simd<int16, Abi> MulHiRoundHalf(Simd<int32, Abi> product) {
+  return bit_cast<int16>(
+      shl(bit_cast<uint32>(product + Simd<int32, Abi>(0x4000)), 1));
+}
+
+// Returns (x + 127) / 255 for x <= 255 * 255.
+template <typename Abi>
+Simd<uint16, Abi> DivideBy255Rounded(Simd<uint16, Abi> x) {
+  x = x + Simd<uint16, Abi>(128);
+  return shr(x + shr(x, 8), 8);
+}
+
+// Returns the full products of the low 32 bits of the lanes. This is x86's
+// pmuludq.
+template <typename Abi>
+Simd<uint64, Abi> MulEvenU32(Simd<uint64, Abi> lhs, Simd<uint64, Abi> rhs) {
+  const Simd<uint64, Abi> low_bits(0xffffffff);
+  return (lhs & low_bits) * (rhs & low_bits);
+}
+
+// Returns the high half of the 128-bit products, from the four products of
+// the 32-bit halves. None of the partial sums overflows.
+template <typename Abi>
+Simd<uint64, Abi> MulHiU64(Simd<uint64, Abi> lhs, Simd<uint64, Abi> rhs) {
+  const Simd<uint64, Abi> lhs_hi = shr(lhs, 32), rhs_hi = shr(rhs, 32);
+  const Simd<uint64, Abi> cross =
+      MulEvenU32(lhs_hi, rhs) + shr(MulEvenU32(lhs, rhs), 32);
+  const Simd<uint64, Abi> middle =
+      (cross & Simd<uint64, Abi>(0xffffffff)) + MulEvenU32(lhs, rhs_hi);
+  return MulEvenU32(lhs_hi, rhs_hi) + shr(cross, 32) + shr(middle, 32);
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> MulHi(Simd<T, Abi> lhs, Simd<T, Abi> rhs,
+                   std::false_type /* is_64_bit */) {
+  auto lo = WidenHalf<false>(lhs) * WidenHalf<false>(rhs);
+  auto hi = WidenHalf<true>(lhs) * WidenHalf<true>(rhs);
+  return unzip_odd(bit_cast<T>(lo), bit_cast<T>(hi));
+}
+
+template <typename Abi>
+Simd<uint64, Abi> MulHi(Simd<uint64, Abi> lhs, Simd<uint64, Abi> rhs,
+                        std::true_type /* is_64_bit */) {
+  return MulHiU64(lhs, rhs);
+}
+
+// The unsigned product of the same bits is too large by rhs << 64 if lhs is
+// negative, and by lhs << 64 if rhs is.
+template <typename Abi>
+Simd<int64, Abi> MulHi(Simd<int64, Abi> lhs, Simd<int64, Abi> rhs,
+                       std::true_type /* is_64_bit */) {
+  const Simd<uint64, Abi> ulhs = bit_cast<uint64>(lhs),
+                          urhs = bit_cast<uint64>(rhs);
+  return bit_cast<int64>(MulHiU64(ulhs, urhs) -
+                         (cmp_lt(lhs, Simd<int64, Abi>(0)) & urhs) -
+                         (cmp_lt(rhs, Simd<int64, Abi>(0)) & ulhs));
+}
+
+}  // namespace detail
+
+// Returns the element-wise average of two integer Simd objects, rounded up:
+// (lhs + rhs + 1) >> 1, computed without overflow. This is x86's pavgb and
+// NEON's vrhadd.
+template <typename T, typename Abi>
+Simd<T, Abi> avg_round(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
+  static_assert(std::is_integral<T>::value,
+                "Only integral types are supported");
+  // lhs + rhs == 2 * (lhs | rhs) - (lhs ^ rhs), and shr is arithmetic for
+  // signed types.
+  return (lhs | rhs) - shr(lhs ^ rhs, 1);
+}
+
+// Returns the high half of the element-wise, widened products of two integer
+// Simd objects: (lhs * rhs) >> (8 * sizeof(T)).
+template <typename T, typename Abi>
+Simd<T, Abi> mul_hi(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
+  static_assert(std::is_integral<T>::value,
+                "Only integral types are supported");
+  return detail::MulHi(lhs, rhs,
+                       std::integral_constant<bool, sizeof(T) == 8>());
+}
+
+// Returns the element-wise, rounded Q15 products of two int16 Simd objects:
+// (lhs * rhs + 0x4000) >> 15. This is x86's pmulhrsw.
+// The only product out of range is -32768 * -32768, which wraps around to
+// -32768 on x86 and saturates to 32767 on NEON and VSX.
+template <typename Abi>
+Simd<int16, Abi> mul_hi_round(Simd<int16, Abi> lhs, Simd<int16, Abi> rhs) {
+  auto lo = detail::WidenHalf<false>(lhs) * detail::WidenHalf<false>(rhs);
+  auto hi = detail::WidenHalf<true>(lhs) * detail::WidenHalf<true>(rhs);
+  return unzip_odd(detail::MulHiRoundHalf(lo), detail::MulHiRoundHalf(hi));
+}
+
+// Blends two uint8 Simd objects by the weights alpha / 255, the "over"
+// operator of alpha compositing:
+//   (src * alpha + dst * (255 - alpha) + 127) / 255,
+// rounded exactly as the scalar formula, so that alpha = 255 returns src and
+// alpha = 0 returns dst.
+template <typename Abi>
+Simd<uint8, Abi> blend_u8(Simd<uint8, Abi> src, Simd<uint8, Abi> dst,
+                          Simd<uint8, Abi> alpha) {
+  using detail::WidenHalf;
+  const Simd<uint8, Abi> inv_alpha = ~alpha;
+  auto lo = WidenHalf<false>(src) * WidenHalf<false>(alpha) +
+            WidenHalf<false>(dst) * WidenHalf<false>(inv_alpha);
+  auto hi = WidenHalf<true>(src) * WidenHalf<true>(alpha) +
+            WidenHalf<true>(dst) * WidenHalf<true>(inv_alpha);
+  return unzip_even(bit_cast<uint8>(detail::DivideBy255Rounded(lo)),
+                    bit_cast<uint8>(detail::DivideBy255Rounded(hi)));
+}
+
+namespace detail {
+
+// How dot_u8s8_i32 and dot_s8s8_i32 compute their products on an Abi.
+enum class DotProductKind {
+  // Every product is computed exactly. Only the int32 sums wrap around.
+  kExact,
+  // The x86 pmaddubsw lowering: products of adjacent byte pairs are summed
+  // with int16 saturation before being widened. dot_s8s8_i32 multiplies
+  // abs(lhs) by rhs with the sign of lhs applied, where -(-128) wraps to -128.
+  kSaturatedPairs,
+};
+
+// Backends specialize this for Abis lowered with pmaddubsw.
+template <typename Abi>
+constexpr DotProductKind DotProductKindOf() {
+  return DotProductKind::kExact;
+}
+
+}  // namespace detail
+
+// Returns acc plus the dot products of groups of 4 adjacent bytes: lane i is
+// acc[i] + lhs[4i]*rhs[4i] + ... + lhs[4i+3]*rhs[4i+3], wrapping modulo 2**32.
+//
+// This lowers to vpdpbusd with AVX512-VNNI or AVX-VNNI and to vusdot with the
+// ARMv8.6 int8 matrix extension. Without VNNI, x86 uses pmaddubsw + pmaddwd,
+// which saturates the sum of each pair of adjacent products to int16 (see
+// detail::DotProductKind::kSaturatedPairs). The result is exact whenever no
+// pair sum exceeds int16, e.g. if every lhs lane is at most 127 or every rhs
+// lane is in [-64, 64].
+template <typename Abi>
+Simd<int32, Abi> dot_u8s8_i32(Simd<int32, Abi> acc, Simd<uint8, Abi> lhs,
+                              Simd<int8, Abi> rhs) {
+  return acc + reduce_add<2>(mul_sum(static_simd_cast<int16>(lhs),
+                                     static_simd_cast<int16>(rhs)));
+}
+
+// The same as dot_u8s8_i32 for signed lhs.
+//
+// This lowers to sdot on ARMv8.2 with the dot product extension, and to two
+// vpdpbusd with AVX512-VNNI or AVX-VNNI, which are exact. Without VNNI, x86
+// multiplies abs(lhs) by rhs negated where lhs is negative (psignb) with
+// pmaddubsw, so besides the pair saturation of dot_u8s8_i32, a product of a
+// negative lhs and rhs = -128 has the wrong sign. Keeping rhs in [-127, 127]
+// avoids both: no pair sum can then exceed 128*127*2 < 2**15.
+template <typename Abi>
+Simd<int32, Abi> dot_s8s8_i32(Simd<int32, Abi> acc, Simd<int8, Abi> lhs,
+                              Simd<int8, Abi> rhs) {
+  return acc + reduce_add<2>(mul_sum(static_simd_cast<int16>(lhs),
+                                     static_simd_cast<int16>(rhs)));
+}
+
+// ----------------- Compress and Expand -----------------
+
+namespace detail {
+
+// Returns whether lane i of a comparison result `mask` is set, i.e. whether
+// its most significant bit is set.
+template <typename T, typename Abi>
+bool MaskLaneIsSet(Simd<T, Abi> mask, size_t i) {
+  return mask[i] >> (sizeof(T) * CHAR_BIT - 1);
+}
+
+// Returns the source lane of output lane `lane` of compress: the lanes set in
+// `mask` in order, followed by the other lanes in order.
+constexpr size_t CompressSourceLane(size_t mask, size_t num_lanes,
+                                    size_t lane) {
+  size_t count = 0;
+  for (size_t pass = 0; pass < 2; pass++) {
+    for (size_t i = 0; i < num_lanes; i++) {
+      if (((mask >> i) & 1) == (pass == 0 ? 1u : 0u)) {
+        if (count == lane) return i;
+        count++;
+      }
+    }
+  }
+  return 0;
+}
+
+// Returns the source lane of output lane `lane` of expand, or num_lanes if
+// the output lane is zero.
+constexpr size_t ExpandSourceLane(size_t mask, size_t num_lanes, size_t lane) {
+  if (((mask >> lane) & 1) == 0) return num_lanes;
+  size_t count = 0;
+  for (size_t i = 0; i < lane; i++) {
+    count += (mask >> i) & 1;
+  }
+  return count;
+}
+
+// Packs 8 consecutive shuffle indices of the compress (or expand) permutation
+// into a uint64, one byte each. Indices are in units of whatever the shuffle
+// instruction addresses (bytes for pshufb and tbl, dwords for vpermd), of
+// which each lane has kLaneUnits. Output lanes that expand zeroes have the
+// index 0x80, which pshufb and tbl turn into zero.
+template <bool kExpand, size_t kNumLanes, size_t kLaneUnits>
+constexpr uint64 LaneTableWord(size_t entry) {
+  constexpr size_t kWords = kNumLanes * kLaneUnits / 8;
+  uint64 word = 0;
+  for (size_t i = 0; i < 8; i++) {
+    size_t unit = entry % kWords * 8 + i;
+    size_t mask = entry / kWords;
+    size_t source =
+        kExpand ? ExpandSourceLane(mask, kNumLanes, unit / kLaneUnits)
+                : CompressSourceLane(mask, kNumLanes, unit / kLaneUnits);
+    uint64 index = source == kNumLanes
+                       ? 0x80
+                       : source * kLaneUnits + unit % kLaneUnits;
+    word |= index << (8 * i);
+  }
+  return word;
+}
+
+template <bool kExpand, size_t kNumLanes, size_t kLaneUnits, typename Sequence>
+struct LaneTableImpl;
+
+template <bool kExpand, size_t kNumLanes, size_t kLaneUnits, size_t... entries>
+struct LaneTableImpl<kExpand, kNumLanes, kLaneUnits,
+                     dimsum::index_sequence<entries...>> {
+  static_assert(kNumLanes * kLaneUnits % 8 == 0, "Rows must be whole words");
+  alignas(16) static constexpr uint64 kWords[] = {
+      LaneTableWord<kExpand, kNumLanes, kLaneUnits>(entries)...};
+};
+
+template <bool kExpand, size_t kNumLanes, size_t kLaneUnits, size_t... entries>
+alignas(16) constexpr uint64 LaneTableImpl<
+    kExpand, kNumLanes, kLaneUnits,
+    dimsum::index_sequence<entries...>>::kWords[];
+
+// The shuffle indices of compress and expand for all 2^kNumLanes masks, with
+// kNumLanes * kLaneUnits / 8 words per mask. They are used by backends to
+// lower compress and expand to a single shuffle.
+template <size_t kNumLanes, size_t kLaneUnits>
+using CompressTable = LaneTableImpl<
+    false, kNumLanes, kLaneUnits,
+    dimsum::make_index_sequence<(kNumLanes * kLaneUnits / 8) << kNumLanes>>;
+
+template <size_t kNumLanes, size_t kLaneUnits>
+using ExpandTable = LaneTableImpl<
+    true, kNumLanes, kLaneUnits,
+    dimsum::make_index_sequence<(kNumLanes * kLaneUnits / 8) << kNumLanes>>;
+
+}  // namespace detail
+
+// Returns the lanes of `simd` whose lanes in `mask` are set, in order,
+// followed by the other lanes, also in order. A lane of `mask` is set if its
+// most significant bit is set, which is the case for the true lanes of cmp_*
+// results.
+//
+// e.g. compress({1, 2, 3, 4}, {0, ~0, 0, ~0}) returns {2, 4, 1, 3}.
+//
+// On SSE4.1 and NEON, lanes of 16 bits and wider look up pshufb/tbl indices
+// by the mask bits; on AVX2 32-bit and wider lanes use vpermd in the same way.
+// With AVX512VBMI2, the remaining byte and word lanes use vpcompress.
+template <typename T, typename Abi>
+Simd<T, Abi> compress(
+    Simd<T, Abi> simd,
+    Simd<typename Simd<T, Abi>::ComparisonResultType, Abi> mask) {
+  constexpr size_t size = Simd<T, Abi>::size();
+  T lanes[size];
+  size_t count = 0;
+  for (size_t i = 0; i < size; i++) {
+    if (detail::MaskLaneIsSet(mask, i)) lanes[count++] = simd[i];
+  }
+  for (size_t i = 0; i < size; i++) {
+    if (!detail::MaskLaneIsSet(mask, i)) lanes[count++] = simd[i];
+  }
+  return Simd<T, Abi>(lanes, flags::element_aligned);
+}
+
+// The inverse of compress: returns a Simd whose lanes set in `mask` are the
+// first lanes of `simd`, in order, and whose other lanes are zero.
+//
+// e.g. expand({1, 2, 3, 4}, {0, ~0, 0, ~0}) returns {0, 1, 0, 2}.
+template <typename T, typename Abi>
+Simd<T, Abi> expand(
+    Simd<T, Abi> simd,
+    Simd<typename Simd<T, Abi>::ComparisonResultType, Abi> mask) {
+  constexpr size_t size = Simd<T, Abi>::size();
+  T lanes[size];
+  size_t count = 0;
+  for (size_t i = 0; i < size; i++) {
+    lanes[i] = detail::MaskLaneIsSet(mask, i) ? simd[count++] : T(0);
+  }
+  return Simd<T, Abi>(lanes, flags::element_aligned);
+}
+
+// Stores the lanes of `simd` whose lanes in `mask` are set to
+// ptr[0 .. count-1], in order, and returns count. Nothing is written past
+// ptr[count - 1], so ptr doesn't need room for a whole Simd.
+//
+// With AVX-512 this is a single vpcompress with a memory destination.
+template <typename T, typename Abi>
+size_t compress_store(
+    T* ptr, Simd<T, Abi> simd,
+    Simd<typename Simd<T, Abi>::ComparisonResultType, Abi> mask) {
+  size_t count = 0;
+  for (size_t i = 0; i < simd.size(); i++) {
+    if (detail::MaskLaneIsSet(mask, i)) ptr[count++] = simd[i];
+  }
+  return count;
+}
+
+// ----------------- Bit Counting and Reversal -----------------
+
+// Returns the number of one bits in each lane.
+template <typename T, typename Abi>
+Simd<T, Abi> popcount(Simd<T, Abi> simd);
+
+// Returns the number of consecutive zero bits in each lane, starting from the
+// most significant bit. Zero lanes give sizeof(T) * CHAR_BIT.
+template <typename T, typename Abi>
+Simd<T, Abi> countl_zero(Simd<T, Abi> simd);
+
+// Reverses the bits of each lane.
+template <typename T, typename Abi>
+Simd<T, Abi> bit_reverse(Simd<T, Abi> simd);
+
+namespace detail {
+
+template <typename T, typename Abi>
+using UnsignedSimd = Simd<Number<sizeof(T), NumberKind::kUInt>, Abi>;
+
+// Signed lanes are counted as unsigned ones, so that backends only need to
+// specialize the unsigned types.
+template <typename T, typename Abi>
+Simd<T, Abi> PopcountImpl(Simd<T, Abi> simd, std::true_type /* is_signed */) {
+  return bit_cast<T>(popcount(bit_cast<Number<sizeof(T), NumberKind::kUInt>>(
+      simd)));
+}
+
+// Adds up the bits in 2-bit, 4-bit and then 8-bit fields, and finally sums
+// the bytes of each lane into its most significant byte with a multiply.
+template <typename T, typename Abi>
+Simd<T, Abi> PopcountImpl(Simd<T, Abi> simd, std::false_type) {
+  using SimdType = Simd<T, Abi>;
+  constexpr uint64 kOnes = ~uint64{0};
+  simd = simd - (shr(simd, 1) & SimdType(static_cast<T>(kOnes / 3)));
+  simd = (simd & SimdType(static_cast<T>(kOnes / 5))) +
+         (shr(simd, 2) & SimdType(static_cast<T>(kOnes / 5)));
+  simd = (simd + shr(simd, 4)) & SimdType(static_cast<T>(kOnes / 17));
+  return shr(simd * SimdType(static_cast<T>(kOnes / 255)),
+             (sizeof(T) - 1) * CHAR_BIT);
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> CountlZeroImpl(Simd<T, Abi> simd, std::true_type /* is_signed */) {
+  return bit_cast<T>(countl_zero(
+      bit_cast<Number<sizeof(T), NumberKind::kUInt>>(simd)));
+}
+
+// Smears the leading one bit to all lower bits and counts the zeros left.
+template <typename T, typename Abi>
+Simd<T, Abi> CountlZeroImpl(Simd<T, Abi> simd, std::false_type) {
+  for (size_t shift = 1; shift < sizeof(T) * CHAR_BIT; shift *= 2) {
+    simd = simd | shr(simd, shift);
+  }
+  return popcount(~simd);
+}
+
+template <typename T, typename Abi, size_t... indices>
+Simd<T, Abi> ByteReverseImpl(Simd<T, Abi> simd,
+                             dimsum::index_sequence<indices...>) {
+  return bit_cast<T>(
+      shuffle<(indices ^ (sizeof(T) - 1))...>(bit_cast<uint8>(simd)));
+}
+
+// Reverses the bytes of each lane and then the bits of each byte.
+template <typename T, typename Abi>
+Simd<T, Abi> BitReverseImpl(Simd<T, Abi> simd, std::false_type /* uint8 */);
+
+// Swaps adjacent bits, then adjacent bit pairs, then nibbles.
+template <typename Abi>
+Simd<uint8, Abi> BitReverseImpl(Simd<uint8, Abi> simd,
+                                std::true_type /* uint8 */) {
+  using SimdType = Simd<uint8, Abi>;
+  simd = (shr(simd, 1) & SimdType(0x55)) | shl(simd & SimdType(0x55), 1);
+  simd = (shr(simd, 2) & SimdType(0x33)) | shl(simd & SimdType(0x33), 2);
+  return shr(simd, 4) | shl(simd, 4);
+}
+
+}  // namespace detail
+
+// Backends specialize popcount, countl_zero and bit_reverse for unsigned
+// lanes (pshufb nibble lookups on SSE and AVX2, vpopcnt and vplzcnt on
+// AVX-512, vcnt, vclz and rbit on NEON, vpopcnt and vclz on POWER8). The
+// defaults below are SWAR bit tricks on top of other Simd operations.
+template <typename T, typename Abi>
+Simd<T, Abi> popcount(Simd<T, Abi> simd) {
+  static_assert(std::is_integral<T>::value,
+                "Only integral types are supported");
+  return detail::PopcountImpl(simd, std::is_signed<T>());
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> countl_zero(Simd<T, Abi> simd) {
+  static_assert(std::is_integral<T>::value,
+                "Only integral types are supported");
+  return detail::CountlZeroImpl(simd, std::is_signed<T>());
+}
+
+// Returns the number of consecutive zero bits in each lane, starting from the
+// least significant bit. Zero lanes give sizeof(T) * CHAR_BIT.
+template <typename T, typename Abi>
+Simd<T, Abi> countr_zero(Simd<T, Abi> simd) {
+  static_assert(std::is_integral<T>::value,
+                "Only integral types are supported");
+  using Unsigned = detail::UnsignedSimd<T, Abi>;
+  auto bits = bit_cast<typename Unsigned::value_type>(simd);
+  // The ones of ~x & (x - 1) are exactly the trailing zeros of x.
+  return bit_cast<T>(popcount(~bits & (bits - Unsigned(1))));
+}
+
+// Reverses the bytes of each lane.
+template <typename T, typename Abi>
+Simd<T, Abi> byte_reverse(Simd<T, Abi> simd) {
+  static_assert(std::is_integral<T>::value,
+                "Only integral types are supported");
+  return detail::ByteReverseImpl(
+      simd, dimsum::make_index_sequence<sizeof(Simd<T, Abi>)>());
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> bit_reverse(Simd<T, Abi> simd) {
+  static_assert(std::is_integral<T>::value,
+                "Only integral types are supported");
+  return detail::BitReverseImpl(simd, std::is_same<T, uint8>());
+}
+
+namespace detail {
+
+template <typename T, typename Abi>
+Simd<T, Abi> BitReverseImpl(Simd<T, Abi> simd, std::false_type /* uint8 */) {
+  return bit_cast<T>(bit_reverse(bit_cast<uint8>(byte_reverse(simd))));
+}
+
+}  // namespace detail
+
 }  // namespace dimsum
 
 #endif  // DIMSUM_SIMD_H_
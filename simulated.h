@@ -17,8 +17,10 @@
 #ifndef DIMSUM_SIMULATED_H_
 #define DIMSUM_SIMULATED_H_
 
+#include <algorithm>
 #include <array>
 #include <cmath>
+#include <complex>
 #include <limits>
 
 #include "simd.h"
@@ -82,6 +84,29 @@ T SaturatedSub(T lhs, T rhs) {
       return lhs - rhs;
   }
 }
+
+template <typename T>
+T MulHiScalar(T lhs, T rhs) {
+  return static_cast<T>(static_cast<ScaleBy<T, 2>>(lhs) *
+                            static_cast<ScaleBy<T, 2>>(rhs) >>
+                        (8 * sizeof(T)));
+}
+
+// Long multiplication of the 32-bit halves, as there is no wider type.
+inline uint64 MulHiScalar(uint64 lhs, uint64 rhs) {
+  const uint64 lhs_lo = lhs & 0xffffffff, lhs_hi = lhs >> 32;
+  const uint64 rhs_lo = rhs & 0xffffffff, rhs_hi = rhs >> 32;
+  const uint64 cross = lhs_hi * rhs_lo + (lhs_lo * rhs_lo >> 32);
+  const uint64 middle = (cross & 0xffffffff) + lhs_lo * rhs_hi;
+  return lhs_hi * rhs_hi + (cross >> 32) + (middle >> 32);
+}
+
+inline int64 MulHiScalar(int64 lhs, int64 rhs) {
+  uint64 hi = MulHiScalar(static_cast<uint64>(lhs), static_cast<uint64>(rhs));
+  if (lhs < 0) hi -= static_cast<uint64>(rhs);
+  if (rhs < 0) hi -= static_cast<uint64>(lhs);
+  return static_cast<int64>(hi);
+}
 }  // namespace detail
 
 namespace simulated {
@@ -105,6 +130,123 @@ Simd<T, Abi> shuffle(Simd<T, Abi> lhs, Simd<T, Abi> rhs = {}) {
   return Simd<T, Abi>(a, flags::element_aligned);
 }
 
+template <typename T, typename Abi>
+Simd<T, Abi> zip_lo(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
+  Simd<T, Abi> ret;
+  for (int i = 0; i < ret.size(); i++) {
+    ret.set(i, i % 2 == 0 ? lhs[i / 2] : rhs[i / 2]);
+  }
+  return ret;
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> zip_hi(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
+  Simd<T, Abi> ret;
+  for (int i = 0; i < ret.size(); i++) {
+    int index = ret.size() / 2 + i / 2;
+    ret.set(i, i % 2 == 0 ? lhs[index] : rhs[index]);
+  }
+  return ret;
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> unzip_even(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
+  Simd<T, Abi> ret;
+  for (int i = 0; i < ret.size(); i++) {
+    int index = 2 * i;
+    ret.set(i, index < ret.size() ? lhs[index] : rhs[index - ret.size()]);
+  }
+  return ret;
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> unzip_odd(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
+  Simd<T, Abi> ret;
+  for (int i = 0; i < ret.size(); i++) {
+    int index = 2 * i + 1;
+    ret.set(i, index < ret.size() ? lhs[index] : rhs[index - ret.size()]);
+  }
+  return ret;
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> select(
+    Simd<typename Simd<T, Abi>::ComparisonResultType, Abi> mask,
+    Simd<T, Abi> if_true, Simd<T, Abi> if_false) {
+  Simd<T, Abi> ret;
+  for (int i = 0; i < ret.size(); i++) {
+    ret.set(i, mask[i] ? if_true[i] : if_false[i]);
+  }
+  return ret;
+}
+
+template <size_t... kBits, typename T, typename Abi>
+Simd<T, Abi> blend(Simd<T, Abi> if_true, Simd<T, Abi> if_false) {
+  Simd<T, Abi> ret;
+  int i = 0;
+  for (auto bit : {kBits...}) {
+    ret.set(i, bit ? if_true[i] : if_false[i]);
+    i++;
+  }
+  return ret;
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> complex_mul(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
+  Simd<T, Abi> ret;
+  for (int i = 0; i < ret.size(); i += 2) {
+    std::complex<T> product = std::complex<T>(lhs[i], lhs[i + 1]) *
+                              std::complex<T>(rhs[i], rhs[i + 1]);
+    ret.set(i, product.real());
+    ret.set(i + 1, product.imag());
+  }
+  return ret;
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> complex_conj_mul(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
+  Simd<T, Abi> ret;
+  for (int i = 0; i < ret.size(); i += 2) {
+    std::complex<T> product = std::complex<T>(lhs[i], lhs[i + 1]) *
+                              std::conj(std::complex<T>(rhs[i], rhs[i + 1]));
+    ret.set(i, product.real());
+    ret.set(i + 1, product.imag());
+  }
+  return ret;
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> complex_abs2(Simd<T, Abi> simd) {
+  Simd<T, Abi> ret;
+  for (int i = 0; i < ret.size(); i += 2) {
+    T abs2 = std::norm(std::complex<T>(simd[i], simd[i + 1]));
+    ret.set(i, abs2);
+    ret.set(i + 1, abs2);
+  }
+  return ret;
+}
+
+template <size_t kN, typename SimdType>
+std::array<SimdType, kN> load_interleaved(
+    const typename SimdType::value_type* ptr) {
+  std::array<SimdType, kN> ret;
+  for (size_t c = 0; c < kN; c++) {
+    for (size_t i = 0; i < SimdType::size(); i++) {
+      ret[c].set(i, ptr[kN * i + c]);
+    }
+  }
+  return ret;
+}
+
+template <size_t kN, typename T, typename Abi>
+void store_interleaved(T* ptr, std::array<Simd<T, Abi>, kN> simds) {
+  for (size_t c = 0; c < kN; c++) {
+    for (size_t i = 0; i < Simd<T, Abi>::size(); i++) {
+      ptr[kN * i + c] = simds[c][i];
+    }
+  }
+}
+
 template <typename T, typename Abi>
 Simd<detail::Number<sizeof(T) / 2, detail::NumberKind::kSInt>, Abi>
 pack_saturated(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
@@ -213,12 +355,42 @@ Simd<Dest, Abi> round_to_integer(Simd<T, Abi> simd) {
 }
 
 template <typename Dest, typename T, typename Abi>
-Simd<Dest, Abi> static_simd_cast(Simd<T, Abi> simd) {
+ChangeElemTo<Simd<T, Abi>, Dest> static_simd_cast(Simd<T, Abi> simd) {
   Dest a[simd.size()];
   for (int i = 0; i < simd.size(); i++) {
     a[i] = static_cast<Dest>(simd[i]);
   }
-  return Simd<Dest, Abi>(a, flags::element_aligned);
+  return ChangeElemTo<Simd<T, Abi>, Dest>(a, flags::element_aligned);
+}
+
+template <typename Dest, typename T>
+Dest SaturatedCast(T value) {
+  constexpr Dest kMin = std::numeric_limits<Dest>::min();
+  constexpr Dest kMax = std::numeric_limits<Dest>::max();
+  if (std::is_floating_point<T>::value) {
+    if (std::isnan(value)) return 0;
+    if (value <= static_cast<T>(kMin)) return kMin;
+    if (value >= static_cast<T>(kMax)) return kMax;
+    return static_cast<Dest>(value);
+  }
+  if (value < 0) {
+    return std::is_unsigned<Dest>::value ||
+                   static_cast<int64>(value) < static_cast<int64>(kMin)
+               ? kMin
+               : static_cast<Dest>(value);
+  }
+  return static_cast<uint64>(value) > static_cast<uint64>(kMax)
+             ? kMax
+             : static_cast<Dest>(value);
+}
+
+template <typename Dest, typename T, typename Abi>
+ChangeElemTo<Simd<T, Abi>, Dest> saturated_simd_cast(Simd<T, Abi> simd) {
+  Dest a[simd.size()];
+  for (int i = 0; i < simd.size(); i++) {
+    a[i] = SaturatedCast<Dest>(simd[i]);
+  }
+  return ChangeElemTo<Simd<T, Abi>, Dest>(a, flags::element_aligned);
 }
 
 template <typename T, typename Abi>
@@ -266,6 +438,17 @@ Simd<T, Abi> mul(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
   return Simd<T, Abi>(a, flags::element_aligned);
 }
 
+// The fused reference: floating point lanes are rounded once.
+template <typename T, typename Abi>
+Simd<T, Abi> fma(Simd<T, Abi> lhs, Simd<T, Abi> rhs, Simd<T, Abi> acc) {
+  T a[lhs.size()];
+  for (size_t i = 0; i < lhs.size(); i++) {
+    a[i] = std::is_floating_point<T>::value ? std::fma(lhs[i], rhs[i], acc[i])
+                                            : lhs[i] * rhs[i] + acc[i];
+  }
+  return Simd<T, Abi>(a, flags::element_aligned);
+}
+
 template <typename T, typename Abi>
 Simd<T, Abi> shl_simd(Simd<T, Abi> simd, Simd<T, Abi> count) {
   T a[simd.size()];
@@ -302,6 +485,35 @@ Simd<T, Abi> shr(Simd<T, Abi> simd, int count) {
   return Simd<T, Abi>(a, flags::element_aligned);
 }
 
+template <typename T, typename Abi>
+Simd<T, Abi> rotl_simd(Simd<T, Abi> simd, Simd<T, Abi> count) {
+  using Bits = typename std::make_unsigned<T>::type;
+  constexpr int kBits = 8 * sizeof(T);
+  T a[simd.size()];
+  for (size_t i = 0; i < simd.size(); i++) {
+    Bits bits = static_cast<Bits>(simd[i]);
+    int n = count[i] & (kBits - 1);
+    a[i] = static_cast<T>(n ? static_cast<Bits>(bits << n | bits >> (kBits - n))
+                            : bits);
+  }
+  return Simd<T, Abi>(a, flags::element_aligned);
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> rotr_simd(Simd<T, Abi> simd, Simd<T, Abi> count) {
+  return simulated::rotl_simd(simd, Simd<T, Abi>(0) - count);
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> rotl(Simd<T, Abi> simd, int count) {
+  return simulated::rotl_simd(simd, Simd<T, Abi>(count));
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> rotr(Simd<T, Abi> simd, int count) {
+  return simulated::rotr_simd(simd, Simd<T, Abi>(count));
+}
+
 template <typename T, typename Abi>
 Simd<T, Abi> bit_and(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
   T a[lhs.size()];
@@ -450,6 +662,56 @@ ResizeBy<ScaleElemBy<Simd<T, Abi>, 2>, 1, 2> mul_sum(
   return ret;
 }
 
+// Models detail::DotProductKindOf<Abi>(): with kSaturatedPairs, adjacent
+// products are summed with int16 saturation as pmaddubsw does, and
+// dot_s8s8_i32 multiplies abs(lhs) by rhs negated for negative lhs, which
+// wraps for rhs = -128, as psignb does.
+template <typename Abi>
+Simd<int32, Abi> dot_u8s8_i32(Simd<int32, Abi> acc, Simd<uint8, Abi> lhs,
+                              Simd<int8, Abi> rhs) {
+  constexpr bool kSaturatedPairs = detail::DotProductKindOf<Abi>() ==
+                                   detail::DotProductKind::kSaturatedPairs;
+  Simd<int32, Abi> ret;
+  for (size_t i = 0; i < acc.size(); i++) {
+    uint32 sum = acc[i];
+    for (size_t j = 4 * i; j < 4 * i + 4; j += 2) {
+      int32 pair = int32{lhs[j]} * rhs[j] + int32{lhs[j + 1]} * rhs[j + 1];
+      if (kSaturatedPairs) {
+        pair = std::min(std::max(pair, -32768), 32767);
+      }
+      sum += pair;
+    }
+    ret.set(i, sum);
+  }
+  return ret;
+}
+
+template <typename Abi>
+Simd<int32, Abi> dot_s8s8_i32(Simd<int32, Abi> acc, Simd<int8, Abi> lhs,
+                              Simd<int8, Abi> rhs) {
+  constexpr bool kSaturatedPairs = detail::DotProductKindOf<Abi>() ==
+                                   detail::DotProductKind::kSaturatedPairs;
+  if (!kSaturatedPairs) {
+    Simd<int32, Abi> ret;
+    for (size_t i = 0; i < acc.size(); i++) {
+      uint32 sum = acc[i];
+      for (size_t j = 4 * i; j < 4 * i + 4; j++) {
+        sum += int32{lhs[j]} * rhs[j];
+      }
+      ret.set(i, sum);
+    }
+    return ret;
+  }
+  Simd<uint8, Abi> abs_lhs;
+  Simd<int8, Abi> signed_rhs;
+  for (size_t i = 0; i < lhs.size(); i++) {
+    abs_lhs.set(i, lhs[i] < 0 ? -lhs[i] : lhs[i]);
+    signed_rhs.set(i, lhs[i] < 0 ? static_cast<int8>(-rhs[i])
+                                 : lhs[i] == 0 ? 0 : rhs[i]);
+  }
+  return simulated::dot_u8s8_i32(acc, abs_lhs, signed_rhs);
+}
+
 template <typename Abi>
 Simd<int16, Abi> maddubs(Simd<uint8, Abi> lhs, Simd<int8, Abi> rhs) {
   int16 a[lhs.size() / 2];
@@ -471,6 +733,46 @@ ScaleElemBy<Simd<T, Abi>, 2> mul_widened(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
   return ret;
 }
 
+template <typename T, typename Abi>
+Simd<T, Abi> avg_round(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
+  T a[lhs.size()];
+  for (size_t i = 0; i < lhs.size(); i++) {
+    a[i] = static_cast<T>((lhs[i] >> 1) + (rhs[i] >> 1) +
+                          ((lhs[i] | rhs[i]) & 1));
+  }
+  return Simd<T, Abi>(a, flags::element_aligned);
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> mul_hi(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
+  T a[lhs.size()];
+  for (size_t i = 0; i < lhs.size(); i++) {
+    a[i] = detail::MulHiScalar(lhs[i], rhs[i]);
+  }
+  return Simd<T, Abi>(a, flags::element_aligned);
+}
+
+// -32768 * -32768 wraps around to -32768, as on x86.
+template <typename Abi>
+Simd<int16, Abi> mul_hi_round(Simd<int16, Abi> lhs, Simd<int16, Abi> rhs) {
+  int16 a[lhs.size()];
+  for (size_t i = 0; i < lhs.size(); i++) {
+    a[i] = static_cast<int16>((int32{lhs[i]} * rhs[i] + 0x4000) >> 15);
+  }
+  return Simd<int16, Abi>(a, flags::element_aligned);
+}
+
+template <typename Abi>
+Simd<uint8, Abi> blend_u8(Simd<uint8, Abi> src, Simd<uint8, Abi> dst,
+                          Simd<uint8, Abi> alpha) {
+  uint8 a[src.size()];
+  for (size_t i = 0; i < src.size(); i++) {
+    a[i] = static_cast<uint8>(
+        (src[i] * alpha[i] + dst[i] * (255 - alpha[i]) + 127) / 255);
+  }
+  return Simd<uint8, Abi>(a, flags::element_aligned);
+}
+
 template <typename T, typename Abi>
 Simd<T, Abi> max(Simd<T, Abi> lhs, Simd<T, Abi> rhs) {
   T a[lhs.size()];
@@ -503,6 +805,116 @@ int movemask(Simd<T, Abi> simd) {
   return res;
 }
 
+template <typename T, typename Abi>
+Simd<T, Abi> popcount(Simd<T, Abi> simd) {
+  using Unsigned = typename std::make_unsigned<T>::type;
+  std::array<T, Simd<T, Abi>::size()> a;
+  for (size_t i = 0; i < simd.size(); i++) {
+    a[i] = __builtin_popcountll(static_cast<Unsigned>(simd[i]));
+  }
+  return Simd<T, Abi>(a.data(), flags::element_aligned);
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> countl_zero(Simd<T, Abi> simd) {
+  using Unsigned = typename std::make_unsigned<T>::type;
+  constexpr int kBits = sizeof(T) * CHAR_BIT;
+  std::array<T, Simd<T, Abi>::size()> a;
+  for (size_t i = 0; i < simd.size(); i++) {
+    Unsigned x = simd[i];
+    a[i] = x == 0 ? kBits : __builtin_clzll(x) - (64 - kBits);
+  }
+  return Simd<T, Abi>(a.data(), flags::element_aligned);
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> countr_zero(Simd<T, Abi> simd) {
+  using Unsigned = typename std::make_unsigned<T>::type;
+  constexpr int kBits = sizeof(T) * CHAR_BIT;
+  std::array<T, Simd<T, Abi>::size()> a;
+  for (size_t i = 0; i < simd.size(); i++) {
+    Unsigned x = simd[i];
+    a[i] = x == 0 ? kBits : __builtin_ctzll(x);
+  }
+  return Simd<T, Abi>(a.data(), flags::element_aligned);
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> byte_reverse(Simd<T, Abi> simd) {
+  using Unsigned = typename std::make_unsigned<T>::type;
+  std::array<T, Simd<T, Abi>::size()> a;
+  for (size_t i = 0; i < simd.size(); i++) {
+    Unsigned x = simd[i];
+    Unsigned res = 0;
+    for (size_t j = 0; j < sizeof(T); j++) {
+      res = (res << CHAR_BIT) | ((x >> (j * CHAR_BIT)) & 0xff);
+    }
+    a[i] = res;
+  }
+  return Simd<T, Abi>(a.data(), flags::element_aligned);
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> bit_reverse(Simd<T, Abi> simd) {
+  using Unsigned = typename std::make_unsigned<T>::type;
+  std::array<T, Simd<T, Abi>::size()> a;
+  for (size_t i = 0; i < simd.size(); i++) {
+    Unsigned x = simd[i];
+    Unsigned res = 0;
+    for (size_t j = 0; j < sizeof(T) * CHAR_BIT; j++) {
+      res = (res << 1) | ((x >> j) & 1);
+    }
+    a[i] = res;
+  }
+  return Simd<T, Abi>(a.data(), flags::element_aligned);
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> compress(
+    Simd<T, Abi> simd,
+    Simd<typename Simd<T, Abi>::ComparisonResultType, Abi> mask) {
+  using Bits = typename Simd<T, Abi>::ComparisonResultType;
+  std::array<T, Simd<T, Abi>::size()> a;
+  size_t count = 0;
+  for (bool selected : {true, false}) {
+    for (size_t i = 0; i < simd.size(); i++) {
+      if ((mask[i] >> (sizeof(Bits) * CHAR_BIT - 1) != 0) == selected) {
+        a[count++] = simd[i];
+      }
+    }
+  }
+  return Simd<T, Abi>(a.data(), flags::element_aligned);
+}
+
+template <typename T, typename Abi>
+Simd<T, Abi> expand(
+    Simd<T, Abi> simd,
+    Simd<typename Simd<T, Abi>::ComparisonResultType, Abi> mask) {
+  using Bits = typename Simd<T, Abi>::ComparisonResultType;
+  std::array<T, Simd<T, Abi>::size()> a{};
+  size_t count = 0;
+  for (size_t i = 0; i < simd.size(); i++) {
+    if (mask[i] >> (sizeof(Bits) * CHAR_BIT - 1)) {
+      a[i] = simd[count++];
+    }
+  }
+  return Simd<T, Abi>(a.data(), flags::element_aligned);
+}
+
+template <typename T, typename Abi>
+size_t compress_store(
+    T* ptr, Simd<T, Abi> simd,
+    Simd<typename Simd<T, Abi>::ComparisonResultType, Abi> mask) {
+  using Bits = typename Simd<T, Abi>::ComparisonResultType;
+  size_t count = 0;
+  for (size_t i = 0; i < simd.size(); i++) {
+    if (mask[i] >> (sizeof(Bits) * CHAR_BIT - 1)) {
+      ptr[count++] = simd[i];
+    }
+  }
+  return count;
+}
+
 }  // namespace simulated
 }  // namespace dimsum
 